@@ -169,6 +169,34 @@ uint8_t ble_sleep(uint16_t twosc, uint32_t dur_max);
  */
 uint32_t ble_time_get(void);
 
+/// Half-slot time of ble_time_get() in 28 bits, wrapped each ~23 hours
+#define BLE_TIME_MASK               (0x0FFFFFFFUL)
+/// Half-slots elapsed from 'old' to 'now', both got by ble_time_get()
+#define BLE_TIME_DIFF(now, old)     (((now) - (old)) & BLE_TIME_MASK)
+
+/// Convert between half-slot and 1ms(16 half-slots exactly 5ms), or 1.25ms(connection interval)
+#define BLE_MS2HS(ms)               ((uint32_t)(ms) * 16 / 5)
+#define BLE_HS2MS(hs)               (((uint32_t)(hs) * 5) >> 4)
+#define BLE_INTV2HS(intv)           ((uint32_t)(intv) * 4)
+
+/**
+ ****************************************************************************************
+ * @brief Fold half-slots accumulated into whole units, remainder kept for next fold.
+ *
+ * @param[in,out] hs    Half-slots accumulated, left with remainder
+ * @param[in]     unit  Half-slots of one unit, eg. 16 for 5ms, BLE_INTV2HS(intv) for events
+ *
+ * @return Number of whole units
+ ****************************************************************************************
+ */
+__STATIC_INLINE uint32_t ble_time_fold(uint32_t *hs, uint32_t unit)
+{
+    uint32_t nb = *hs / unit;
+
+    *hs -= nb * unit;
+    return nb;
+}
+
 /**
  ****************************************************************************************
  * @brief Get max sleep time when BLE is idle state.
@@ -13,6 +13,9 @@
 #include "bledef.h"
 #include "drvs.h"
 #include "prf_api.h"
+#include "app_l2cc.h"
+#include "app_heap.h"
+#include "app_rpa.h"
 
 #if (DBG_APP)
 #include "dbg.h"
@@ -273,6 +276,10 @@ __WEAK void app_init(uint16_t rsn)
         heap.size[MEM_MSG] = BLE_HEAP_MSG_SIZE;
         ble_heap(&heap);
 
+        #if (HEAP_STAT)
+        heap_stat_init(&heap);
+        #endif
+
         // Init BLE and App
         ble_init();
         ble_app();
@@ -385,6 +392,16 @@ __WEAK void app_conf_fsm(uint8_t evt)
         // Create Profiles
         app_prf_create();
 
+        #if (L2CC_LECB)
+        // Register LE_PSM of Credit Based Channel
+        lecb_init();
+        #endif //(L2CC_LECB)
+
+        #if (RPA_CACHE)
+        // Identities of bonded peers, before scanning
+        rpa_irk_load();
+        #endif //(RPA_CACHE)
+
         #if (APP_ACTV_EN)
         // Create Activities
         app_actv_create();
@@ -11,6 +11,9 @@
 
 #include "app.h"
 #include "gapm_api.h"
+#include "app_scan.h"
+#include "app_rpa.h"
+#include "app_advs.h"
 
 #if (DBG_ACTV)
 #include "dbg.h"
@@ -140,41 +143,14 @@ struct actv_env_tag actv_env;
  ****************************************************************************************
  */
 
-static void app_adv_create(void)
-{
-    struct gapm_adv_create_param adv_param;
-
-    // Advertising type (@see enum gapm_adv_type)
-    adv_param.type                  = GAPM_ADV_TYPE_LEGACY;
-    // Discovery mode (@see enum gapm_adv_disc_mode)
-    adv_param.disc_mode             = GAPM_ADV_MODE_GEN_DISC;
-    // Advertising properties (@see enum gapm_adv_prop)
-    #if (DBG_GAPM)
-    adv_param.prop                  = GAPM_ADV_PROP_UNDIR_CONN_MASK | GAPM_ADV_PROP_SCAN_REQ_NTF_EN_BIT;
-    #else
-    adv_param.prop                  = GAPM_ADV_PROP_UNDIR_CONN_MASK;
-    #endif
-    // Filtering policy (@see enum gapm_adv_filter_policy)
-    adv_param.filter_pol            = GAPM_ADV_ALLOW_SCAN_ANY_CON_ANY;
-    // Config primary advertising (@see gapm_adv_prim_cfg)
-    adv_param.prim_cfg.phy          = GAP_PHY_LE_1MBPS;
-    adv_param.prim_cfg.chnl_map     = APP_ADV_CHMAP;
-    adv_param.prim_cfg.adv_intv_min = APP_ADV_INT_MIN;
-    adv_param.prim_cfg.adv_intv_max = APP_ADV_INT_MAX;
-
-    DEBUG("create(disc:%d,prop:%d)\r\n", adv_param.disc_mode, adv_param.prop);
-
-    gapm_create_advertising(GAPM_STATIC_ADDR, &adv_param);
-}
-
-static void app_adv_set_adv_data(void)
+/// Build advertising data, return length
+static uint8_t app_adv_data_build(uint8_t *adv_data)
 {
 #if (APP_ADV_FIXED_DATA)
-    gapm_set_adv_data(actv_env.advidx, GAPM_SET_ADV_DATA,
-                        APP_ADV_DATA_LEN, (const uint8_t *)APP_ADV_DATA);
+    memcpy(adv_data, APP_ADV_DATA, APP_ADV_DATA_LEN);
+    return APP_ADV_DATA_LEN;
 #else
     // Reserve 3Bytes for AD_TYPE_FLAGS
-    uint8_t adv_data[GAP_ADV_DATA_LEN];
     uint8_t length = 11;
 
     // Set flags: 3B
@@ -197,28 +173,155 @@ static void app_adv_set_adv_data(void)
     adv_data[8] = GAP_AD_TYPE_APPEARANCE; // 0x19
     write16p(&adv_data[9], icon);
 
-    gapm_set_adv_data(actv_env.advidx, GAPM_SET_ADV_DATA, length, adv_data);
+    return length;
 #endif
 }
 
-static void app_adv_set_scan_rsp(void)
+/// Build scan response data, return length
+static uint8_t app_adv_rsp_build(uint8_t *rsp_data)
 {
 #if (APP_ADV_FIXED_DATA)
-    gapm_set_adv_data(actv_env.advidx, GAPM_SET_SCAN_RSP_DATA,
-                        APP_SCNRSP_DATA_LEN, (const uint8_t *)APP_SCNRSP_DATA);
+    memcpy(rsp_data, APP_SCNRSP_DATA, APP_SCNRSP_DATA_LEN);
+    return APP_SCNRSP_DATA_LEN;
 #else
     uint8_t length;
-    uint8_t rsp_data[DEV_NAME_MAX_LEN+2];
 
     // Set device name
     length = app_name_get(DEV_NAME_MAX_LEN, &rsp_data[2]);
     rsp_data[0] = length + 1;
     rsp_data[1] = GAP_AD_TYPE_COMPLETE_NAME; // 0x09
 
-    gapm_set_adv_data(actv_env.advidx, GAPM_SET_SCAN_RSP_DATA, length + 2, rsp_data);
+    return length + 2;
 #endif
 }
 
+#if (APP_ADV_SCH)
+static uint8_t app_adv_data_gen(uint8_t set, uint8_t *data, uint8_t max)
+{
+    (void)set;(void)max;
+    return app_adv_data_build(data);
+}
+
+static uint8_t app_adv_rsp_gen(uint8_t set, uint8_t *data, uint8_t max)
+{
+    (void)set;(void)max;
+    return app_adv_rsp_build(data);
+}
+
+/// Set of app, payload rebuilt on ACTV_RELOAD
+static const struct advs_cfg app_adv_cfg =
+{
+    #if (DBG_GAPM)
+    .prop      = GAPM_ADV_PROP_UNDIR_CONN_MASK | GAPM_ADV_PROP_SCAN_REQ_NTF_EN_BIT,
+    #else
+    .prop      = GAPM_ADV_PROP_UNDIR_CONN_MASK,
+    #endif
+    .disc_mode = GAPM_ADV_MODE_GEN_DISC,
+    .chmap     = APP_ADV_CHMAP,
+    .intv_min  = APP_ADV_INT_MIN,
+    .intv_max  = APP_ADV_INT_MAX,
+    .on_time   = APP_ADV_DURATION,
+    .period    = 0,
+    .rotate    = 0,
+    .adv_gen   = app_adv_data_gen,
+    .rsp_gen   = app_adv_rsp_gen,
+};
+
+/**
+ ****************************************************************************************
+ * @brief Action/Command of Advertising, set of app in scheduler
+ *
+ * @param[in] actv_op  Operation of activity
+ ****************************************************************************************
+ */
+void app_adv_action(uint8_t actv_op)
+{
+    switch (actv_op)
+    {
+        case ACTV_CREATE:
+        {
+            if (actv_env.advsta == ACTV_STATE_OFF)
+            {
+                // index of set in scheduler
+                actv_env.advidx = advs_add(&app_adv_cfg, true);
+                actv_env.advsta = ACTV_STATE_READY;
+                app_state_set(APP_READY);
+            }
+        } break;
+
+        case ACTV_START:
+        {
+            advs_start(actv_env.advidx);
+        } break;
+
+        case ACTV_STOP:
+        {
+            advs_stop(actv_env.advidx);
+        } break;
+
+        case ACTV_DELETE:
+        {
+            if (actv_env.advsta != ACTV_STATE_OFF)
+            {
+                advs_del(actv_env.advidx);
+                actv_env.advsta = ACTV_STATE_OFF;
+            }
+        } break;
+
+        case ACTV_RELOAD:
+        {
+            // payload updated while advertising, no stop and create again
+            advs_update(actv_env.advidx);
+        } break;
+
+        default:
+            break;
+    }
+}
+#else //!(APP_ADV_SCH)
+static void app_adv_create(void)
+{
+    struct gapm_adv_create_param adv_param;
+
+    // Advertising type (@see enum gapm_adv_type)
+    adv_param.type                  = GAPM_ADV_TYPE_LEGACY;
+    // Discovery mode (@see enum gapm_adv_disc_mode)
+    adv_param.disc_mode             = GAPM_ADV_MODE_GEN_DISC;
+    // Advertising properties (@see enum gapm_adv_prop)
+    #if (DBG_GAPM)
+    adv_param.prop                  = GAPM_ADV_PROP_UNDIR_CONN_MASK | GAPM_ADV_PROP_SCAN_REQ_NTF_EN_BIT;
+    #else
+    adv_param.prop                  = GAPM_ADV_PROP_UNDIR_CONN_MASK;
+    #endif
+    // Filtering policy (@see enum gapm_adv_filter_policy)
+    adv_param.filter_pol            = GAPM_ADV_ALLOW_SCAN_ANY_CON_ANY;
+    // Config primary advertising (@see gapm_adv_prim_cfg)
+    adv_param.prim_cfg.phy          = GAP_PHY_LE_1MBPS;
+    adv_param.prim_cfg.chnl_map     = APP_ADV_CHMAP;
+    adv_param.prim_cfg.adv_intv_min = APP_ADV_INT_MIN;
+    adv_param.prim_cfg.adv_intv_max = APP_ADV_INT_MAX;
+
+    DEBUG("create(disc:%d,prop:%d)\r\n", adv_param.disc_mode, adv_param.prop);
+
+    gapm_create_advertising(GAPM_STATIC_ADDR, &adv_param);
+}
+
+static void app_adv_set_adv_data(void)
+{
+    uint8_t adv_data[GAP_ADV_DATA_LEN];
+    uint8_t length = app_adv_data_build(adv_data);
+
+    gapm_set_adv_data(actv_env.advidx, GAPM_SET_ADV_DATA, length, adv_data);
+}
+
+static void app_adv_set_scan_rsp(void)
+{
+    uint8_t rsp_data[GAP_ADV_DATA_LEN];
+    uint8_t length = app_adv_rsp_build(rsp_data);
+
+    gapm_set_adv_data(actv_env.advidx, GAPM_SET_SCAN_RSP_DATA, length, rsp_data);
+}
+
 /**
  ****************************************************************************************
  * @brief Action/Command of Advertising
@@ -342,6 +445,7 @@ void app_adv_event(uint8_t gapm_op, uint8_t status)
             break;
     }
 }
+#endif //(APP_ADV_SCH)
 
 #endif //(BLE_EN_ADV)
 
@@ -366,6 +470,19 @@ void app_adv_event(uint8_t gapm_op, uint8_t status)
 uint8_t scan_cnt = 0;
 struct gap_bdaddr scan_addr_list[SCAN_NUM_MAX];
 
+#if (APP_SCAN_FILT)
+/// Rules of filter, same as legacy: HID Keyboard/Gamepad icon, or 16-bit UUID 0x18F0/0xFF00
+static const struct scan_filt scan_rules[] =
+{
+    // icon 0x03C1 or 0x03C5, bit2 ignored
+    { GAP_AD_TYPE_APPEARANCE,                0,              2, -127, {0xC1, 0x03}, {0xFB, 0xFF}, 0, NULL },
+    { GAP_AD_TYPE_COMPLETE_LIST_16_BIT_UUID, SCAN_FILT_LIST, 2, -127, {0xF0, 0x18}, {0xFF, 0xFF}, 0, NULL },
+    { GAP_AD_TYPE_MORE_16_BIT_UUID,          SCAN_FILT_LIST, 2, -127, {0xF0, 0x18}, {0xFF, 0xFF}, 0, NULL },
+    { GAP_AD_TYPE_COMPLETE_LIST_16_BIT_UUID, SCAN_FILT_LIST, 2, -127, {0x00, 0xFF}, {0xFF, 0xFF}, 0, NULL },
+    { GAP_AD_TYPE_MORE_16_BIT_UUID,          SCAN_FILT_LIST, 2, -127, {0x00, 0xFF}, {0xFF, 0xFF}, 0, NULL },
+};
+#endif //(APP_SCAN_FILT)
+
 
 /*
  * FUNCTION DEFINITIONS
@@ -414,6 +531,9 @@ void app_scan_action(uint8_t actv_op)
             if (actv_env.scansta == ACTV_STATE_OFF)
             {
                 DEBUG("Creating");
+                #if (APP_SCAN_FILT)
+                scan_filt_conf(scan_rules, sizeof(scan_rules) / sizeof(scan_rules[0]));
+                #endif
                 gapm_create_activity(GAPM_ACTV_TYPE_SCAN, GAPM_STATIC_ADDR);
                 actv_env.scansta = ACTV_STATE_CREATE;
             }
@@ -422,6 +542,9 @@ void app_scan_action(uint8_t actv_op)
         case ACTV_START:
         {
             scan_cnt = 0;
+            #if (APP_SCAN_FILT)
+            scan_dup_clear();
+            #endif
 
             if (actv_env.scansta == ACTV_STATE_READY)
             {
@@ -549,9 +672,33 @@ void app_scan_result(const struct gap_bdaddr* paddr)
  */
 void app_actv_report_ind(struct gapm_ext_adv_report_ind const* report)
 {
+    #if (RPA_CACHE)
+    // identity of bonded peer, RPA resolved once and cached
+    int8_t id = rpa_resolve(&report->trans_addr);
+
+    if (id >= 0)
+    {
+        DEBUG("Bonded(id:%d)", id);
+        app_scan_result(&report->trans_addr);
+        return;
+    }
+
+    // in resolution, advertised again soon; or not bonded
+    if ((id == RPA_PEND) || (RPA_BOND_ONLY))
+    {
+        return;
+    }
+    #endif //(RPA_CACHE)
+
     // filter report
     if ((report->info & GAPM_REPORT_INFO_REPORT_TYPE_MASK) == GAPM_REPORT_TYPE_ADV_LEG)
     {
+        #if (APP_SCAN_FILT)
+        if (scan_filt_match(report) != SCAN_FILT_NONE)
+        {
+            app_scan_result(&report->trans_addr);
+        }
+        #else
         const uint8_t *p_cursor = report->data;
         const uint8_t *p_end_cusor = report->data + report->length;
 
@@ -590,6 +737,7 @@ void app_actv_report_ind(struct gapm_ext_adv_report_ind const* report)
             /* Go to next advertising info */
             p_cursor += (*p_cursor + 1);
         }
+        #endif //(APP_SCAN_FILT)
     }
 }
 #endif //(BLE_EN_SCAN)
@@ -803,6 +951,10 @@ void app_init_event(uint8_t gapm_op, uint8_t status)
 void app_actv_create(void)
 {
     memset(&actv_env, 0, sizeof(actv_env));
+    #if (APP_ADV_SCH)
+    advs_init();
+    #endif //(APP_ADV_SCH)
+
     #if (BLE_EN_ADV)
     app_adv_action(ACTV_CREATE);
     #endif //(BLE_EN_ADV)
@@ -828,7 +980,14 @@ void app_actv_cmp_evt(uint8_t operation, uint8_t status)
 {
     switch (operation)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case (GAPM_CREATE_ADV_ACTIVITY):
+        case (GAPM_SET_ADV_DATA):
+        case (GAPM_SET_SCAN_RSP_DATA):
+        {
+            advs_cmp_evt(operation, status);
+        } break;
+        #elif (BLE_EN_ADV)
         case (GAPM_CREATE_ADV_ACTIVITY):
         case (GAPM_SET_ADV_DATA):
         case (GAPM_SET_SCAN_RSP_DATA):
@@ -868,7 +1027,12 @@ void app_actv_created_ind(uint8_t actv_type, uint8_t actv_idx)
 {
     switch (actv_type)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case GAPM_ACTV_TYPE_ADV:
+        {
+            advs_created_ind(actv_idx);
+        } break;
+        #elif (BLE_EN_ADV)
         case GAPM_ACTV_TYPE_ADV:
         {
             actv_env.advidx = actv_idx;
@@ -907,7 +1071,23 @@ void app_actv_stopped_ind(uint8_t actv_type, uint8_t actv_idx, uint8_t reason)
     (void)actv_idx;
     switch (actv_type)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case GAPM_ACTV_TYPE_ADV:
+        {
+            uint8_t set = advs_stopped_ind(actv_idx, reason);
+
+            #if (BLE_EN_ADV)
+            // Duration timeout of app set, go IDLE
+            if ((set == actv_env.advidx) && (actv_env.advsta != ACTV_STATE_OFF)
+                && (reason == GAP_ERR_TIMEOUT) && (app_state_get() == APP_READY))
+            {
+                app_state_set(APP_IDLE);
+            }
+            #else
+            (void)set;
+            #endif
+        } break;
+        #elif (BLE_EN_ADV)
         case GAPM_ACTV_TYPE_ADV:
         {
             // Advertising Stopped by slave connection or duration timeout
@@ -0,0 +1,440 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_advs.c
+ *
+ * @brief Advertising Scheduler - Example
+ *
+ *  Several advertising sets run at once, each own interval, payload and duty budget:
+ *    - GAPM_CMP_EVT carries no activity index, so create and data commands of all sets
+ *      sent one at a time, completion belongs to set of command in flight.
+ *    - Payload double-buffered: built into back buffer, compared with front(on air),
+ *      sent by GAPM_SET_ADV_DATA while advertising, back becomes front when completed.
+ *    - Duty budget: started with duration 'on_time', restarted after 'period' from start.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "gapm_api.h"
+#include "app_advs.h"
+
+#if (APP_ADV_SCH)
+
+#if (DBG_ADVS)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (ADVS_SET_MAX > BLE_ACTIVITY_MAX)
+#error "ADVS_SET_MAX must not exceed BLE_ACTIVITY_MAX"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// 10ms in half-slot
+#define ADVS_10MS_HS(t)       BLE_MS2HS((uint32_t)(t) * 10)
+
+/// No command in flight
+#define ADVS_OP_NONE          (0)
+
+/// Rebuild payload and scan response(may follow payload)
+#define ADVS_F_REBUILD(st)    (ADVS_F_GEN | (((st)->cfg->rsp_gen) ? ADVS_F_RSP : 0))
+
+/// State of set
+enum advs_state
+{
+    ADVS_ST_FREE,
+    // Wait to create, and created
+    ADVS_ST_INIT,
+    ADVS_ST_CREATE,
+    // Created, not advertising
+    ADVS_ST_READY,
+    // Advertising, and stopping
+    ADVS_ST_ON,
+    ADVS_ST_STOP,
+    // on_time done, wait period
+    ADVS_ST_REST,
+};
+
+/// Pending work of set
+enum advs_flag
+{
+    // Rebuild payload
+    ADVS_F_GEN     = (1 << 0),
+    // Send back buffer of adv data
+    ADVS_F_DATA    = (1 << 1),
+    // Send scan response data
+    ADVS_F_RSP     = (1 << 2),
+    // Start wanted
+    ADVS_F_EN      = (1 << 3),
+    // Delete once stopped
+    ADVS_F_DEL     = (1 << 4),
+};
+
+/// Environment of set
+struct advs_set
+{
+    const struct advs_cfg *cfg;
+    /// Payload, buf[front] on air, other one built
+    uint8_t  buf[2][GAP_ADV_DATA_LEN];
+    uint8_t  len[2];
+    uint8_t  front;
+
+    uint8_t  actv_idx;
+    uint8_t  state;
+    uint8_t  flags;
+    /// Time of last started and last rebuilt
+    uint32_t on_time;
+    uint32_t rot_time;
+};
+
+struct advs_env_tag
+{
+    struct advs_set set[ADVS_SET_MAX];
+    /// Command in flight @see enum gapm_operation, and its set
+    uint8_t op;
+    uint8_t op_set;
+};
+
+static struct advs_env_tag advs_env;
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void advs_create(struct advs_set *st)
+{
+    struct gapm_adv_create_param adv_param;
+
+    memset(&adv_param, 0, sizeof(adv_param));
+
+    adv_param.type                  = GAPM_ADV_TYPE_LEGACY;
+    adv_param.disc_mode             = st->cfg->disc_mode;
+    adv_param.prop                  = st->cfg->prop;
+    adv_param.filter_pol            = GAPM_ADV_ALLOW_SCAN_ANY_CON_ANY;
+    adv_param.prim_cfg.phy          = GAP_PHY_LE_1MBPS;
+    adv_param.prim_cfg.chnl_map     = st->cfg->chmap;
+    adv_param.prim_cfg.adv_intv_min = st->cfg->intv_min;
+    adv_param.prim_cfg.adv_intv_max = st->cfg->intv_max;
+
+    gapm_create_advertising(GAPM_STATIC_ADDR, &adv_param);
+}
+
+/// Build payload into back buffer, mark to send if not same as on air
+static void advs_gen(uint8_t set)
+{
+    struct advs_set *st = &advs_env.set[set];
+    uint8_t back = st->front ^ 1;
+
+    st->flags &= ~ADVS_F_GEN;
+    st->rot_time = ble_time_get();
+
+    if (st->cfg->adv_gen)
+    {
+        st->len[back] = st->cfg->adv_gen(set, st->buf[back], GAP_ADV_DATA_LEN);
+
+        if ((st->len[back] != st->len[st->front])
+            || (memcmp(st->buf[back], st->buf[st->front], st->len[back]) != 0))
+        {
+            st->flags |= ADVS_F_DATA;
+        }
+    }
+}
+
+/// Send next command if none in flight, start sets ready
+static void advs_next(void)
+{
+    if (advs_env.op != ADVS_OP_NONE)
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < ADVS_SET_MAX; i++)
+    {
+        struct advs_set *st = &advs_env.set[i];
+
+        if (st->state == ADVS_ST_INIT)
+        {
+            DEBUG("create(set:%d,prop:0x%X)", i, st->cfg->prop);
+            advs_create(st);
+            st->state = ADVS_ST_CREATE;
+            advs_env.op = GAPM_CREATE_ADV_ACTIVITY;
+            advs_env.op_set = i;
+            return;
+        }
+
+        if (st->state < ADVS_ST_READY)
+        {
+            continue;
+        }
+
+        if (st->flags & ADVS_F_GEN)
+        {
+            advs_gen(i);
+        }
+
+        if (st->flags & ADVS_F_DATA)
+        {
+            uint8_t back = st->front ^ 1;
+
+            st->flags &= ~ADVS_F_DATA;
+            gapm_set_adv_data(st->actv_idx, GAPM_SET_ADV_DATA, st->len[back], st->buf[back]);
+            advs_env.op = GAPM_SET_ADV_DATA;
+            advs_env.op_set = i;
+            return;
+        }
+
+        if (st->flags & ADVS_F_RSP)
+        {
+            uint8_t rsp[GAP_ADV_DATA_LEN];
+            uint8_t len = st->cfg->rsp_gen(i, rsp, GAP_ADV_DATA_LEN);
+
+            st->flags &= ~ADVS_F_RSP;
+            gapm_set_adv_data(st->actv_idx, GAPM_SET_SCAN_RSP_DATA, len, rsp);
+            advs_env.op = GAPM_SET_SCAN_RSP_DATA;
+            advs_env.op_set = i;
+            return;
+        }
+
+        if ((st->state == ADVS_ST_READY) && (st->flags & ADVS_F_EN))
+        {
+            DEBUG("start(set:%d,idx:%d,dur:%d)", i, st->actv_idx, st->cfg->on_time);
+            gapm_start_advertising(st->actv_idx, st->cfg->on_time);
+            st->state = ADVS_ST_ON;
+            st->on_time = ble_time_get();
+        }
+    }
+}
+
+void advs_init(void)
+{
+    memset(&advs_env, 0, sizeof(advs_env));
+}
+
+uint8_t advs_add(const struct advs_cfg *cfg, bool start)
+{
+    for (uint8_t i = 0; i < ADVS_SET_MAX; i++)
+    {
+        struct advs_set *st = &advs_env.set[i];
+
+        if (st->state == ADVS_ST_FREE)
+        {
+            memset(st, 0, sizeof(struct advs_set));
+            st->cfg   = cfg;
+            st->state = ADVS_ST_INIT;
+            st->flags = ADVS_F_REBUILD(st) | ((start) ? ADVS_F_EN : 0);
+
+            advs_next();
+            return i;
+        }
+    }
+
+    return ADVS_SET_INVALID;
+}
+
+void advs_start(uint8_t set)
+{
+    if ((set < ADVS_SET_MAX) && (advs_env.set[set].state != ADVS_ST_FREE))
+    {
+        advs_env.set[set].flags |= ADVS_F_EN;
+        advs_next();
+    }
+}
+
+void advs_stop(uint8_t set)
+{
+    struct advs_set *st;
+
+    if (set >= ADVS_SET_MAX)
+    {
+        return;
+    }
+
+    st = &advs_env.set[set];
+    st->flags &= ~ADVS_F_EN;
+
+    if (st->state == ADVS_ST_ON)
+    {
+        DEBUG("stop(set:%d)", set);
+        gapm_stop_activity(st->actv_idx);
+        st->state = ADVS_ST_STOP;
+    }
+    else if (st->state == ADVS_ST_REST)
+    {
+        st->state = ADVS_ST_READY;
+    }
+}
+
+void advs_del(uint8_t set)
+{
+    struct advs_set *st;
+
+    if ((set >= ADVS_SET_MAX) || (advs_env.set[set].state == ADVS_ST_FREE))
+    {
+        return;
+    }
+
+    st = &advs_env.set[set];
+    advs_stop(set);
+
+    if (st->state == ADVS_ST_INIT)
+    {
+        // not created yet
+        st->state = ADVS_ST_FREE;
+    }
+    else if ((st->state == ADVS_ST_READY) && !((advs_env.op != ADVS_OP_NONE) && (advs_env.op_set == set)))
+    {
+        DEBUG("delete(set:%d)", set);
+        gapm_delete_activity(st->actv_idx);
+        st->state = ADVS_ST_FREE;
+    }
+    else
+    {
+        // once stopped, created or data done
+        st->flags |= ADVS_F_DEL;
+    }
+}
+
+void advs_update(uint8_t set)
+{
+    if ((set < ADVS_SET_MAX) && (advs_env.set[set].state != ADVS_ST_FREE))
+    {
+        struct advs_set *st = &advs_env.set[set];
+
+        // built when no command in flight, back buffer not touched before completed
+        st->flags |= ADVS_F_REBUILD(st);
+        advs_next();
+    }
+}
+
+void advs_proc(void)
+{
+    uint32_t now = ble_time_get();
+
+    for (uint8_t i = 0; i < ADVS_SET_MAX; i++)
+    {
+        struct advs_set *st = &advs_env.set[i];
+
+        if (st->state < ADVS_ST_READY)
+        {
+            continue;
+        }
+
+        if ((st->cfg->rotate) && (BLE_TIME_DIFF(now, st->rot_time) >= ADVS_10MS_HS(st->cfg->rotate)))
+        {
+            st->rot_time = now;
+            st->flags |= ADVS_F_REBUILD(st);
+        }
+
+        if ((st->state == ADVS_ST_REST) && (BLE_TIME_DIFF(now, st->on_time) >= ADVS_10MS_HS(st->cfg->period)))
+        {
+            st->state = ADVS_ST_READY;
+        }
+    }
+
+    advs_next();
+}
+
+bool advs_cmp_evt(uint8_t operation, uint8_t status)
+{
+    struct advs_set *st;
+    uint8_t set = advs_env.op_set;
+
+    if ((advs_env.op == ADVS_OP_NONE) || (operation != advs_env.op))
+    {
+        return false;
+    }
+
+    st = &advs_env.set[set];
+    advs_env.op = ADVS_OP_NONE;
+
+    DEBUG("cmp(set:%d,op:0x%X,sta:0x%X)", set, operation, status);
+
+    if (operation == GAPM_CREATE_ADV_ACTIVITY)
+    {
+        if (status != GAP_ERR_NO_ERROR)
+        {
+            st->state = ADVS_ST_FREE;
+        }
+        else if (st->flags & ADVS_F_DEL)
+        {
+            gapm_delete_activity(st->actv_idx);
+            st->state = ADVS_ST_FREE;
+        }
+        else
+        {
+            st->state = ADVS_ST_READY;
+        }
+    }
+    else if ((operation == GAPM_SET_ADV_DATA) && (status == GAP_ERR_NO_ERROR))
+    {
+        // back on air, front free to build
+        st->front ^= 1;
+    }
+
+    if ((st->flags & ADVS_F_DEL) && (st->state == ADVS_ST_READY))
+    {
+        advs_del(set);
+    }
+
+    advs_next();
+    return true;
+}
+
+void advs_created_ind(uint8_t actv_idx)
+{
+    if (advs_env.op == GAPM_CREATE_ADV_ACTIVITY)
+    {
+        advs_env.set[advs_env.op_set].actv_idx = actv_idx;
+    }
+}
+
+uint8_t advs_stopped_ind(uint8_t actv_idx, uint8_t reason)
+{
+    for (uint8_t i = 0; i < ADVS_SET_MAX; i++)
+    {
+        struct advs_set *st = &advs_env.set[i];
+
+        if ((st->actv_idx != actv_idx) || ((st->state != ADVS_ST_ON) && (st->state != ADVS_ST_STOP)))
+        {
+            continue;
+        }
+
+        DEBUG("stopped(set:%d,rsn:0x%X)", i, reason);
+
+        if ((reason == GAP_ERR_TIMEOUT) && (st->cfg->period) && (st->flags & ADVS_F_EN))
+        {
+            // on_time of budget used up
+            st->state = ADVS_ST_REST;
+        }
+        else
+        {
+            // connected or stopped, start again by advs_start()
+            st->state = ADVS_ST_READY;
+            st->flags &= ~ADVS_F_EN;
+        }
+
+        if (st->flags & ADVS_F_DEL)
+        {
+            advs_del(i);
+        }
+
+        advs_next();
+        return i;
+    }
+
+    return ADVS_SET_INVALID;
+}
+
+#endif //(APP_ADV_SCH)
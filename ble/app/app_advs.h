@@ -0,0 +1,132 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_advs.h
+ *
+ * @brief Header file - Advertising Scheduler(Multi-set, Rotating Payload and Duty Budget).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_ADVS_H_
+#define APP_ADVS_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Scheduler, own all advertising sets(app_adv_action() of app_actv.c as one set)
+#if !defined(APP_ADV_SCH)
+    #define APP_ADV_SCH              (0)
+#endif
+
+/// Max number of advertising sets, each one activity of BLE_ACTIVITY_MAX
+#if !defined(ADVS_SET_MAX)
+    #define ADVS_SET_MAX             (3)
+#endif
+
+/// Invalid set, advs_add() failed
+#define ADVS_SET_INVALID             (0xFF)
+
+/**
+ ****************************************************************************************
+ * @brief Callback to build payload(AD structures) of set.
+ *
+ * @param[in]  set   index of set
+ * @param[out] data  buffer to fill
+ * @param[in]  max   size of buffer(GAP_ADV_DATA_LEN)
+ *
+ * @return Length of payload. Same as on air, update skipped.
+ ****************************************************************************************
+ */
+typedef uint8_t (*advs_gen_t)(uint8_t set, uint8_t *data, uint8_t max);
+
+/// Configure of set, kept by scheduler(not copied), must be static
+struct advs_cfg
+{
+    /// Properties @see enum gapm_adv_prop, discovery mode @see enum gapm_adv_disc_mode
+    uint16_t   prop;
+    uint8_t    disc_mode;
+    /// Channel map, 0x07 for all
+    uint8_t    chmap;
+    /// Interval, unit in 0.625ms
+    uint16_t   intv_min;
+    uint16_t   intv_max;
+
+    /// Duty budget: advertise 'on_time' in each 'period', unit in 10ms.
+    /// on_time 0 always on; period 0 no restart after on_time(stop as duration)
+    uint16_t   on_time;
+    uint16_t   period;
+    /// Rebuild payload and scan response each, unit in 10ms, 0 only on advs_update()
+    uint16_t   rotate;
+
+    /// Build advertising data, scan response data(NULL if not scannable)
+    advs_gen_t adv_gen;
+    advs_gen_t rsp_gen;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (APP_ADV_SCH)
+/**
+ ****************************************************************************************
+ * @brief Reset all sets, called in app_actv_create() when BLE configured.
+ ****************************************************************************************
+ */
+void advs_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Add set, activity created and payload set in order of GAPM commands.
+ *
+ * @param[in] cfg    configure of set
+ * @param[in] start  start advertising once ready
+ *
+ * @return Index of set, ADVS_SET_INVALID if no room.
+ ****************************************************************************************
+ */
+uint8_t advs_add(const struct advs_cfg *cfg, bool start);
+
+/// Start, stop(kept, start again later) or delete set
+void advs_start(uint8_t set);
+void advs_stop(uint8_t set);
+void advs_del(uint8_t set);
+
+/// Rebuild payload of set now, data updated while advertising(no stop)
+void advs_update(uint8_t set);
+
+/// Poll in main loop, rotate payloads and restart sets resting
+void advs_proc(void);
+
+/// Feed of GAPM events, called in app_actv.c
+bool advs_cmp_evt(uint8_t operation, uint8_t status);
+void advs_created_ind(uint8_t actv_idx);
+
+/**
+ ****************************************************************************************
+ * @brief Advertising activity stopped, by connection, on_time or advs_stop().
+ *
+ * @param[in] actv_idx  activity index
+ * @param[in] reason    reason of stopped
+ *
+ * @return Index of set, ADVS_SET_INVALID if not found.
+ ****************************************************************************************
+ */
+uint8_t advs_stopped_ind(uint8_t actv_idx, uint8_t reason);
+#endif //(APP_ADV_SCH)
+
+#endif // APP_ADVS_H_
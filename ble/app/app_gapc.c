@@ -16,6 +16,13 @@
 
 #include "bledef.h"
 #include "app.h"
+#include "app_msg.h"
+#include "app_tune.h"
+#include "app_l2cc.h"
+#include "app_gcli.h"
+#include "app_lstat.h"
+#include "app_rpa.h"
+#include "app_slat.h"
 
 #if (DBG_GAPC)
 #include "dbg.h"
@@ -52,6 +59,14 @@ APP_MSG_HANDLER(gapc_cmp_evt)
     #else
     (void)param;
     #endif
+
+    #if (APP_TUNE_EN)
+    app_tune_cmp(TASK_IDX(src_id), param->operation, param->status);
+    #endif
+
+    #if (APP_SLAT_EN)
+    app_slat_cmp(TASK_IDX(src_id), param->operation, param->status);
+    #endif
 }
 
 /**
@@ -71,6 +86,18 @@ APP_MSG_HANDLER(gapc_connection_req_ind)
     // Indicate Connect_Req_Pkt be send, need wait to sync (try 6 times of conn_event).
     // If synced, goto gapc_connection_ind. Otherwise, goto gapc_disconnect_ind(reason=0x3E)
     app_conn_fsm(BLE_CONNECTING, conidx, param);
+
+    #if (APP_TUNE_EN)
+    app_tune_param_ind(conidx, param->con_interval, param->con_latency, param->sup_to);
+    #endif
+
+    #if (LINK_STAT)
+    lstat_conn_ind(conidx, param->con_interval, param->con_latency, param->sup_to);
+    #endif
+
+    #if (APP_SLAT_EN)
+    app_slat_conn_ind(conidx, param->con_interval, param->con_latency, param->sup_to);
+    #endif
 }
 
 /**
@@ -87,6 +114,11 @@ APP_MSG_HANDLER(gapc_connection_ind)
 
     // Connection established, update from v1.3
     app_conn_fsm(BLE_CONNECTED, conidx, param);
+
+    #if (APP_TUNE_EN)
+    // Negotiate DLE, PHY and MTU
+    app_tune_start(conidx);
+    #endif
 }
 
 /**
@@ -102,6 +134,26 @@ APP_MSG_HANDLER(gapc_disconnect_ind)
     DEBUG("gapc_disconnect_ind(cid:%d,hdl:%d,reason:0x%X)", conidx, param->conhdl, param->reason);
 
     app_conn_fsm(BLE_DISCONNECTED, conidx, param);
+
+    #if (APP_TUNE_EN)
+    app_tune_stop(conidx);
+    #endif
+
+    #if (L2CC_LECB)
+    lecb_conn_lost(conidx);
+    #endif
+
+    #if (GATT_CLI_QUE)
+    gcli_conn_lost(conidx);
+    #endif
+
+    #if (LINK_STAT)
+    lstat_conn_lost(conidx, param->reason);
+    #endif
+
+    #if (APP_SLAT_EN)
+    app_slat_conn_lost(conidx);
+    #endif
 }
 
 /**
@@ -136,7 +188,17 @@ APP_MSG_HANDLER(gapc_param_updated_ind)
     #endif
 
     // Current param, may update to slaves
+    #if (APP_TUNE_EN)
+    app_tune_param_ind(TASK_IDX(src_id), param->con_interval, param->con_latency, param->sup_to);
+    #endif
+
+    #if (LINK_STAT)
+    lstat_param_ind(TASK_IDX(src_id), param->con_interval, param->con_latency, param->sup_to);
+    #endif
 
+    #if (APP_SLAT_EN)
+    app_slat_param_ind(TASK_IDX(src_id), param->con_interval, param->con_latency, param->sup_to);
+    #endif
 }
 
 /**
@@ -154,8 +216,54 @@ APP_MSG_HANDLER(gapc_le_pkt_size_ind)
     #else
     (void)param;(void)src_id;
     #endif
+
+    #if (APP_TUNE_EN)
+    app_tune_dle_ind(TASK_IDX(src_id), param->max_tx_octets, param->max_rx_octets);
+    #endif
+
+    #if (LINK_STAT)
+    lstat_dle_ind(TASK_IDX(src_id), param->max_tx_octets, param->max_rx_octets);
+    #endif
+}
+
+/**
+ ****************************************************************************************
+ * @brief Handle LE PHY indication
+ ****************************************************************************************
+ */
+APP_MSG_HANDLER(gapc_le_phy_ind)
+{
+    (void)msgid;(void)dest_id;
+    #if (DBG_GAPC)
+    uint8_t conidx = TASK_IDX(src_id);
+    DEBUG("le_phy_ind(cid:%d,tx:%d,rx:%d)", conidx, param->tx_phy, param->rx_phy);
+    #else
+    (void)param;(void)src_id;
+    #endif
+
+    #if (APP_TUNE_EN)
+    app_tune_phy_ind(TASK_IDX(src_id), param->tx_phy, param->rx_phy);
+    #endif
+
+    #if (LINK_STAT)
+    lstat_phy_ind(TASK_IDX(src_id), param->tx_phy, param->rx_phy);
+    #endif
 }
 
+#if (LINK_STAT)
+/**
+ ****************************************************************************************
+ * @brief Handle RSSI of connection, requested by lstat_rssi_req()
+ ****************************************************************************************
+ */
+APP_MSG_HANDLER(gapc_con_rssi_ind)
+{
+    (void)msgid;(void)dest_id;
+
+    lstat_rssi_ind(TASK_IDX(src_id), param->rssi);
+}
+#endif //(LINK_STAT)
+
 #if (BLE_EN_SMP)
 /**
  ****************************************************************************************
@@ -305,6 +413,9 @@ APP_MSG_HANDLER(gapc_bond_ind)
             debugHex(param->data.irk.irk.key, GAP_KEY_LEN);
             debugHex(param->data.irk.addr.addr.addr, GAP_BD_ADDR_LEN);
             // Store peer identity
+            #if (RPA_CACHE)
+            rpa_irk_add(&param->data.irk.irk, &param->data.irk.addr);
+            #endif //(RPA_CACHE)
         } break;
 
         // In Secure Connections we get BOND_IND with SMPC calculated LTK
@@ -388,6 +499,32 @@ APP_MSG_HANDLER(gapc_security_ind)
 }
 #endif //(BLE_EN_SMP)
 
+/// Handlers of GAPC Message, indexed by MSG_IDX(msgid)
+APP_MSG_TABLE(gapc_msg)
+{
+    APP_MSG_ENTRY(GAPC_CMP_EVT, gapc_cmp_evt),
+    APP_MSG_ENTRY(GAPC_CONNECTION_REQ_IND, gapc_connection_req_ind),
+    APP_MSG_ENTRY(GAPC_CONNECTION_IND, gapc_connection_ind),
+    APP_MSG_ENTRY(GAPC_DISCONNECT_IND, gapc_disconnect_ind),
+    APP_MSG_ENTRY(GAPC_PARAM_UPDATE_REQ_IND, gapc_param_update_req_ind),
+    APP_MSG_ENTRY(GAPC_PARAM_UPDATED_IND, gapc_param_updated_ind),
+
+    #if (BLE_EN_SMP)
+    APP_MSG_ENTRY(GAPC_BOND_REQ_IND, gapc_bond_req_ind),
+    APP_MSG_ENTRY(GAPC_BOND_IND, gapc_bond_ind),
+    APP_MSG_ENTRY(GAPC_ENCRYPT_REQ_IND, gapc_encrypt_req_ind),
+    APP_MSG_ENTRY(GAPC_ENCRYPT_IND, gapc_encrypt_ind),
+    APP_MSG_ENTRY(GAPC_SECURITY_IND, gapc_security_ind),
+    #endif //(BLE_EN_SMP)
+
+    APP_MSG_ENTRY(GAPC_LE_PKT_SIZE_IND, gapc_le_pkt_size_ind),
+    APP_MSG_ENTRY(GAPC_LE_PHY_IND, gapc_le_phy_ind),
+
+    #if (LINK_STAT)
+    APP_MSG_ENTRY(GAPC_CON_RSSI_IND, gapc_con_rssi_ind),
+    #endif //(LINK_STAT)
+};
+
 /**
  ****************************************************************************************
  * @brief SubTask Handler of GAP controller Message.
@@ -400,79 +537,13 @@ APP_MSG_HANDLER(gapc_security_ind)
  */
 APP_SUBTASK_HANDLER(gapc_msg)
 {
-    switch (msgid)
+    if (!APP_MSG_DISPATCH(gapc_msg))
     {
-        case GAPC_CMP_EVT:
-        {
-            APP_MSG_FUNCTION(gapc_cmp_evt);
-        } break;
-
-        case GAPC_CONNECTION_REQ_IND:
-        {
-            APP_MSG_FUNCTION(gapc_connection_req_ind);
-        } break;
-
-        case GAPC_CONNECTION_IND:
-        {
-            // Connection established, update from v1.3
-            APP_MSG_FUNCTION(gapc_connection_ind);
-        } break;
-
-        case GAPC_DISCONNECT_IND:
-        {
-            APP_MSG_FUNCTION(gapc_disconnect_ind);
-        } break;
-
-        case GAPC_PARAM_UPDATE_REQ_IND:
-        {
-            APP_MSG_FUNCTION(gapc_param_update_req_ind);
-        } break;
-
-        case GAPC_PARAM_UPDATED_IND:
-        {
-            APP_MSG_FUNCTION(gapc_param_updated_ind);
-        } break;
-
-        #if (BLE_EN_SMP)
-        case GAPC_BOND_REQ_IND:
-        {
-            APP_MSG_FUNCTION(gapc_bond_req_ind);
-        } break;
-
-        case GAPC_BOND_IND:
-        {
-            APP_MSG_FUNCTION(gapc_bond_ind);
-        } break;
-
-        case GAPC_ENCRYPT_REQ_IND:
-        {
-            APP_MSG_FUNCTION(gapc_encrypt_req_ind);
-        } break;
-
-        case GAPC_ENCRYPT_IND:
-        {
-            APP_MSG_FUNCTION(gapc_encrypt_ind);
-        } break;
-
-        case GAPC_SECURITY_IND:
-        {
-            APP_MSG_FUNCTION(gapc_security_ind);
-        } break;
-        #endif //(BLE_EN_SMP)
-
-        case GAPC_LE_PKT_SIZE_IND:
-        {
-            APP_MSG_FUNCTION(gapc_le_pkt_size_ind);
-        } break;
-
-        default:
-        {
-            #if (DBG_GAPC)
-            uint16_t length = ke_param2msg(param)->param_len;
-            DEBUG("Unknow MsgId:0x%X, %d", msgid, length);
-            debugHex((uint8_t *)param, length);
-            #endif
-        } break;
+        #if (DBG_GAPC)
+        uint16_t length = ke_param2msg(param)->param_len;
+        DEBUG("Unknow MsgId:0x%X, %d", msgid, length);
+        debugHex((uint8_t *)param, length);
+        #endif
     }
 
     return (MSG_STATUS_FREE);
@@ -12,6 +12,8 @@
 #include <stdint.h>
 #include "bledef.h"
 #include "app.h"
+#include "app_msg.h"
+#include "app_rpa.h"
 
 #if (DBG_GAPM)
 #include "dbg.h"
@@ -44,6 +46,14 @@ APP_MSG_HANDLER(gapm_cmp_evt)
         // Init profiles or activities after config
         app_conf_fsm(BLE_CONFIGURED);
     }
+    #if (RPA_CACHE)
+    else if (param->operation == GAPM_RESOLV_ADDR)
+    {
+        DEBUG("Resolv Addr(sta:0x%02X)", param->status);
+
+        rpa_cmp_evt(param->status);
+    }
+    #endif //(RPA_CACHE)
     #if (APP_ACTV_EN)
     else if (param->operation >= GAPM_CREATE_ADV_ACTIVITY)
     {
@@ -90,6 +100,17 @@ APP_MSG_HANDLER(gapm_ext_adv_report_ind)
 #endif //(BLE_EN_SCAN)
 #endif //(APP_ACTV_EN)
 
+#if (RPA_CACHE)
+APP_MSG_HANDLER(gapm_addr_solved_ind)
+{
+    (void)msgid;(void)dest_id;(void)src_id;
+    DEBUG("Addr Solved");
+    debugHex(param->addr.addr, GAP_BD_ADDR_LEN);
+
+    rpa_solved_ind(&param->addr, &param->irk);
+}
+#endif //(RPA_CACHE)
+
 #if (DBG_GAPM)
 APP_MSG_HANDLER(gapm_scan_request_ind)
 {
@@ -100,6 +121,29 @@ APP_MSG_HANDLER(gapm_scan_request_ind)
 #endif
 
 
+/// Handlers of GAPM Message, indexed by MSG_IDX(msgid)
+APP_MSG_TABLE(gapm_msg)
+{
+    APP_MSG_ENTRY(GAPM_CMP_EVT, gapm_cmp_evt),
+
+    #if (RPA_CACHE)
+    APP_MSG_ENTRY(GAPM_ADDR_SOLVED_IND, gapm_addr_solved_ind),
+    #endif //(RPA_CACHE)
+
+    #if (APP_ACTV_EN)
+    APP_MSG_ENTRY(GAPM_ACTIVITY_CREATED_IND, gapm_activity_created_ind),
+    APP_MSG_ENTRY(GAPM_ACTIVITY_STOPPED_IND, gapm_activity_stopped_ind),
+
+    #if (BLE_EN_SCAN)
+    APP_MSG_ENTRY(GAPM_EXT_ADV_REPORT_IND, gapm_ext_adv_report_ind),
+    #endif //(BLE_EN_SCAN)
+
+    #if (DBG_GAPM)
+    APP_MSG_ENTRY(GAPM_SCAN_REQUEST_IND, gapm_scan_request_ind),
+    #endif
+    #endif //(APP_ACTV_EN)
+};
+
 /**
  ****************************************************************************************
  * @brief SubTask Handler of GAP manager Message.
@@ -108,43 +152,9 @@ APP_MSG_HANDLER(gapm_scan_request_ind)
 
 APP_SUBTASK_HANDLER(gapm_msg)
 {
-    switch (msgid)
+    if (!APP_MSG_DISPATCH(gapm_msg))
     {
-        case GAPM_CMP_EVT:
-        {
-            APP_MSG_FUNCTION(gapm_cmp_evt);
-        } break;
-
-        #if (APP_ACTV_EN)
-        case GAPM_ACTIVITY_CREATED_IND:
-        {
-            APP_MSG_FUNCTION(gapm_activity_created_ind);
-        } break;
-
-        case GAPM_ACTIVITY_STOPPED_IND:
-        {
-            APP_MSG_FUNCTION(gapm_activity_stopped_ind);
-        } break;
-
-        #if (BLE_EN_SCAN)
-        case GAPM_EXT_ADV_REPORT_IND:
-        {
-            APP_MSG_FUNCTION(gapm_ext_adv_report_ind);
-        } break;
-        #endif //(BLE_EN_SCAN)
-
-        #if (DBG_GAPM)
-        case GAPM_SCAN_REQUEST_IND:
-        {
-            APP_MSG_FUNCTION(gapm_scan_request_ind);
-        } break;
-        #endif
-        #endif //(APP_ACTV_EN)
-
-        default:
-        {
-            DEBUG("Unknow MsgId:0x%X", msgid);
-        } break;
+        DEBUG("Unknow MsgId:0x%X", msgid);
     }
 
     return (MSG_STATUS_FREE);
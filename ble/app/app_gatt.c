@@ -12,8 +12,10 @@
 #if (GATT_CLI)
 
 #include "app.h"
+#include "app_msg.h"
 #include "gatt.h"
 #include "gatt_api.h"
+#include "app_gcli.h"
 
 #if (DBG_GATT)
 #include "dbg.h"
@@ -38,6 +40,11 @@
 APP_MSG_HANDLER(gatt_cmp_evt)
 {
     (void)msgid;(void)dest_id;(void)src_id;
+
+    #if (GATT_CLI_QUE)
+    if (gcli_cmp_evt(TASK_IDX(src_id), param))
+        return;
+    #endif
     #if (DBG_GATT)
     // operation @see enum gatt_operation
     DEBUG("Cmp_evt(op:%d,sta:0x%02x)", param->operation, param->status);
@@ -103,6 +110,11 @@ APP_MSG_HANDLER(gatt_disc_char_desc_ind)
 APP_MSG_HANDLER(gatt_read_ind)
 {
     (void)msgid;(void)dest_id;(void)src_id;
+
+    #if (GATT_CLI_QUE)
+    if (gcli_read_ind(TASK_IDX(src_id), param))
+        return;
+    #endif
     #if (DBG_GATT)
     DEBUG("Read_ind(hdl:0x%02x,oft:%d,len:%d)", param->handle, param->offset, param->length);
     debugHex(param->value, param->length);
@@ -133,6 +145,20 @@ APP_MSG_HANDLER(gatt_event_req_ind)
     gatt_evt_cfm(conidx, param->handle);
 }
 
+/// Handlers of GATT Message, indexed by MSG_IDX(msgid)
+APP_MSG_TABLE(gatt_msg)
+{
+    APP_MSG_ENTRY(GATT_CMP_EVT, gatt_cmp_evt),
+    APP_MSG_ENTRY(GATT_MTU_CHANGED_IND, gatt_mtu_changed_ind),
+    APP_MSG_ENTRY(GATT_DISC_SVC_IND, gatt_disc_svc_ind),
+    APP_MSG_ENTRY(GATT_DISC_SVC_INCL_IND, gatt_disc_svc_incl_ind),
+    APP_MSG_ENTRY(GATT_DISC_CHAR_IND, gatt_disc_char_ind),
+    APP_MSG_ENTRY(GATT_DISC_CHAR_DESC_IND, gatt_disc_char_desc_ind),
+    APP_MSG_ENTRY(GATT_READ_IND, gatt_read_ind),
+    APP_MSG_ENTRY(GATT_EVENT_IND, gatt_event_ind),
+    APP_MSG_ENTRY(GATT_EVENT_REQ_IND, gatt_event_req_ind),
+};
+
 /**
  ****************************************************************************************
  * @brief SubTask Handler of GATT Message.
@@ -140,57 +166,9 @@ APP_MSG_HANDLER(gatt_event_req_ind)
  */
 APP_SUBTASK_HANDLER(gatt_msg)
 {
-    switch (msgid)
+    if (!APP_MSG_DISPATCH(gatt_msg))
     {
-        case GATT_CMP_EVT:
-        {
-            APP_MSG_FUNCTION(gatt_cmp_evt);
-        } break;
-
-        case GATT_MTU_CHANGED_IND:
-        {
-            APP_MSG_FUNCTION(gatt_mtu_changed_ind);
-        } break;
-
-        case GATT_DISC_SVC_IND:
-        {
-            APP_MSG_FUNCTION(gatt_disc_svc_ind);
-        } break;
-
-        case GATT_DISC_SVC_INCL_IND:
-        {
-            APP_MSG_FUNCTION(gatt_disc_svc_incl_ind);
-        } break;
-
-        case GATT_DISC_CHAR_IND:
-        {
-            APP_MSG_FUNCTION(gatt_disc_char_ind);
-        } break;
-
-        case GATT_DISC_CHAR_DESC_IND:
-        {
-            APP_MSG_FUNCTION(gatt_disc_char_desc_ind);
-        } break;
-
-        case GATT_READ_IND:
-        {
-            APP_MSG_FUNCTION(gatt_read_ind);
-        } break;
-
-        case GATT_EVENT_IND:
-        {
-            APP_MSG_FUNCTION(gatt_event_ind);
-        } break;
-
-        case GATT_EVENT_REQ_IND:
-        {
-            APP_MSG_FUNCTION(gatt_event_req_ind);
-        } break;
-
-        default:
-        {
-            DEBUG("Unknow MsgId:0x%X", msgid);
-        } break;
+        DEBUG("Unknow MsgId:0x%X", msgid);
     }
 
     return (MSG_STATUS_FREE);
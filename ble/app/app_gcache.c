@@ -0,0 +1,250 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_gcache.c
+ *
+ * @brief GATT Client Cache - Example
+ *
+ *  Handles map found by discovery is saved in flash with identity and Database Hash of peer.
+ *  When reconnected, hash read first(one round trip), map loaded if hash unchanged,
+ *  else discovery again and entry rewritten. One page per peer, the oldest replaced when full.
+ *  Hash covers handles and declarations of whole database, so peer not cached but with same
+ *  hash(e.g. same firmware) shares the map of other peer.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "app.h"
+#include "gatt.h"
+#include "drvs.h"
+#include "app_gcache.h"
+
+#if (GATT_CACHE_EN)
+
+#if (DBG_GCACHE)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (GATT_CACHE_OFFSET < 0x1000)
+#error "User Store Data Offset Must Greater Than or Equal 0x1000"
+#endif
+
+#if (GATT_CACHE_DATA_LEN % 4) || (GATT_CACHE_DATA_LEN > 0x100 - 32)
+#error "GATT_CACHE_DATA_LEN must be multiple of 4 and fit one page"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define GCACHE_MAGIC          (0x48434347) // "GCCH"
+#define GCACHE_PAGE(idx)      (GATT_CACHE_OFFSET + ((uint32_t)(idx) << 8))
+#define GCACHE_HDR_LEN        (offsetof(struct gcache_ent, data))
+
+/// Entry in flash page
+struct gcache_ent
+{
+    uint32_t magic;
+    /// Write sequence, the least one replaced
+    uint16_t seq;
+    uint16_t len;
+    struct gap_bdaddr peer;
+    uint8_t  rsvd;
+    uint8_t  hash[GAP_KEY_LEN];
+    uint8_t  data[GATT_CACHE_DATA_LEN];
+};
+
+/// Hash read of link
+struct gcache_link
+{
+    uint8_t hash[GAP_KEY_LEN];
+    bool    valid;
+};
+
+static struct gcache_link gcache_link[BLE_CONNECTION_MAX];
+static struct gcache_stat gcache_st;
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void gcache_read_hdr(uint8_t idx, struct gcache_ent *ent)
+{
+    flash_byte_read(GCACHE_PAGE(idx), (uint8_t *)ent, GCACHE_HDR_LEN);
+}
+
+/// Index of peer's entry, or GATT_CACHE_NB
+static uint8_t gcache_find(const struct gap_bdaddr *peer, struct gcache_ent *ent)
+{
+    for (uint8_t idx = 0; idx < GATT_CACHE_NB; idx++)
+    {
+        gcache_read_hdr(idx, ent);
+
+        if ((ent->magic == GCACHE_MAGIC) && !memcmp(&ent->peer, peer, sizeof(struct gap_bdaddr)))
+        {
+            return idx;
+        }
+    }
+
+    return GATT_CACHE_NB;
+}
+
+/// Index of entry with same hash and length, or GATT_CACHE_NB
+static uint8_t gcache_find_hash(const uint8_t *hash, uint16_t len, struct gcache_ent *ent)
+{
+    for (uint8_t idx = 0; idx < GATT_CACHE_NB; idx++)
+    {
+        gcache_read_hdr(idx, ent);
+
+        if ((ent->magic == GCACHE_MAGIC) && (ent->len == len) && !memcmp(ent->hash, hash, GAP_KEY_LEN))
+        {
+            return idx;
+        }
+    }
+
+    return GATT_CACHE_NB;
+}
+
+void gcache_hash_read(uint8_t conidx)
+{
+    struct gatt_read_db_hash_cmd *cmd = KE_MSG_ALLOC(GATT_READ_DB_HASH_CMD, TASK_BUILD(TASK_GATT, conidx),
+                                                     TASK_APP, gatt_read_db_hash_cmd);
+
+    gcache_link[conidx].valid = false;
+
+    cmd->operation = GATT_READ_DB_HASH;
+    cmd->seq_num   = 0;
+    ke_msg_send(cmd);
+}
+
+void gcache_hash_ind(uint8_t conidx, const uint8_t *hash)
+{
+    memcpy(gcache_link[conidx].hash, hash, GAP_KEY_LEN);
+    gcache_link[conidx].valid = true;
+}
+
+bool gcache_load(uint8_t conidx, const struct gap_bdaddr *peer, void *data, uint16_t len)
+{
+    struct gcache_ent ent;
+    uint8_t idx = GATT_CACHE_NB;
+
+    if (gcache_link[conidx].valid)
+    {
+        idx = gcache_find(peer, &ent);
+
+        if ((idx < GATT_CACHE_NB) && ((ent.len != len) || memcmp(ent.hash, gcache_link[conidx].hash, GAP_KEY_LEN)))
+        {
+            // database of peer changed
+            idx = GATT_CACHE_NB;
+        }
+        else if (idx == GATT_CACHE_NB)
+        {
+            idx = gcache_find_hash(gcache_link[conidx].hash, len, &ent);
+        }
+    }
+
+    if (idx < GATT_CACHE_NB)
+    {
+        flash_byte_read(GCACHE_PAGE(idx) + GCACHE_HDR_LEN, data, len);
+
+        gcache_st.hits++;
+        DEBUG("hit(cid:%d,idx:%d,len:%d)", conidx, idx, len);
+        return true;
+    }
+
+    gcache_st.misses++;
+    DEBUG("miss(cid:%d,hash:%d)", conidx, gcache_link[conidx].valid);
+    return false;
+}
+
+void gcache_save(uint8_t conidx, const struct gap_bdaddr *peer, const void *data, uint16_t len)
+{
+    struct gcache_ent ent;
+    uint8_t  idx, free_idx = GATT_CACHE_NB, old_idx = 0;
+    uint16_t seq_max = 0, seq_old = 0;
+    bool     first = true;
+
+    if (!gcache_link[conidx].valid || (len > GATT_CACHE_DATA_LEN))
+    {
+        return;
+    }
+
+    idx = gcache_find(peer, &ent);
+
+    // unchanged, save flash wear
+    if ((idx < GATT_CACHE_NB) && (ent.len == len) && !memcmp(ent.hash, gcache_link[conidx].hash, GAP_KEY_LEN))
+    {
+        return;
+    }
+
+    for (uint8_t i = 0; i < GATT_CACHE_NB; i++)
+    {
+        gcache_read_hdr(i, &ent);
+
+        if (ent.magic != GCACHE_MAGIC)
+        {
+            if (free_idx == GATT_CACHE_NB)
+                free_idx = i;
+            continue;
+        }
+
+        if (first || ((int16_t)(ent.seq - seq_max) > 0))
+        {
+            seq_max = ent.seq;
+        }
+
+        if (first || ((int16_t)(ent.seq - seq_old) < 0))
+        {
+            seq_old = ent.seq;
+            old_idx = i;
+        }
+
+        first = false;
+    }
+
+    // rewrite own page, else take empty one, else replace the oldest
+    if (idx == GATT_CACHE_NB)
+    {
+        idx = (free_idx < GATT_CACHE_NB) ? free_idx : old_idx;
+    }
+
+    memset(&ent, 0xFF, sizeof(ent));
+    ent.magic = GCACHE_MAGIC;
+    ent.seq   = seq_max + 1;
+    ent.len   = len;
+    memcpy(&ent.peer, peer, sizeof(struct gap_bdaddr));
+    memcpy(ent.hash, gcache_link[conidx].hash, GAP_KEY_LEN);
+    memcpy(ent.data, data, len);
+
+    flash_page_erase(GCACHE_PAGE(idx));
+    flash_byte_write(GCACHE_PAGE(idx), (uint8_t *)&ent, GCACHE_HDR_LEN + ((len + 3) & ~3));
+
+    gcache_st.saves++;
+    DEBUG("save(cid:%d,idx:%d,seq:%d,len:%d)", conidx, idx, ent.seq, len);
+}
+
+void gcache_drop(const struct gap_bdaddr *peer)
+{
+    struct gcache_ent ent;
+    uint8_t idx = gcache_find(peer, &ent);
+
+    if (idx < GATT_CACHE_NB)
+    {
+        flash_page_erase(GCACHE_PAGE(idx));
+    }
+}
+
+const struct gcache_stat *gcache_stat(void)
+{
+    return &gcache_st;
+}
+
+#endif //(GATT_CACHE_EN)
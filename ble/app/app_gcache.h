@@ -0,0 +1,114 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_gcache.h
+ *
+ * @brief Header file - GATT Client Cache(Handles of peer kept in flash, validated by Database Hash).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_GCACHE_H_
+#define APP_GCACHE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gap.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Cache, handle GATT_DB_HASH_IND via gcache_hash_ind()
+#if !defined(GATT_CACHE_EN)
+    #define GATT_CACHE_EN            (0)
+#endif
+
+/// Flash offset of cache, one page(0x100) per peer
+#if !defined(GATT_CACHE_OFFSET)
+    #define GATT_CACHE_OFFSET        (0x1400)
+#endif
+
+/// Number of peers cached
+#if !defined(GATT_CACHE_NB)
+    #define GATT_CACHE_NB            (4)
+#endif
+
+/// Max bytes of handles map of one peer, multiple of 4
+#if !defined(GATT_CACHE_DATA_LEN)
+    #define GATT_CACHE_DATA_LEN      (64)
+#endif
+
+/// Statistics of cache
+struct gcache_stat
+{
+    /// Handles loaded, discovery skipped
+    uint16_t hits;
+    /// Not found, hash unread or changed
+    uint16_t misses;
+    /// Entries written to flash
+    uint16_t saves;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (GATT_CACHE_EN)
+/**
+ ****************************************************************************************
+ * @brief Read Database Hash of peer, value via gcache_hash_ind(),
+ *        done with GATT_CMP_EVT(operation GATT_READ_DB_HASH).
+ *
+ * @param[in] conidx  connection index
+ ****************************************************************************************
+ */
+void gcache_hash_read(uint8_t conidx);
+
+/// Database Hash of peer received, called by GATT_DB_HASH_IND handler
+void gcache_hash_ind(uint8_t conidx, const uint8_t *hash);
+
+/**
+ ****************************************************************************************
+ * @brief Load handles map of peer, only if Database Hash read is same as saved.
+ *        Peer not cached may load map of other peer with same hash.
+ *
+ * @param[in]  conidx  connection index
+ * @param[in]  peer    identity of peer
+ * @param[out] data    buffer of handles map
+ * @param[in]  len     length of handles map
+ *
+ * @return true if loaded, else do discovery then gcache_save().
+ ****************************************************************************************
+ */
+bool gcache_load(uint8_t conidx, const struct gap_bdaddr *peer, void *data, uint16_t len);
+
+/**
+ ****************************************************************************************
+ * @brief Save handles map of peer discovered, ignored if Database Hash not read.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] peer    identity of peer
+ * @param[in] data    handles map
+ * @param[in] len     length of handles map, no more than GATT_CACHE_DATA_LEN
+ ****************************************************************************************
+ */
+void gcache_save(uint8_t conidx, const struct gap_bdaddr *peer, const void *data, uint16_t len);
+
+/// Remove entry of peer, e.g. handles found invalid
+void gcache_drop(const struct gap_bdaddr *peer);
+
+/// Statistics of cache since power on
+const struct gcache_stat *gcache_stat(void);
+#endif //(GATT_CACHE_EN)
+
+#endif // APP_GCACHE_H_
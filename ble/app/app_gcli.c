@@ -0,0 +1,335 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_gcli.c
+ *
+ * @brief GATT Client Operation Queue - Example
+ *
+ *  Each operation built into GATT command message when pushed(value copied), tagged with
+ *  seq_num of queue entry, then sent in order:
+ *    - Requests(read, write, CCC) one in flight per link, as ATT allows
+ *    - Write commands sent behind, up to GCLI_NB_PKT_MAX in flight of all links
+ *  GATT_CMP_EVT with tag completes entry and refills, no round trip to next step in app.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "app.h"
+#include "gatt.h"
+#include "gapc_api.h"
+#include "app_gcli.h"
+
+#if (GATT_CLI_QUE)
+
+#if (DBG_GCLI)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (GCLI_QUE_LEN & (GCLI_QUE_LEN - 1)) || (GCLI_QUE_LEN > 128)
+#error "GCLI_QUE_LEN must be power of 2, no more than 128"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// seq_num of queue: tag | entry index
+#define GCLI_SEQ_TAG          (0xC500)
+#define GCLI_SEQ_MSK          (0xFF00)
+
+#define GCLI_IDX(cnt)         ((cnt) & (GCLI_QUE_LEN - 1))
+#define GCLI_REQ_NONE         (0)
+
+enum gcli_state
+{
+    GCLI_FREE,
+    GCLI_QUEUED,
+    GCLI_SENT,
+    GCLI_DONE,
+};
+
+/// Entry of queue
+struct gcli_ent
+{
+    /// Message built, NULL once sent
+    void     *msg;
+    gcli_cb_t cb;
+    uint16_t  handle;
+    uint8_t   type;
+    uint8_t   state;
+};
+
+/// Queue of link, entries in [head, next) sent, [next, tail) queued
+struct gcli_link
+{
+    struct gcli_ent ent[GCLI_QUE_LEN];
+    uint8_t head;
+    uint8_t next;
+    uint8_t tail;
+    /// Index + 1 of request in flight, GCLI_REQ_NONE if none
+    uint8_t req;
+};
+
+struct gcli_env_tag
+{
+    struct gcli_link link[BLE_CONNECTION_MAX];
+    /// Write commands can be sent
+    uint8_t nb_pkt;
+};
+
+static struct gcli_env_tag gcli_env = { .nb_pkt = GCLI_NB_PKT_MAX };
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void *gcli_msg_build(uint8_t conidx, const struct gcli_op *op, uint16_t seq_num)
+{
+    if (op->type == GCLI_READ)
+    {
+        struct gatt_read_cmd *cmd = KE_MSG_ALLOC(GATT_READ_CMD, TASK_BUILD(TASK_GATT, conidx),
+                                                 TASK_APP, gatt_read_cmd);
+
+        cmd->operation         = GATT_READ;
+        cmd->nb                = 0;
+        cmd->seq_num           = seq_num;
+        cmd->req.simple.handle = op->handle;
+        cmd->req.simple.offset = 0;
+        cmd->req.simple.length = 0;
+        return cmd;
+    }
+    else
+    {
+        uint16_t length = (op->type == GCLI_CCC) ? sizeof(uint16_t) : op->length;
+        struct gatt_write_cmd *cmd = KE_MSG_ALLOC_DYN(GATT_WRITE_CMD, TASK_BUILD(TASK_GATT, conidx),
+                                                      TASK_APP, gatt_write_cmd, length);
+
+        cmd->operation    = (op->type == GCLI_WRITE_CMD) ? GATT_WRITE_NO_RESPONSE : GATT_WRITE;
+        cmd->auto_execute = true;
+        cmd->seq_num      = seq_num;
+        cmd->handle       = op->handle;
+        cmd->offset       = 0;
+        cmd->length       = length;
+        cmd->cursor       = 0;
+
+        if (op->type == GCLI_CCC)
+            write16p(cmd->value, op->length);
+        else
+            memcpy(cmd->value, op->value, length);
+        return cmd;
+    }
+}
+
+/// Send queued of link in order as allowed
+static void gcli_pump(uint8_t conidx)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+
+    while (link->next != link->tail)
+    {
+        uint8_t idx = GCLI_IDX(link->next);
+        struct gcli_ent *ent = &link->ent[idx];
+
+        if (ent->type == GCLI_WRITE_CMD)
+        {
+            if (gcli_env.nb_pkt == 0)
+                break;
+
+            gcli_env.nb_pkt--; // allocate
+        }
+        else
+        {
+            if (link->req != GCLI_REQ_NONE)
+                break;
+
+            link->req = idx + 1;
+        }
+
+        ent->state = GCLI_SENT;
+        ke_msg_send(ent->msg);
+        ent->msg = NULL;
+        link->next++;
+    }
+}
+
+/// Refill links after write command released, start from next of last one
+static void gcli_pump_all(uint8_t conidx)
+{
+    for (uint8_t i = 1; i <= BLE_CONNECTION_MAX; i++)
+    {
+        gcli_pump((conidx + i) % BLE_CONNECTION_MAX);
+    }
+}
+
+/// Retire entries done from head in order
+static void gcli_retire(struct gcli_link *link)
+{
+    while ((link->head != link->next) && (link->ent[GCLI_IDX(link->head)].state == GCLI_DONE))
+    {
+        link->ent[GCLI_IDX(link->head)].state = GCLI_FREE;
+        link->head++;
+    }
+}
+
+bool gcli_push(uint8_t conidx, const struct gcli_op *ops, uint8_t nb)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+
+    if ((gapc_get_conhdl(conidx) == GAP_INVALID_CONHDL) || (nb > gcli_room(conidx)))
+    {
+        return false;
+    }
+
+    for (uint8_t i = 0; i < nb; i++)
+    {
+        uint8_t idx = GCLI_IDX(link->tail);
+        struct gcli_ent *ent = &link->ent[idx];
+
+        ent->msg    = gcli_msg_build(conidx, &ops[i], GCLI_SEQ_TAG | idx);
+        ent->cb     = ops[i].cb;
+        ent->handle = ops[i].handle;
+        ent->type   = ops[i].type;
+        ent->state  = GCLI_QUEUED;
+        link->tail++;
+    }
+
+    DEBUG("push(cid:%d,nb:%d,queued:%d,nb_pkt:%d)", conidx, nb, (uint8_t)(link->tail - link->head), gcli_env.nb_pkt);
+    gcli_pump(conidx);
+    return true;
+}
+
+uint8_t gcli_room(uint8_t conidx)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+
+    return GCLI_QUE_LEN - (uint8_t)(link->tail - link->head);
+}
+
+uint8_t gcli_pkt_avail(void)
+{
+    return gcli_env.nb_pkt;
+}
+
+void gcli_conn_lost(uint8_t conidx)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+
+    for (uint8_t cnt = link->head; cnt != link->tail; cnt++)
+    {
+        struct gcli_ent *ent = &link->ent[GCLI_IDX(cnt)];
+
+        if (ent->state == GCLI_DONE)
+            continue;
+
+        if (ent->msg != NULL)
+        {
+            // built but not sent
+            ke_free(ke_param2msg(ent->msg));
+            ent->msg = NULL;
+        }
+        else if (ent->type == GCLI_WRITE_CMD)
+        {
+            gcli_env.nb_pkt++; // release, late cmp_evt ignored
+        }
+
+        if (ent->cb)
+        {
+            ent->cb(conidx, GAP_ERR_DISCONNECTED, ent->handle, NULL, 0);
+        }
+    }
+
+    memset(link, 0, sizeof(struct gcli_link));
+
+    gcli_pump_all(conidx);
+}
+
+bool gcli_cmp_evt(uint8_t conidx, const struct gatt_cmp_evt *evt)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+    struct gcli_ent *ent;
+    gcli_cb_t cb;
+    uint16_t handle;
+    uint8_t idx, type;
+
+    if ((evt->seq_num & GCLI_SEQ_MSK) != GCLI_SEQ_TAG)
+    {
+        return false;
+    }
+
+    idx = evt->seq_num & (GCLI_QUE_LEN - 1);
+    ent = &link->ent[idx];
+
+    if (ent->state != GCLI_SENT)
+    {
+        // stale of lost link
+        return true;
+    }
+
+    type   = ent->type;
+    cb     = ent->cb;
+    handle = ent->handle;
+
+    if (type == GCLI_WRITE_CMD)
+    {
+        gcli_env.nb_pkt++; // release
+    }
+    else if (link->req == idx + 1)
+    {
+        link->req = GCLI_REQ_NONE;
+    }
+
+    DEBUG("cmp(cid:%d,idx:%d,typ:%d,sta:0x%X,nb_pkt:%d)", conidx, idx, type, evt->status, gcli_env.nb_pkt);
+
+    // entry free for push in callback
+    ent->state = GCLI_DONE;
+    gcli_retire(link);
+
+    // read callback done with data, else with status
+    if (cb)
+    {
+        cb(conidx, evt->status, handle, NULL, 0);
+    }
+
+    if (type == GCLI_WRITE_CMD)
+        gcli_pump_all(conidx);
+    else
+        gcli_pump(conidx);
+
+    return true;
+}
+
+bool gcli_read_ind(uint8_t conidx, const struct gatt_read_ind *ind)
+{
+    struct gcli_link *link = &gcli_env.link[conidx];
+    struct gcli_ent *ent;
+
+    if (link->req == GCLI_REQ_NONE)
+    {
+        return false;
+    }
+
+    ent = &link->ent[link->req - 1];
+
+    if ((ent->type != GCLI_READ) || (ent->handle != ind->handle))
+    {
+        return false;
+    }
+
+    if (ent->cb)
+    {
+        ent->cb(conidx, GATT_ERR_NO_ERROR, ind->handle, ind->value, ind->length);
+        ent->cb = NULL;
+    }
+
+    return true;
+}
+
+#endif //(GATT_CLI_QUE)
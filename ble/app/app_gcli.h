@@ -0,0 +1,123 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_gcli.h
+ *
+ * @brief Header file - GATT Client Operation Queue(Pipelined Read, Write and CCC enable).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_GCLI_H_
+#define APP_GCLI_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gatt.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Queue, route GATT_CMP_EVT and GATT_READ_IND via gcli_cmp_evt() and gcli_read_ind()
+#if !defined(GATT_CLI_QUE)
+    #define GATT_CLI_QUE             (0)
+#endif
+
+/// Operations queued of each connection, power of 2.
+/// Messages built when pushed, kept in kernel heap until sent.
+#if !defined(GCLI_QUE_LEN)
+    #define GCLI_QUE_LEN             (8)
+#endif
+
+/// Write commands in flight of all connections, not more than controller TX buffers
+#if !defined(GCLI_NB_PKT_MAX)
+    #define GCLI_NB_PKT_MAX          (4)
+#endif
+
+/// Type of operation
+enum gcli_type
+{
+    /// Read request, data via callback
+    GCLI_READ,
+    /// Write request, done when peer responded
+    GCLI_WRITE,
+    /// Write command, done when given to controller, pipelined
+    GCLI_WRITE_CMD,
+    /// Write CCC descriptor, 'length' as config @see ATT_CCC_START_NTF
+    GCLI_CCC,
+};
+
+/**
+ ****************************************************************************************
+ * @brief Callback of operation done.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] status  status @see enum att_err, GAP_ERR_DISCONNECTED if link lost
+ * @param[in] handle  attribute handle of operation
+ * @param[in] data    value read, NULL for others or failed
+ * @param[in] length  length of value read
+ ****************************************************************************************
+ */
+typedef void (*gcli_cb_t)(uint8_t conidx, uint8_t status, uint16_t handle, const uint8_t *data, uint16_t length);
+
+/// Operation of batch
+struct gcli_op
+{
+    /// Type @see enum gcli_type
+    uint8_t   type;
+    /// Attribute handle, descriptor handle for GCLI_CCC
+    uint16_t  handle;
+    /// Length of value, or config of GCLI_CCC
+    uint16_t  length;
+    /// Value to write, copied when pushed
+    const uint8_t *value;
+    /// Callback when done, NULL if not care
+    gcli_cb_t cb;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (GATT_CLI_QUE)
+/**
+ ****************************************************************************************
+ * @brief Push batch of operations, sent in order as soon as allowed:
+ *        one request(read or write) in flight, write commands pipelined up to GCLI_NB_PKT_MAX.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] ops     operations of batch
+ * @param[in] nb      number of operations
+ *
+ * @return true if all queued, false if queue short(none queued).
+ ****************************************************************************************
+ */
+bool gcli_push(uint8_t conidx, const struct gcli_op *ops, uint8_t nb);
+
+/// Free entries of queue
+uint8_t gcli_room(uint8_t conidx);
+
+/// Write commands can be sent now, push no more to keep messages out of heap
+uint8_t gcli_pkt_avail(void);
+
+/// Fail operations pending when link lost, called in app_gapc.c
+void gcli_conn_lost(uint8_t conidx);
+
+/// Handle GATT_CMP_EVT, return true if of queue
+bool gcli_cmp_evt(uint8_t conidx, const struct gatt_cmp_evt *evt);
+
+/// Handle GATT_READ_IND, return true if of queue
+bool gcli_read_ind(uint8_t conidx, const struct gatt_read_ind *ind);
+#endif //(GATT_CLI_QUE)
+
+#endif // APP_GCLI_H_
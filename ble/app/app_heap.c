@@ -0,0 +1,239 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_heap.c
+ *
+ * @brief Heap Statistics of BLE Stack - Example
+ *
+ *  Each block of heap begins with header {tag, size}, used and free blocks tiled from
+ *  base to end, so heap walked linearly: live bytes, largest free block and fragments.
+ *  With HEAP_STAT_WRAP, ke_malloc/ke_free/ke_msg_alloc wrapped at link time, every
+ *  allocation of stack and app counted and peak tracked exactly.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "b6x.h"
+#include "app.h"
+#include "app_heap.h"
+
+#if (HEAP_STAT)
+
+#if (DBG_HEAP)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Tag of block header
+#define HEAP_TAG_USED         (0x8338)
+#define HEAP_TAG_FREE         (0xA55A)
+#define HEAP_HDR_LEN          (4)
+
+/// Size of block, from pointer returned by ke_malloc()
+#define HEAP_BLK_SIZE(ptr)    (((const uint16_t *)(ptr))[-1])
+
+#if defined(__CC_ARM) || defined(__ARMCC_VERSION)
+#define HEAP_WRAP(func)       $Sub$$##func
+#define HEAP_REAL(func)       $Super$$##func
+#else
+#define HEAP_WRAP(func)       __wrap_##func
+#define HEAP_REAL(func)       __real_##func
+#endif
+
+/// Region of heap, word aligned as ke_mem_init()
+struct heap_region
+{
+    uint32_t start;
+    uint32_t end;
+};
+
+static struct heap_region heap_rgn[MEM_TYPE_MAX];
+static struct heap_stat   heap_st[MEM_TYPE_MAX];
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+/// Heap of pointer, MEM_TYPE_MAX if none
+static uint8_t heap_type_of(const void *ptr)
+{
+    for (uint8_t type = 0; type < MEM_TYPE_MAX; type++)
+    {
+        if (((uint32_t)ptr > heap_rgn[type].start) && ((uint32_t)ptr < heap_rgn[type].end))
+        {
+            return type;
+        }
+    }
+
+    return MEM_TYPE_MAX;
+}
+
+void heap_stat_init(const heap_cfg_t *cfg)
+{
+    memset(heap_st, 0, sizeof(heap_st));
+
+    for (uint8_t type = 0; type < MEM_TYPE_MAX; type++)
+    {
+        heap_rgn[type].start = (cfg->base[type] + 3) & ~3UL;
+        heap_rgn[type].end   = (cfg->base[type] + cfg->size[type]) & ~3UL;
+        heap_st[type].size   = heap_rgn[type].end - heap_rgn[type].start;
+    }
+}
+
+const struct heap_stat *heap_stat(uint8_t type)
+{
+    struct heap_stat *st;
+    uint32_t ptr;
+    bool corrupt = false;
+
+    if (type >= MEM_TYPE_MAX)
+    {
+        return NULL;
+    }
+
+    st  = &heap_st[type];
+    ptr = heap_rgn[type].start;
+
+    GLOBAL_INT_DISABLE();
+
+    st->used = st->max_free = st->nb_used = st->nb_free = 0;
+
+    while (ptr < heap_rgn[type].end)
+    {
+        uint16_t tag = *(const uint16_t *)ptr;
+        uint16_t len = *(const uint16_t *)(ptr + 2);
+
+        if ((len < HEAP_HDR_LEN) || (len > heap_rgn[type].end - ptr)
+            || ((tag != HEAP_TAG_USED) && (tag != HEAP_TAG_FREE)))
+        {
+            corrupt = true;
+            break;
+        }
+
+        if (tag == HEAP_TAG_USED)
+        {
+            st->nb_used++;
+            st->used += len;
+        }
+        else
+        {
+            st->nb_free++;
+            if (len > st->max_free)
+                st->max_free = len;
+        }
+
+        ptr += len;
+    }
+
+    if (st->used > st->peak)
+    {
+        st->peak = st->used;
+    }
+
+    GLOBAL_INT_RESTORE();
+
+    if (corrupt)
+    {
+        DEBUG("corrupt(type:%d,at:0x%"PRIX32")", type, ptr);
+        return NULL;
+    }
+
+    return st;
+}
+
+void heap_stat_dump(void)
+{
+    for (uint8_t type = 0; type < MEM_TYPE_MAX; type++)
+    {
+        const struct heap_stat *st = heap_stat(type);
+
+        if (st)
+        {
+            DEBUG("heap %s(size:%d,used:%d,peak:%d,max_free:%d,blk:%d/%d)", (type == MEM_ENV) ? "env" : "msg",
+                st->size, st->used, st->peak, st->max_free, st->nb_used, st->nb_free);
+
+            #if (HEAP_STAT_WRAP)
+            DEBUG("    alloc:%"PRIu32",free:%"PRIu32",msg:%"PRIu32",spill:%d", st->allocs, st->frees, st->msgs, st->spills);
+            #endif
+        }
+    }
+}
+
+#if (HEAP_STAT_WRAP)
+void *HEAP_REAL(ke_malloc)(uint32_t size, uint8_t type);
+void  HEAP_REAL(ke_free)(void *mem_ptr);
+void *HEAP_REAL(ke_msg_alloc)(msg_id_t msgid, task_id_t dest_id, task_id_t src_id, uint16_t param_len);
+
+void *HEAP_WRAP(ke_malloc)(uint32_t size, uint8_t type)
+{
+    void *ptr = HEAP_REAL(ke_malloc)(size, type);
+    uint8_t in = heap_type_of(ptr);
+
+    if (in < MEM_TYPE_MAX)
+    {
+        struct heap_stat *st = &heap_st[in];
+
+        GLOBAL_INT_DISABLE();
+
+        st->allocs++;
+        st->used += HEAP_BLK_SIZE(ptr);
+
+        if (st->used > st->peak)
+            st->peak = st->used;
+
+        if (in != type)
+            st->spills++;
+
+        GLOBAL_INT_RESTORE();
+    }
+
+    return ptr;
+}
+
+void HEAP_WRAP(ke_free)(void *mem_ptr)
+{
+    uint8_t in = heap_type_of(mem_ptr);
+
+    if (in < MEM_TYPE_MAX)
+    {
+        struct heap_stat *st = &heap_st[in];
+
+        GLOBAL_INT_DISABLE();
+
+        st->frees++;
+        st->used -= HEAP_BLK_SIZE(mem_ptr);
+
+        GLOBAL_INT_RESTORE();
+    }
+
+    HEAP_REAL(ke_free)(mem_ptr);
+}
+
+void *HEAP_WRAP(ke_msg_alloc)(msg_id_t msgid, task_id_t dest_id, task_id_t src_id, uint16_t param_len)
+{
+    void *param = HEAP_REAL(ke_msg_alloc)(msgid, dest_id, src_id, param_len);
+    uint8_t in = heap_type_of(param);
+
+    if (in < MEM_TYPE_MAX)
+    {
+        GLOBAL_INT_DISABLE();
+        heap_st[in].msgs++;
+        GLOBAL_INT_RESTORE();
+    }
+
+    return param;
+}
+#endif //(HEAP_STAT_WRAP)
+
+#endif //(HEAP_STAT)
@@ -0,0 +1,95 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_heap.h
+ *
+ * @brief Header file - Heap Statistics of BLE Stack(MEM_ENV and MEM_MSG).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_HEAP_H_
+#define APP_HEAP_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "ke_api.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Statistics, heap walked on query
+#if !defined(HEAP_STAT)
+    #define HEAP_STAT                (0)
+#endif
+
+/// Count each allocation by wrapping ke_malloc/ke_free/ke_msg_alloc, exact peak and counts.
+/// Keil: $Sub$$ patched by armlink itself.
+/// GCC:  need link option '-Wl,--wrap=ke_malloc,--wrap=ke_free,--wrap=ke_msg_alloc'
+#if !defined(HEAP_STAT_WRAP)
+    #define HEAP_STAT_WRAP           (0)
+#endif
+
+/// Statistics of one heap, sizes in bytes with block header
+struct heap_stat
+{
+    /// Size of heap
+    uint16_t size;
+    /// In use, and the most ever seen(exact if HEAP_STAT_WRAP, else sampled on query)
+    uint16_t used;
+    uint16_t peak;
+    /// Largest free block, the most one allocation can get
+    uint16_t max_free;
+    /// Blocks in use, and free blocks(fragments)
+    uint16_t nb_used;
+    uint16_t nb_free;
+
+    /// Counters since init, only if HEAP_STAT_WRAP
+    uint32_t allocs;
+    uint32_t frees;
+    /// Messages allocated in this heap
+    uint32_t msgs;
+    /// Allocations asked for other heap but got from this one, other heap was full
+    uint16_t spills;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (HEAP_STAT)
+/**
+ ****************************************************************************************
+ * @brief Record heaps configured, called after ble_heap().
+ *
+ * @param[in] cfg  heaps given to ble_heap()
+ ****************************************************************************************
+ */
+void heap_stat_init(const heap_cfg_t *cfg);
+
+/**
+ ****************************************************************************************
+ * @brief Walk heap and get statistics, interrupts disabled during walk.
+ *
+ * @param[in] type  heap type @see enum mem_type
+ *
+ * @return Statistics of heap, NULL if type invalid or heap corrupted.
+ ****************************************************************************************
+ */
+const struct heap_stat *heap_stat(uint8_t type);
+
+/// Dump statistics of all heaps via debug
+void heap_stat_dump(void);
+#endif //(HEAP_STAT)
+
+#endif // APP_HEAP_H_
@@ -0,0 +1,733 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_l2cc.c
+ *
+ * @brief App SubTask of L2CAP Message - LE Credit Based Channel(LECB) Stream Service
+ *
+ *  One channel per link, stream data kept in pool blocks(LECB_MPS bytes each):
+ *    - TX: written into channel's block chain, packed into SDUs(<= peer MTU) as peer
+ *          credits allowed, blocks freed once copied into L2CC_LECB_SDU_SEND_CMD.
+ *    - RX: SDU reassembled by L2CC, appended to channel's block chain. Credits given to
+ *          peer no more than free blocks, so one credit(K-frame) always has one block.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "app.h"
+#include "l2cc.h"
+#include "app_l2cc.h"
+
+#if (L2CC_LECB)
+
+#if (DBG_L2CC)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+#define BLK_NONE              (0xFF)
+
+#if (LECB_BLK_NB >= BLK_NONE)
+#error "LECB_BLK_NB too large"
+#endif
+
+/// Channel state
+enum lecb_state
+{
+    LECB_CLOSED,
+    LECB_CONNECTING,
+    LECB_OPEN,
+};
+
+/// Pool block
+struct lecb_blk
+{
+    /// Bytes in block, up to LECB_MPS(any configured value)
+    uint16_t len;
+    uint8_t  next;
+    uint8_t  data[LECB_MPS];
+};
+
+/// Chain of blocks, stream in order
+struct lecb_chain
+{
+    uint8_t  head;
+    uint8_t  tail;
+    /// Read offset in head block
+    uint16_t pos;
+    /// Total bytes in chain
+    uint16_t len;
+};
+
+/// Channel of link
+struct lecb_chan
+{
+    uint8_t  state;
+    /// SDUs sent but not completed
+    uint8_t  tx_pend;
+    uint16_t local_cid;
+    uint16_t peer_mtu;
+    uint16_t peer_mps;
+    /// Credits of peer to send
+    uint16_t peer_credit;
+    /// Credits given to peer not used yet
+    uint16_t rx_credit;
+
+    struct lecb_chain rx;
+    struct lecb_chain tx;
+    struct lecb_stat stat;
+};
+
+/// LECB environment
+struct lecb_env_tag
+{
+    struct lecb_blk  blk[LECB_BLK_NB];
+    struct lecb_chan chan[BLE_CONNECTION_MAX];
+
+    uint8_t  free_head;
+    uint8_t  free_nb;
+    /// Sum of rx_credit, blocks reserved for peers
+    uint16_t credit_out;
+};
+
+static struct lecb_env_tag lecb_env;
+
+
+/*
+ * POOL FUNCTIONS
+ ****************************************************************************************
+ */
+
+static uint8_t lecb_blk_alloc(void)
+{
+    uint8_t idx = lecb_env.free_head;
+
+    if (idx != BLK_NONE)
+    {
+        lecb_env.free_head = lecb_env.blk[idx].next;
+        lecb_env.free_nb--;
+
+        lecb_env.blk[idx].next = BLK_NONE;
+        lecb_env.blk[idx].len  = 0;
+    }
+
+    return idx;
+}
+
+static void lecb_blk_free(uint8_t idx)
+{
+    lecb_env.blk[idx].next = lecb_env.free_head;
+    lecb_env.free_head = idx;
+    lecb_env.free_nb++;
+}
+
+/// Blocks free and not reserved for peer credits
+static uint8_t lecb_blk_spare(void)
+{
+    return (lecb_env.free_nb > lecb_env.credit_out) ? (lecb_env.free_nb - lecb_env.credit_out) : 0;
+}
+
+/// Append data to chain, use reserved blocks if rsvd, return length appended
+static uint16_t lecb_chain_put(struct lecb_chain *chain, const uint8_t *data, uint16_t len, bool rsvd)
+{
+    uint16_t done = 0;
+
+    while (done < len)
+    {
+        struct lecb_blk *blk = (chain->tail != BLK_NONE) ? &lecb_env.blk[chain->tail] : NULL;
+
+        if ((blk == NULL) || (blk->len == LECB_MPS))
+        {
+            uint8_t idx;
+
+            if (!rsvd && (lecb_blk_spare() == 0))
+            {
+                break;
+            }
+
+            idx = lecb_blk_alloc();
+            if (idx == BLK_NONE)
+            {
+                break;
+            }
+
+            if (chain->tail == BLK_NONE)
+            {
+                chain->head = idx;
+            }
+            else
+            {
+                blk->next = idx;
+            }
+
+            chain->tail = idx;
+            blk = &lecb_env.blk[idx];
+        }
+
+        uint16_t cpy = LECB_MPS - blk->len;
+
+        if (cpy > len - done)
+        {
+            cpy = len - done;
+        }
+
+        memcpy(&blk->data[blk->len], data + done, cpy);
+        blk->len += cpy;
+        done += cpy;
+    }
+
+    chain->len += done;
+    return done;
+}
+
+/// Remove data from head of chain, free emptied blocks, return length removed
+static uint16_t lecb_chain_get(struct lecb_chain *chain, uint8_t *buff, uint16_t len)
+{
+    uint16_t done = 0;
+
+    while ((done < len) && (chain->head != BLK_NONE))
+    {
+        uint8_t idx = chain->head;
+        struct lecb_blk *blk = &lecb_env.blk[idx];
+        uint16_t cpy = blk->len - chain->pos;
+
+        if (cpy > len - done)
+        {
+            cpy = len - done;
+        }
+
+        memcpy(buff + done, &blk->data[chain->pos], cpy);
+        chain->pos += cpy;
+        done += cpy;
+
+        if (chain->pos == blk->len)
+        {
+            chain->head = blk->next;
+            chain->pos  = 0;
+
+            if (chain->head == BLK_NONE)
+            {
+                chain->tail = BLK_NONE;
+            }
+
+            lecb_blk_free(idx);
+        }
+    }
+
+    chain->len -= done;
+    return done;
+}
+
+static void lecb_chain_clear(struct lecb_chain *chain)
+{
+    while (chain->head != BLK_NONE)
+    {
+        uint8_t idx = chain->head;
+
+        chain->head = lecb_env.blk[idx].next;
+        lecb_blk_free(idx);
+    }
+
+    chain->tail = BLK_NONE;
+    chain->pos  = 0;
+    chain->len  = 0;
+}
+
+
+/*
+ * CHANNEL FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void lecb_chan_reset(uint8_t conidx)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+    lecb_env.credit_out -= chan->rx_credit;
+    lecb_chain_clear(&chan->rx);
+    lecb_chain_clear(&chan->tx);
+
+    chan->state       = LECB_CLOSED;
+    chan->tx_pend     = 0;
+    chan->peer_credit = 0;
+    chan->rx_credit   = 0;
+}
+
+/// Credits to give peer, bounded by spare blocks
+static uint16_t lecb_credit_take(struct lecb_chan *chan)
+{
+    uint16_t credit = LECB_RX_CREDIT_MAX - chan->rx_credit;
+    uint8_t  spare  = lecb_blk_spare();
+
+    if (credit > spare)
+    {
+        credit = spare;
+    }
+
+    chan->rx_credit     += credit;
+    lecb_env.credit_out += credit;
+
+    return credit;
+}
+
+/// Give credits back to peers as blocks freed
+static void lecb_credit_give(void)
+{
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+        // batch credits, unless peer has none
+        if ((chan->state != LECB_OPEN)
+            || ((chan->rx_credit > 0) && (chan->rx_credit * 2 > LECB_RX_CREDIT_MAX)))
+        {
+            continue;
+        }
+
+        uint16_t credit = lecb_credit_take(chan);
+
+        if (credit > 0)
+        {
+            struct l2cc_lecb_add_cmd *cmd = KE_MSG_ALLOC(L2CC_LECB_ADD_CMD, TASK_BUILD(TASK_L2CC, conidx),
+                                                         TASK_APP, l2cc_lecb_add_cmd);
+
+            cmd->operation = L2CC_LECB_CREDIT_ADD;
+            cmd->pkt_id    = 0;
+            cmd->local_cid = chan->local_cid;
+            cmd->credit    = credit;
+            ke_msg_send(cmd);
+        }
+    }
+}
+
+/// Pack stream into SDUs as peer credits allowed
+static void lecb_tx_pump(uint8_t conidx)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+    bool freed = false;
+
+    while ((chan->state == LECB_OPEN) && (chan->tx.len > 0) && (chan->tx_pend < LECB_TX_WIN))
+    {
+        uint16_t sdu_max = (chan->peer_mtu < LECB_SDU_MAX) ? chan->peer_mtu : LECB_SDU_MAX;
+        uint16_t sdu_len = (chan->tx.len < sdu_max) ? chan->tx.len : sdu_max;
+        uint16_t credit  = (sdu_len + 2 + chan->peer_mps - 1) / chan->peer_mps;
+
+        if (credit > chan->peer_credit)
+        {
+            // shorter SDU with credits left, first K-frame carries 2 bytes SDU length
+            if (chan->peer_credit * chan->peer_mps <= 2)
+            {
+                chan->stat.tx_stalls++;
+                break;
+            }
+
+            credit  = chan->peer_credit;
+            sdu_len = credit * chan->peer_mps - 2;
+        }
+
+        struct l2cc_lecb_sdu_send_cmd *cmd = KE_MSG_ALLOC_DYN(L2CC_LECB_SDU_SEND_CMD, TASK_BUILD(TASK_L2CC, conidx),
+                                                              TASK_APP, l2cc_lecb_sdu_send_cmd, sdu_len);
+
+        cmd->operation  = L2CC_LECB_SDU_SEND;
+        cmd->offset     = 0;
+        cmd->sdu.cid    = chan->local_cid;
+        cmd->sdu.credit = credit;
+        cmd->sdu.length = lecb_chain_get(&chan->tx, cmd->sdu.data, sdu_len);
+        ke_msg_send(cmd);
+
+        chan->peer_credit -= credit;
+        chan->tx_pend++;
+        chan->stat.tx_bytes += sdu_len;
+        chan->stat.tx_sdus++;
+        freed = true;
+    }
+
+    if (freed)
+    {
+        lecb_credit_give();
+    }
+}
+
+
+/*
+ * MESSAGE HANDLERS
+ ****************************************************************************************
+ */
+
+APP_MSG_HANDLER(l2cc_cmp_evt)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+    if (param->operation == L2CC_LECB_SDU_SEND)
+    {
+        if (chan->tx_pend > 0)
+        {
+            chan->tx_pend--;
+        }
+
+        lecb_tx_pump(conidx);
+    }
+    else if ((param->operation == L2CC_LECB_CONNECT) && (param->status != GAP_ERR_NO_ERROR)
+             && (chan->state == LECB_CONNECTING))
+    {
+        lecb_chan_reset(conidx);
+        lecb_cb_conn(conidx, param->status);
+    }
+
+    if (param->status != GAP_ERR_NO_ERROR)
+    {
+        DEBUG("cmp_evt(cid:%d,op:%d,sta:0x%X)", conidx, param->operation, param->status);
+    }
+}
+
+APP_MSG_HANDLER(l2cc_lecb_connect_req_ind)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+    struct l2cc_lecb_connect_cfm *cfm = KE_MSG_ALLOC(L2CC_LECB_CONNECT_CFM, src_id, TASK_APP, l2cc_lecb_connect_cfm);
+
+    DEBUG("connect_req(cid:%d,psm:0x%X,mtu:%d,mps:%d)", conidx, param->le_psm, param->peer_mtu, param->peer_mps);
+
+    cfm->peer_cid  = param->peer_cid;
+    cfm->local_cid = 0;
+    cfm->local_mtu = LECB_SDU_MAX;
+    cfm->local_mps = LECB_MPS;
+    cfm->accept    = false;
+
+    if ((param->le_psm == LECB_LE_PSM) && (chan->state == LECB_CLOSED))
+    {
+        cfm->local_credit = lecb_credit_take(chan);
+
+        if (cfm->local_credit > 0)
+        {
+            chan->state    = LECB_CONNECTING;
+            chan->peer_mtu = param->peer_mtu;
+            chan->peer_mps = param->peer_mps;
+            cfm->accept    = true;
+        }
+    }
+
+    ke_msg_send(cfm);
+}
+
+APP_MSG_HANDLER(l2cc_lecb_connect_ind)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+    DEBUG("connect_ind(cid:%d,sta:0x%X,lcid:0x%X,credit:%d,mtu:%d,mps:%d)", conidx, param->status,
+          param->local_cid, param->peer_credit, param->peer_mtu, param->peer_mps);
+
+    if (chan->state != LECB_CONNECTING)
+    {
+        return;
+    }
+
+    if (param->status == GAP_ERR_NO_ERROR)
+    {
+        chan->state       = LECB_OPEN;
+        chan->local_cid   = param->local_cid;
+        chan->peer_credit = param->peer_credit;
+        chan->peer_mtu    = param->peer_mtu;
+        chan->peer_mps    = param->peer_mps;
+        memset(&chan->stat, 0, sizeof(struct lecb_stat));
+    }
+    else
+    {
+        lecb_chan_reset(conidx);
+    }
+
+    lecb_cb_conn(conidx, param->status);
+}
+
+APP_MSG_HANDLER(l2cc_lecb_disconnect_ind)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+
+    DEBUG("disconnect_ind(cid:%d,reason:0x%X)", conidx, param->reason);
+
+    lecb_chan_reset(conidx);
+    lecb_cb_disc(conidx, param->reason);
+    // blocks freed, more credits for others
+    lecb_credit_give();
+}
+
+APP_MSG_HANDLER(l2cc_lecb_add_ind)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+
+    lecb_env.chan[conidx].peer_credit += param->peer_added_credit;
+    lecb_tx_pump(conidx);
+}
+
+APP_MSG_HANDLER(l2cc_lecb_sdu_recv_ind)
+{
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+    uint16_t credit = param->sdu.credit;
+
+    if (chan->state != LECB_OPEN)
+    {
+        return;
+    }
+
+    // credits used, blocks reserved for them available now
+    if (credit > chan->rx_credit)
+    {
+        credit = chan->rx_credit;
+    }
+    chan->rx_credit     -= credit;
+    lecb_env.credit_out -= credit;
+
+    if ((param->status != GAP_ERR_NO_ERROR) || (param->sdu.length == 0))
+    {
+        DEBUG("sdu_recv(cid:%d,sta:0x%X,len:%d)", conidx, param->status, param->sdu.length);
+    }
+    else if (lecb_chain_put(&chan->rx, param->sdu.data, param->sdu.length, true) == param->sdu.length)
+    {
+        chan->stat.rx_bytes += param->sdu.length;
+        chan->stat.rx_sdus++;
+
+        lecb_cb_rxd(conidx, param->sdu.length);
+    }
+    else
+    {
+        // never happen with credits bounded by blocks, drop whole stream to resync
+        chan->stat.rx_drops++;
+        lecb_chain_clear(&chan->rx);
+    }
+
+    lecb_credit_give();
+}
+
+/**
+ ****************************************************************************************
+ * @brief SubTask Handler of L2CAP Message.
+ ****************************************************************************************
+ */
+APP_SUBTASK_HANDLER(l2cc_msg)
+{
+    switch (msgid)
+    {
+        case L2CC_CMP_EVT:
+        {
+            APP_MSG_FUNCTION(l2cc_cmp_evt);
+        } break;
+
+        case L2CC_LECB_CONNECT_REQ_IND:
+        {
+            APP_MSG_FUNCTION(l2cc_lecb_connect_req_ind);
+        } break;
+
+        case L2CC_LECB_CONNECT_IND:
+        {
+            APP_MSG_FUNCTION(l2cc_lecb_connect_ind);
+        } break;
+
+        case L2CC_LECB_DISCONNECT_IND:
+        {
+            APP_MSG_FUNCTION(l2cc_lecb_disconnect_ind);
+        } break;
+
+        case L2CC_LECB_ADD_IND:
+        {
+            APP_MSG_FUNCTION(l2cc_lecb_add_ind);
+        } break;
+
+        case L2CC_LECB_SDU_RECV_IND:
+        {
+            APP_MSG_FUNCTION(l2cc_lecb_sdu_recv_ind);
+        } break;
+
+        default:
+        {
+            DEBUG("Unknow MsgId:0x%X", msgid);
+        } break;
+    }
+
+    return (MSG_STATUS_FREE);
+}
+
+
+/*
+ * API FUNCTIONS
+ ****************************************************************************************
+ */
+
+void lecb_init(void)
+{
+    memset(&lecb_env, 0, sizeof(lecb_env));
+
+    // all blocks free, all chains empty
+    for (uint8_t idx = 0; idx < LECB_BLK_NB; idx++)
+    {
+        lecb_env.blk[idx].next = idx + 1;
+    }
+    lecb_env.blk[LECB_BLK_NB - 1].next = BLK_NONE;
+    lecb_env.free_nb = LECB_BLK_NB;
+
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        lecb_env.chan[conidx].rx.head = lecb_env.chan[conidx].rx.tail = BLK_NONE;
+        lecb_env.chan[conidx].tx.head = lecb_env.chan[conidx].tx.tail = BLK_NONE;
+    }
+
+    struct gapm_lepsm_register_cmd *cmd = KE_MSG_ALLOC(GAPM_LEPSM_REGISTER_CMD, TASK_ID(GAPM, 0),
+                                                       TASK_APP, gapm_lepsm_register_cmd);
+
+    cmd->operation = GAPM_LEPSM_REG;
+    cmd->le_psm    = LECB_LE_PSM;
+    cmd->app_task  = TASK_APP;
+    cmd->sec_lvl   = LECB_SEC_LVL;
+    ke_msg_send(cmd);
+}
+
+void lecb_connect(uint8_t conidx)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+    if (chan->state != LECB_CLOSED)
+    {
+        return;
+    }
+
+    struct l2cc_lecb_connect_cmd *cmd = KE_MSG_ALLOC(L2CC_LECB_CONNECT_CMD, TASK_BUILD(TASK_L2CC, conidx),
+                                                     TASK_APP, l2cc_lecb_connect_cmd);
+
+    chan->state = LECB_CONNECTING;
+
+    cmd->operation    = L2CC_LECB_CONNECT;
+    cmd->pkt_id       = 0;
+    cmd->le_psm       = LECB_LE_PSM;
+    cmd->local_cid    = 0;
+    cmd->local_credit = lecb_credit_take(chan);
+    cmd->local_mtu    = LECB_SDU_MAX;
+    cmd->local_mps    = LECB_MPS;
+    ke_msg_send(cmd);
+}
+
+void lecb_disconnect(uint8_t conidx)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+
+    if (chan->state != LECB_OPEN)
+    {
+        return;
+    }
+
+    struct l2cc_lecb_disconnect_cmd *cmd = KE_MSG_ALLOC(L2CC_LECB_DISCONNECT_CMD, TASK_BUILD(TASK_L2CC, conidx),
+                                                        TASK_APP, l2cc_lecb_disconnect_cmd);
+
+    cmd->operation = L2CC_LECB_DISCONNECT;
+    cmd->pkt_id    = 0;
+    cmd->local_cid = chan->local_cid;
+    ke_msg_send(cmd);
+}
+
+void lecb_conn_lost(uint8_t conidx)
+{
+    if (lecb_env.chan[conidx].state != LECB_CLOSED)
+    {
+        lecb_chan_reset(conidx);
+        lecb_credit_give();
+    }
+}
+
+bool lecb_is_open(uint8_t conidx)
+{
+    return (lecb_env.chan[conidx].state == LECB_OPEN);
+}
+
+uint16_t lecb_write(uint8_t conidx, uint16_t len, const uint8_t *data)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+    uint16_t done;
+
+    if (chan->state != LECB_OPEN)
+    {
+        return 0;
+    }
+
+    done = lecb_chain_put(&chan->tx, data, len, false);
+    lecb_tx_pump(conidx);
+
+    return done;
+}
+
+uint16_t lecb_tx_avail(uint8_t conidx)
+{
+    struct lecb_chan *chan = &lecb_env.chan[conidx];
+    uint16_t avail;
+
+    if (chan->state != LECB_OPEN)
+    {
+        return 0;
+    }
+
+    avail = lecb_blk_spare() * LECB_MPS;
+    if (chan->tx.tail != BLK_NONE)
+    {
+        avail += LECB_MPS - lecb_env.blk[chan->tx.tail].len;
+    }
+
+    return avail;
+}
+
+uint16_t lecb_read(uint8_t conidx, uint16_t len, uint8_t *buff)
+{
+    uint16_t done = lecb_chain_get(&lecb_env.chan[conidx].rx, buff, len);
+
+    if (done > 0)
+    {
+        lecb_credit_give();
+    }
+
+    return done;
+}
+
+uint16_t lecb_rx_len(uint8_t conidx)
+{
+    return lecb_env.chan[conidx].rx.len;
+}
+
+const struct lecb_stat *lecb_stat(uint8_t conidx)
+{
+    return &lecb_env.chan[conidx].stat;
+}
+
+__WEAK void lecb_cb_conn(uint8_t conidx, uint8_t status)
+{
+    (void)conidx;(void)status;
+}
+
+__WEAK void lecb_cb_disc(uint8_t conidx, uint8_t reason)
+{
+    (void)conidx;(void)reason;
+}
+
+__WEAK void lecb_cb_rxd(uint8_t conidx, uint16_t len)
+{
+    // default drain, user read via lecb_read()
+    uint8_t buff[32];
+
+    (void)len;
+    while (lecb_read(conidx, sizeof(buff), buff) > 0);
+}
+
+#endif //(L2CC_LECB)
@@ -0,0 +1,163 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_l2cc.h
+ *
+ * @brief Header file - L2CAP LE Credit Based Channel(LECB) Stream Service.
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_L2CC_H_
+#define APP_L2CC_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of LECB, also route TID_L2CC messages @see app_msg.c
+#if !defined(L2CC_LECB)
+    #define L2CC_LECB                (0)
+#endif
+
+/// LE Protocol/Service Multiplexer, dynamic range 0x0080~0x00FF
+#if !defined(LECB_LE_PSM)
+    #define LECB_LE_PSM              (0x0080)
+#endif
+
+/// Security level of channel @see enum gapm_le_psm_sec_mask
+#if !defined(LECB_SEC_LVL)
+    #define LECB_SEC_LVL             (0)
+#endif
+
+/// Max SDU size of both directions, SDU of stream no more than it
+#if !defined(LECB_SDU_MAX)
+    #define LECB_SDU_MAX             (512)
+#endif
+
+/// Max PDU payload(K-frame), fit one LL packet by default
+#if !defined(LECB_MPS)
+    #define LECB_MPS                 (LE_MAX_OCTETS - 4)
+#endif
+
+/// Number of pool blocks(LECB_MPS bytes each), shared by RX and TX of all channels
+#if !defined(LECB_BLK_NB)
+    #define LECB_BLK_NB              (16)
+#endif
+
+/// Credits at most given to peer, enough for one full SDU
+#define LECB_RX_CREDIT_MAX           (((LECB_SDU_MAX + 2) + (LECB_MPS - 1)) / LECB_MPS + 1)
+
+/// SDUs in flight of each channel
+#if !defined(LECB_TX_WIN)
+    #define LECB_TX_WIN              (2)
+#endif
+
+/// Statistics of channel
+struct lecb_stat
+{
+    uint32_t tx_bytes;
+    uint32_t tx_sdus;
+    uint32_t rx_bytes;
+    uint32_t rx_sdus;
+    /// Times TX waited for peer credits
+    uint32_t tx_stalls;
+    /// SDUs received without enough blocks, should not happen
+    uint32_t rx_drops;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (L2CC_LECB)
+/**
+ ****************************************************************************************
+ * @brief Register LECB_LE_PSM to accept channels, called after BLE_CONFIGURED.
+ ****************************************************************************************
+ */
+void lecb_init(void);
+
+/**
+ ****************************************************************************************
+ * @brief Open channel on link to peer's LECB_LE_PSM, result via lecb_cb_conn().
+ *
+ * @param[in] conidx  connection index
+ ****************************************************************************************
+ */
+void lecb_connect(uint8_t conidx);
+
+/// Close channel on link, result via lecb_cb_disc()
+void lecb_disconnect(uint8_t conidx);
+
+/// Reset channel when link lost, called in app_gapc.c
+void lecb_conn_lost(uint8_t conidx);
+
+/// Channel opened on link
+bool lecb_is_open(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Write stream data, packed into SDUs as peer credits allowed.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] len     length of data
+ * @param[in] data    pointer of data
+ *
+ * @return Length accepted, less than len when pool short.
+ ****************************************************************************************
+ */
+uint16_t lecb_write(uint8_t conidx, uint16_t len, const uint8_t *data);
+
+/// Bytes able to write now
+uint16_t lecb_tx_avail(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Read stream data received, credits given back to peer as blocks freed.
+ *
+ * @param[in]  conidx  connection index
+ * @param[in]  len     length of buffer
+ * @param[out] buff    pointer of buffer
+ *
+ * @return Length read.
+ ****************************************************************************************
+ */
+uint16_t lecb_read(uint8_t conidx, uint16_t len, uint8_t *buff);
+
+/// Bytes able to read now
+uint16_t lecb_rx_len(uint8_t conidx);
+
+/// Statistics of channel, reset when opened
+const struct lecb_stat *lecb_stat(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Callback of channel opened or failed (__WEAK func)
+ *
+ * @param[in] conidx  connection index
+ * @param[in] status  status @see le_err
+ ****************************************************************************************
+ */
+void lecb_cb_conn(uint8_t conidx, uint8_t status);
+
+/// Callback of channel closed (__WEAK func)
+void lecb_cb_disc(uint8_t conidx, uint8_t reason);
+
+/// Callback of SDU received, read via lecb_read() (__WEAK func)
+void lecb_cb_rxd(uint8_t conidx, uint16_t len);
+#endif //(L2CC_LECB)
+
+#endif // APP_L2CC_H_
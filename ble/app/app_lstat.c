@@ -0,0 +1,287 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_lstat.c
+ *
+ * @brief Link Statistics of each connection - Example
+ *
+ *  Counters bumped in message handlers already running(no timer, no extra message):
+ *    - GAPC events: param, DLE, PHY and RSSI in use, link up/down
+ *    - Profiles: notification given to stack, refused, and its ATTS_CMP_EVT
+ *  Time and connection events folded only on query or param change, one division each.
+ *  Service time of notification(ready to completed) over 2 intervals counted as slow,
+ *  stack hides retransmissions, so slow ones hint of NAKs or poor link.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "app_lstat.h"
+
+#if (LINK_STAT)
+
+#if (DBG_LSTAT)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (LINK_STAT_INFLIGHT & (LINK_STAT_INFLIGHT - 1)) || (LINK_STAT_INFLIGHT > 128)
+#error "LINK_STAT_INFLIGHT must be power of 2, no more than 128"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Fold time on completion if not queried long, far before counter wrapped
+#define LSTAT_FOLD_HS         (0x04000000)
+
+/// Gap of completions(half-slot) to split connection events
+#define LSTAT_EVT_GAP         (4)
+
+/// Link environment
+struct lstat_link
+{
+    struct lstat_blk blk;
+
+    /// Time of last fold, half-slot not yet folded into up_ms and conn_evts
+    uint32_t fold_time;
+    uint32_t up_hs;
+    uint32_t evt_hs;
+    /// Time of last completion
+    uint32_t cmp_time;
+    /// Ready time of oldest notifications in flight
+    uint32_t rdy_time[LINK_STAT_INFLIGHT];
+    uint8_t  rdy_head;
+    uint8_t  rdy_cnt;
+    bool     active;
+};
+
+static struct lstat_link lstat_env[BLE_CONNECTION_MAX];
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+/// Fold time elapsed into up_ms and conn_evts with interval in use
+static void lstat_fold(struct lstat_link *lk, uint32_t now)
+{
+    uint32_t diff = BLE_TIME_DIFF(now, lk->fold_time);
+
+    lk->fold_time = now;
+    lk->up_hs  += diff;
+    lk->evt_hs += diff;
+
+    // 16 half-slots exactly 5ms
+    lk->blk.up_ms += ble_time_fold(&lk->up_hs, 16) * 5;
+
+    if (lk->blk.intv)
+    {
+        lk->blk.conn_evts += ble_time_fold(&lk->evt_hs, BLE_INTV2HS(lk->blk.intv));
+    }
+}
+
+void lstat_conn_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out)
+{
+    struct lstat_link *lk = &lstat_env[conidx];
+
+    memset(lk, 0, sizeof(struct lstat_link));
+
+    lk->fold_time = lk->cmp_time = ble_time_get();
+    lk->active = true;
+
+    lk->blk.intv      = intv;
+    lk->blk.latency   = latency;
+    lk->blk.time_out  = time_out;
+    lk->blk.tx_octets = LE_MIN_OCTETS;
+    lk->blk.rx_octets = LE_MIN_OCTETS;
+    lk->blk.tx_phy    = GAP_PHY_LE_1MBPS;
+    lk->blk.rx_phy    = GAP_PHY_LE_1MBPS;
+}
+
+void lstat_conn_lost(uint8_t conidx, uint8_t reason)
+{
+    struct lstat_link *lk = &lstat_env[conidx];
+
+    if (lk->active)
+    {
+        lstat_fold(lk, ble_time_get());
+
+        lk->active = false;
+        lk->blk.reason = reason;
+        // not completed any more
+        lk->blk.ntf_fail += lk->blk.inflight;
+        lk->blk.inflight = 0;
+        lk->rdy_cnt = 0;
+
+        lstat_dump(conidx);
+    }
+}
+
+void lstat_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out)
+{
+    struct lstat_link *lk = &lstat_env[conidx];
+
+    // events so far with old interval
+    lstat_fold(lk, ble_time_get());
+
+    lk->blk.intv     = intv;
+    lk->blk.latency  = latency;
+    lk->blk.time_out = time_out;
+    lk->blk.param_upd++;
+}
+
+void lstat_dle_ind(uint8_t conidx, uint16_t tx_octets, uint16_t rx_octets)
+{
+    lstat_env[conidx].blk.tx_octets = tx_octets;
+    lstat_env[conidx].blk.rx_octets = rx_octets;
+}
+
+void lstat_phy_ind(uint8_t conidx, uint8_t tx_phy, uint8_t rx_phy)
+{
+    lstat_env[conidx].blk.tx_phy = tx_phy;
+    lstat_env[conidx].blk.rx_phy = rx_phy;
+    lstat_env[conidx].blk.phy_upd++;
+}
+
+void lstat_rssi_ind(uint8_t conidx, int8_t rssi)
+{
+    lstat_env[conidx].blk.rssi = rssi;
+}
+
+void lstat_ntf_queued(uint8_t conidx)
+{
+    struct lstat_link *lk = &lstat_env[conidx];
+
+    // track ready time only of oldest in order, newer ones timed from last completion
+    if ((lk->rdy_cnt == lk->blk.inflight) && (lk->rdy_cnt < LINK_STAT_INFLIGHT))
+    {
+        lk->rdy_time[(lk->rdy_head + lk->rdy_cnt) & (LINK_STAT_INFLIGHT - 1)] = ble_time_get();
+        lk->rdy_cnt++;
+    }
+
+    lk->blk.ntf_queued++;
+    if (++lk->blk.inflight > lk->blk.inflight_max)
+    {
+        lk->blk.inflight_max = lk->blk.inflight;
+    }
+}
+
+void lstat_ntf_busy(uint8_t conidx)
+{
+    lstat_env[conidx].blk.ntf_busy++;
+}
+
+void lstat_ntf_cmp(uint8_t conidx, uint8_t status)
+{
+    struct lstat_link *lk = &lstat_env[conidx];
+    uint32_t now, svc;
+
+    if (lk->blk.inflight == 0)
+    {
+        // late of lost link
+        return;
+    }
+
+    now = ble_time_get();
+    svc = BLE_TIME_DIFF(now, lk->cmp_time);
+
+    // completed in new connection event
+    if (svc > LSTAT_EVT_GAP)
+    {
+        lk->blk.data_evts++;
+    }
+
+    // ready when sent or previous completed, the later one
+    if (lk->rdy_cnt)
+    {
+        uint32_t rdy = BLE_TIME_DIFF(now, lk->rdy_time[lk->rdy_head]);
+
+        if (rdy < svc)
+            svc = rdy;
+
+        lk->rdy_head = (lk->rdy_head + 1) & (LINK_STAT_INFLIGHT - 1);
+        lk->rdy_cnt--;
+    }
+
+    if ((svc >> 2) > lk->blk.svc_max)
+    {
+        lk->blk.svc_max = (svc >> 2);
+    }
+
+    if (svc > 2 * BLE_INTV2HS(lk->blk.intv))
+    {
+        lk->blk.ntf_slow++;
+    }
+
+    if (status == LE_SUCCESS)
+        lk->blk.ntf_sent++;
+    else
+        lk->blk.ntf_fail++;
+
+    lk->blk.inflight--;
+    lk->cmp_time = now;
+
+    if (BLE_TIME_DIFF(now, lk->fold_time) > LSTAT_FOLD_HS)
+    {
+        lstat_fold(lk, now);
+    }
+}
+
+void lstat_rssi_req(uint8_t conidx)
+{
+    if (lstat_env[conidx].active)
+    {
+        gapc_get_info(conidx, GAPC_GET_CON_RSSI);
+    }
+}
+
+const struct lstat_blk *lstat_get(uint8_t conidx)
+{
+    struct lstat_link *lk;
+
+    if (conidx >= BLE_CONNECTION_MAX)
+    {
+        return NULL;
+    }
+
+    lk = &lstat_env[conidx];
+
+    if (lk->active)
+    {
+        lstat_fold(lk, ble_time_get());
+        lk->blk.mtu = gatt_get_mtu(conidx);
+    }
+
+    return &lk->blk;
+}
+
+void lstat_dump(uint8_t conidx)
+{
+    #if (DBG_LSTAT)
+    const struct lstat_blk *blk = lstat_get(conidx);
+
+    if (blk)
+    {
+        DEBUG("lstat(cid:%d,up:%"PRIu32"ms,evt:%"PRIu32"/%"PRIu32",intv:%d,late:%d,mtu:%d,dle:%d/%d,phy:%d/%d,"
+              "rssi:%d,rsn:0x%X)", conidx,
+              blk->up_ms, blk->data_evts, blk->conn_evts, blk->intv, blk->latency, blk->mtu,
+              blk->tx_octets, blk->rx_octets, blk->tx_phy, blk->rx_phy, blk->rssi, blk->reason);
+        DEBUG("    ntf(que:%"PRIu32",sent:%"PRIu32",fail:%d,busy:%d,slow:%d,svc_max:%d,fly:%d/%d),upd(param:%d,phy:%d)",
+              blk->ntf_queued, blk->ntf_sent, blk->ntf_fail, blk->ntf_busy, blk->ntf_slow, blk->svc_max,
+              blk->inflight, blk->inflight_max, blk->param_upd, blk->phy_upd);
+    }
+    #else
+    (void)conidx;
+    #endif
+}
+
+#endif //(LINK_STAT)
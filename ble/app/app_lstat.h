@@ -0,0 +1,126 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_lstat.h
+ *
+ * @brief Header file - Link Statistics of each connection(Notifications, Events, MTU/PHY).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_LSTAT_H_
+#define APP_LSTAT_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Statistics, counted by app_gapc.c, prf_sess.c and prf_hids.c
+#if !defined(LINK_STAT)
+    #define LINK_STAT                (0)
+#endif
+
+/// Vendor characteristic in Serial Service(UUID 0xFF04) to read block of link @see prf_sess.c
+#if !defined(LINK_STAT_CHAR)
+    #define LINK_STAT_CHAR           (0)
+#endif
+
+/// Notifications in flight tracked of each link, power of 2
+#if !defined(LINK_STAT_INFLIGHT)
+    #define LINK_STAT_INFLIGHT       (8)
+#endif
+
+/// Block of link, layout(little endian, no padding) is also value of LINK_STAT_CHAR
+struct lstat_blk
+{
+    /// Time connected, unit in 1ms
+    uint32_t up_ms;
+    /// Connection events elapsed, estimated by interval in use
+    uint32_t conn_evts;
+    /// Notifications given to stack, and completed with success
+    uint32_t ntf_queued;
+    uint32_t ntf_sent;
+    /// Connection events carried notifications, completions split by time gap
+    uint32_t data_evts;
+
+    /// Notifications completed with error, and refused(no buffer or CCC disabled)
+    uint16_t ntf_fail;
+    uint16_t ntf_busy;
+    /// Completed later than 2 intervals after ready, hint of retransmission
+    uint16_t ntf_slow;
+    /// Max time from ready to completed, unit in 1.25ms
+    uint16_t svc_max;
+    /// Connection param in use(interval unit in 1.25ms, timeout in 10ms)
+    uint16_t intv;
+    uint16_t latency;
+    uint16_t time_out;
+    /// MTU and DLE octets in use
+    uint16_t mtu;
+    uint16_t tx_octets;
+    uint16_t rx_octets;
+
+    /// PHY in use @see enum gap_phy
+    uint8_t  tx_phy;
+    uint8_t  rx_phy;
+    /// RSSI of last lstat_rssi_req(), unit in dBm
+    int8_t   rssi;
+    /// Number of param and PHY updated
+    uint8_t  param_upd;
+    uint8_t  phy_upd;
+    /// Notifications in flight now, and the most ever
+    uint8_t  inflight;
+    uint8_t  inflight_max;
+    /// Reason of disconnection, 0 if connected
+    uint8_t  reason;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (LINK_STAT)
+/// Feed of GAPC events, called in app_gapc.c
+void lstat_conn_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out);
+void lstat_conn_lost(uint8_t conidx, uint8_t reason);
+void lstat_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out);
+void lstat_dle_ind(uint8_t conidx, uint16_t tx_octets, uint16_t rx_octets);
+void lstat_phy_ind(uint8_t conidx, uint8_t tx_phy, uint8_t rx_phy);
+void lstat_rssi_ind(uint8_t conidx, int8_t rssi);
+
+/// Feed of notifications, called in profiles: given to stack, refused, and ATTS_CMP_EVT
+void lstat_ntf_queued(uint8_t conidx);
+void lstat_ntf_busy(uint8_t conidx);
+void lstat_ntf_cmp(uint8_t conidx, uint8_t status);
+
+/// Request RSSI of link, result in 'rssi' of block
+void lstat_rssi_req(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Get block of link, time and events brought up to date.
+ *        Kept after link lost(reason set) until next connection of same index.
+ *
+ * @param[in] conidx  connection index
+ *
+ * @return Pointer of block, NULL if index invalid.
+ ****************************************************************************************
+ */
+const struct lstat_blk *lstat_get(uint8_t conidx);
+
+/// Dump block of link via debug(DBG_LSTAT)
+void lstat_dump(uint8_t conidx);
+#endif //(LINK_STAT)
+
+#endif // APP_LSTAT_H_
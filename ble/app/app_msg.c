@@ -10,7 +10,9 @@
  */
 
 #include "app.h"
+#include "app_msg.h"
 #include "drvs.h"
+#include "bledef.h"
 
 #if (DBG_APP)
 #include "dbg.h"
@@ -61,6 +63,25 @@ __WEAK APP_SUBTASK_HANDLER(custom)
     return (MSG_STATUS_FREE);
 }
 
+/// SubTask of message type(TID_xxx), absent ones to app_custom_handler
+static const msg_func_t app_subtask_table[] =
+{
+    [TID_GAPM] = app_gapm_msg_handler,
+    [TID_GAPC] = app_gapc_msg_handler,
+
+    #if (GATT_CLI)
+    [TID_GATT] = app_gatt_msg_handler,
+    #endif
+
+    #if (L2CC_LECB)
+    [TID_L2CC] = app_l2cc_msg_handler,
+    #endif
+
+    #if (PRF_MESH)
+    [TID_MESH] = app_mesh_msg_handler,
+    #endif
+};
+
 /**
  ****************************************************************************************
  * @brief Dispatch TASK_APP message to sub-handler.
@@ -76,39 +97,83 @@ __TASKFN void* app_task_dispatch(msg_id_t msgid, uint8_t task_idx)
     (void)task_idx;
     msg_func_t handler = NULL;
 
-    switch (MSG_TYPE(msgid))
+    if (MSG_TYPE(msgid) < sizeof(app_subtask_table) / sizeof(msg_func_t))
     {
-        case (TID_GAPM):
-            handler = app_gapm_msg_handler;
-            break;
+        handler = app_subtask_table[MSG_TYPE(msgid)];
+    }
 
-        case (TID_GAPC):
-            handler = app_gapc_msg_handler;
-            break;
+    if (handler == NULL)
+    {
+        handler = app_custom_handler;
+    }
 
-        #if (GATT_CLI)
-        case (TID_GATT):
-            handler = app_gatt_msg_handler;
-            break;
-        #endif
+    return handler;
+}
 
-        #if (L2CC_LECB)
-        case (TID_L2CC):
-            handler = app_l2cc_msg_handler;
-            break;
-        #endif
+#if (APP_MSG_STAT)
+static struct app_msg_stat msg_stat[APP_MSG_STAT_NB];
+static uint8_t  msg_stat_nb;
+/// Dispatched when entries full
+static uint32_t msg_stat_miss;
+
+uint32_t app_msg_stat_enter(void)
+{
+    return ble_time_get();
+}
+
+void app_msg_stat_leave(msg_id_t msgid, uint32_t start)
+{
+    uint32_t dur = BLE_TIME_DIFF(ble_time_get(), start);
+    uint8_t bkt = (dur < 2) ? dur : ((dur < 4) ? 2 : 3);
+    uint8_t i;
 
-        #if (PRF_MESH)
-        case TID_MESH:
-            handler = app_mesh_msg_handler;
+    // busy messages first dispatched early, found in few steps
+    for (i = 0; i < msg_stat_nb; i++)
+    {
+        if (msg_stat[i].msgid == msgid)
             break;
-        #endif
+    }
 
-        default:
+    if (i == msg_stat_nb)
+    {
+        if (msg_stat_nb == APP_MSG_STAT_NB)
         {
-            handler = app_custom_handler;
-        } break;
+            msg_stat_miss++;
+            return;
+        }
+
+        msg_stat[i].msgid = msgid;
+        msg_stat_nb++;
     }
 
-    return handler;
+    msg_stat[i].count++;
+    if (msg_stat[i].hist[bkt] < 0xFFFF)
+    {
+        msg_stat[i].hist[bkt]++;
+    }
+}
+
+const struct app_msg_stat *app_msg_stat_get(uint8_t *nb)
+{
+    *nb = msg_stat_nb;
+    return msg_stat;
+}
+
+void app_msg_stat_clear(void)
+{
+    memset(msg_stat, 0, sizeof(msg_stat));
+    msg_stat_nb   = 0;
+    msg_stat_miss = 0;
+}
+
+void app_msg_stat_dump(void)
+{
+    for (uint8_t i = 0; i < msg_stat_nb; i++)
+    {
+        DEBUG("msg 0x%04X(cnt:%"PRIu32",hs:%d/%d/%d/%d)", msg_stat[i].msgid, msg_stat[i].count,
+              msg_stat[i].hist[0], msg_stat[i].hist[1], msg_stat[i].hist[2], msg_stat[i].hist[3]);
+    }
+
+    DEBUG("msg miss:%"PRIu32, msg_stat_miss);
 }
+#endif //(APP_MSG_STAT)
@@ -0,0 +1,122 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_msg.h
+ *
+ * @brief Header file - Table Dispatch of SubTask Messages(optional Statistics).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_MSG_H_
+#define APP_MSG_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "task.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Statistics of messages dispatched via table(count and handler time) @see app_msg.c
+#if !defined(APP_MSG_STAT)
+    #define APP_MSG_STAT             (0)
+#endif
+
+/// Entries of statistics, one for each message id
+#if !defined(APP_MSG_STAT_NB)
+    #define APP_MSG_STAT_NB          (32)
+#endif
+
+/// Buckets of handler time: 0, 1, 2~3, 4~ half-slots(312.5us)
+#define APP_MSG_HIST_NB              (4)
+
+/// Handler in dispatch table, param typed in each APP_MSG_HANDLER
+typedef void (*app_msg_func_t)(msg_id_t msgid, const void *param, task_id_t dest_id, task_id_t src_id);
+
+/// Dispatch table of SubTask indexed by MSG_IDX(msgid), entry absent(NULL) to default of SubTask
+#define APP_MSG_TABLE(sub)           static const app_msg_func_t app_##sub##_table[] =
+#define APP_MSG_ENTRY(id, msg)       [MSG_IDX(id)] = (app_msg_func_t)app_##msg##_handler
+
+/// Call handler of message via table in APP_SUBTASK_HANDLER, false if not in table
+#define APP_MSG_DISPATCH(sub)        app_msg_dispatch(app_##sub##_table,                                \
+                                         sizeof(app_##sub##_table) / sizeof(app_msg_func_t),          \
+                                         msgid, param, dest_id, src_id)
+
+/// Statistics of message
+struct app_msg_stat
+{
+    msg_id_t msgid;
+    uint16_t hist[APP_MSG_HIST_NB];
+    uint32_t count;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (APP_MSG_STAT)
+/// Record of handler called via table, called in app_msg_dispatch()
+uint32_t app_msg_stat_enter(void);
+void app_msg_stat_leave(msg_id_t msgid, uint32_t start);
+
+/**
+ ****************************************************************************************
+ * @brief Get statistics of messages dispatched via table.
+ *
+ * @param[out] nb  number of entries used
+ *
+ * @return Array of entries, in order of first dispatched.
+ ****************************************************************************************
+ */
+const struct app_msg_stat *app_msg_stat_get(uint8_t *nb);
+
+/// Reset statistics
+void app_msg_stat_clear(void);
+
+/// Dump statistics via debug(DBG_APP)
+void app_msg_stat_dump(void);
+#endif //(APP_MSG_STAT)
+
+/**
+ ****************************************************************************************
+ * @brief Dispatch message of SubTask via its table, O(1) by index of message id.
+ *
+ * @param[in] table  table of SubTask @see APP_MSG_TABLE
+ * @param[in] nb     number of entries in table
+ *
+ * @return true if handled, false if not in table(default of SubTask to do).
+ ****************************************************************************************
+ */
+static inline bool app_msg_dispatch(const app_msg_func_t *table, uint16_t nb, msg_id_t msgid,
+                                    const void *param, task_id_t dest_id, task_id_t src_id)
+{
+    app_msg_func_t func = (MSG_IDX(msgid) < nb) ? table[MSG_IDX(msgid)] : NULL;
+
+    if (func == NULL)
+    {
+        return false;
+    }
+
+    #if (APP_MSG_STAT)
+    uint32_t start = app_msg_stat_enter();
+    func(msgid, param, dest_id, src_id);
+    app_msg_stat_leave(msgid, start);
+    #else
+    func(msgid, param, dest_id, src_id);
+    #endif
+
+    return true;
+}
+
+#endif // APP_MSG_H_
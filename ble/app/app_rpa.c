@@ -0,0 +1,362 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_rpa.c
+ *
+ * @brief Resolvable Private Address Cache - Example
+ *
+ *  Each RPA seen in scanning resolved only once by stack(GAPM_RESOLV_ADDR, AES of each
+ *  IRK), result kept in a direct-mapped cache indexed by bytes of the address itself:
+ *    - Identity found: RPA mapped to index of identity
+ *    - Not resolved:   RPA remembered as unknown, devices of others not solved again
+ *  When new RPA of an identity resolved(peer rotated), slot of its old RPA evicted.
+ *  Entries expire after RPA_CACHE_TIME, cache cleared when IRK added or removed.
+ *  Identities saved in flash page(RPA_IRK_OFFSET) and loaded at init, so bonded peers
+ *  found again after reset without new pairing.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "drvs.h"
+#include "app_rpa.h"
+
+#if (RPA_CACHE)
+
+#if (DBG_RPA)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (RPA_CACHE_NB & (RPA_CACHE_NB - 1)) || (RPA_CACHE_NB > 256)
+#error "RPA_CACHE_NB must be power of 2, no more than 256"
+#endif
+
+#if (RPA_IRK_MAX > 127)
+#error "RPA_IRK_MAX no more than 127"
+#endif
+
+#if (RPA_CACHE_TIME > 80000)
+#error "RPA_CACHE_TIME no more than 80000s, half-slot counter wrapped"
+#endif
+
+#if (RPA_IRK_STORE)
+#if (RPA_IRK_OFFSET < 0x1000)
+#error "User Store Data Offset Must Greater Than or Equal 0x1000"
+#endif
+
+#if (RPA_IRK_MAX > 10)
+#error "RPA_IRK_MAX no more than 10 when RPA_IRK_STORE, identities fit one page"
+#endif
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Lifetime in half-slot
+#define RPA_CACHE_HS          BLE_MS2HS((uint32_t)(RPA_CACHE_TIME) * 1000)
+
+/// Identity of entry
+#define RPA_ID_EMPTY          (0xFF)
+#define RPA_ID_UNKNOWN        (0xFE)
+
+/// Slot of address, hash part(addr[0..2]) and prand(addr[3..5]) both random
+#define RPA_SLOT(a)           (((a)[0] ^ (a)[3]) & (RPA_CACHE_NB - 1))
+
+/// Entry of cache
+struct rpa_ent
+{
+    bd_addr_t addr;
+    uint8_t   id;
+    uint32_t  time;
+};
+
+/// Identity of bonded peer
+struct rpa_id
+{
+    struct gap_sec_key irk;
+    struct gap_bdaddr  addr;
+};
+
+/// Identities in flash page
+#define RPA_IRK_MAGIC         (0x4B524950) // "PIRK"
+
+struct rpa_store
+{
+    uint32_t      magic;
+    uint8_t       nb_id;
+    uint8_t       rsvd[3];
+    struct rpa_id ids[RPA_IRK_MAX];
+};
+
+/// Cache environment
+struct rpa_env_tag
+{
+    struct rpa_ent ent[RPA_CACHE_NB];
+
+    struct rpa_id  ids[RPA_IRK_MAX];
+    /// Slot of last RPA resolved of each identity
+    uint8_t        id_slot[RPA_IRK_MAX];
+    uint8_t        nb_id;
+
+    /// Address in resolution, result discarded if identities changed meanwhile
+    bd_addr_t      pend_addr;
+    bool           busy;
+    bool           stale;
+    bool           solved;
+
+    struct rpa_stat stat;
+};
+
+static struct rpa_env_tag rpa_env;
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void rpa_cache_clear(void)
+{
+    for (uint16_t i = 0; i < RPA_CACHE_NB; i++)
+    {
+        rpa_env.ent[i].id = RPA_ID_EMPTY;
+    }
+
+    // resolution in flight done with old identities
+    rpa_env.stale = rpa_env.busy;
+}
+
+static void rpa_cache_put(const bd_addr_t *addr, uint8_t id)
+{
+    uint8_t slot = RPA_SLOT(addr->addr);
+
+    if (id < RPA_IRK_MAX)
+    {
+        struct rpa_ent *old = &rpa_env.ent[rpa_env.id_slot[id]];
+
+        // peer rotated, previous RPA never seen again
+        if ((old->id == id) && memcmp(&old->addr, addr, sizeof(bd_addr_t)))
+        {
+            old->id = RPA_ID_EMPTY;
+            rpa_env.stat.rotations++;
+        }
+
+        rpa_env.id_slot[id] = slot;
+    }
+
+    memcpy(&rpa_env.ent[slot].addr, addr, sizeof(bd_addr_t));
+    rpa_env.ent[slot].id   = id;
+    rpa_env.ent[slot].time = ble_time_get();
+}
+
+static void rpa_resolv_send(const bd_addr_t *addr)
+{
+    struct gapm_resolv_addr_cmd *cmd = KE_MSG_ALLOC_DYN(GAPM_RESOLV_ADDR_CMD, TASK_ID(GAPM, 0), TASK_APP,
+                                             gapm_resolv_addr_cmd, rpa_env.nb_id * sizeof(struct gap_sec_key));
+
+    cmd->operation = GAPM_RESOLV_ADDR;
+    cmd->nb_key    = rpa_env.nb_id;
+    memcpy(&cmd->addr, addr, sizeof(bd_addr_t));
+
+    for (uint8_t i = 0; i < rpa_env.nb_id; i++)
+    {
+        memcpy(&cmd->irk[i], &rpa_env.ids[i].irk, sizeof(struct gap_sec_key));
+    }
+
+    ke_msg_send(cmd);
+
+    memcpy(&rpa_env.pend_addr, addr, sizeof(bd_addr_t));
+    rpa_env.busy   = true;
+    rpa_env.stale  = false;
+    rpa_env.solved = false;
+    rpa_env.stat.resolves++;
+}
+
+#if (RPA_IRK_STORE)
+static void rpa_irk_save(void)
+{
+    struct rpa_store st;
+    uint16_t len = offsetof(struct rpa_store, ids) + rpa_env.nb_id * sizeof(struct rpa_id);
+
+    memset(&st, 0xFF, sizeof(st));
+    st.magic = RPA_IRK_MAGIC;
+    st.nb_id = rpa_env.nb_id;
+    memcpy(st.ids, rpa_env.ids, rpa_env.nb_id * sizeof(struct rpa_id));
+
+    flash_page_erase(RPA_IRK_OFFSET);
+    flash_byte_write(RPA_IRK_OFFSET, (uint8_t *)&st, (len + 3) & ~3);
+}
+#endif
+
+void rpa_irk_load(void)
+{
+    #if (RPA_IRK_STORE)
+    struct rpa_store st;
+
+    flash_byte_read(RPA_IRK_OFFSET, (uint8_t *)&st, sizeof(st));
+
+    if ((st.magic != RPA_IRK_MAGIC) || (st.nb_id > RPA_IRK_MAX))
+    {
+        return;
+    }
+
+    memcpy(rpa_env.ids, st.ids, st.nb_id * sizeof(struct rpa_id));
+    memset(rpa_env.id_slot, 0, sizeof(rpa_env.id_slot));
+    rpa_env.nb_id = st.nb_id;
+    rpa_cache_clear();
+
+    DEBUG("irk_load(nb:%d)", rpa_env.nb_id);
+    #endif
+}
+
+int8_t rpa_irk_add(const struct gap_sec_key *irk, const struct gap_bdaddr *addr)
+{
+    uint8_t idx;
+
+    for (idx = 0; idx < rpa_env.nb_id; idx++)
+    {
+        if (!memcmp(&rpa_env.ids[idx].irk, irk, sizeof(struct gap_sec_key)))
+            break;
+    }
+
+    if (idx == RPA_IRK_MAX)
+    {
+        return RPA_NONE;
+    }
+
+    if (idx == rpa_env.nb_id)
+    {
+        rpa_env.nb_id++;
+    }
+    #if (RPA_IRK_STORE)
+    else if (!memcmp(&rpa_env.ids[idx].addr, addr, sizeof(struct gap_bdaddr)))
+    {
+        // paired again, unchanged, save flash wear
+        return idx;
+    }
+    #endif
+
+    memcpy(&rpa_env.ids[idx].irk, irk, sizeof(struct gap_sec_key));
+    memcpy(&rpa_env.ids[idx].addr, addr, sizeof(struct gap_bdaddr));
+    rpa_env.id_slot[idx] = 0;
+
+    #if (RPA_IRK_STORE)
+    rpa_irk_save();
+    #endif
+
+    // unknown ones maybe of this identity
+    rpa_cache_clear();
+
+    DEBUG("irk_add(idx:%d,nb:%d)", idx, rpa_env.nb_id);
+    return idx;
+}
+
+void rpa_irk_clear(void)
+{
+    rpa_env.nb_id = 0;
+    rpa_cache_clear();
+    memset(&rpa_env.stat, 0, sizeof(struct rpa_stat));
+
+    #if (RPA_IRK_STORE)
+    flash_page_erase(RPA_IRK_OFFSET);
+    #endif
+}
+
+const struct gap_bdaddr *rpa_id_addr(uint8_t idx)
+{
+    return (idx < rpa_env.nb_id) ? &rpa_env.ids[idx].addr : NULL;
+}
+
+int8_t rpa_resolve(const struct gap_bdaddr *addr)
+{
+    struct rpa_ent *ent;
+
+    if (rpa_env.nb_id == 0)
+    {
+        return RPA_NONE;
+    }
+
+    if ((addr->addr_type != ADDR_RAND) || ((addr->addr.addr[5] & 0xC0) != GAP_RSLV_ADDR))
+    {
+        // identity address(public or static), or resolved by controller
+        for (uint8_t idx = 0; idx < rpa_env.nb_id; idx++)
+        {
+            if (!memcmp(&rpa_env.ids[idx].addr.addr, &addr->addr, sizeof(bd_addr_t)))
+                return idx;
+        }
+
+        return RPA_NONE;
+    }
+
+    rpa_env.stat.lookups++;
+
+    ent = &rpa_env.ent[RPA_SLOT(addr->addr.addr)];
+
+    if ((ent->id != RPA_ID_EMPTY) && !memcmp(&ent->addr, &addr->addr, sizeof(bd_addr_t)))
+    {
+        if (BLE_TIME_DIFF(ble_time_get(), ent->time) < RPA_CACHE_HS)
+        {
+            rpa_env.stat.hits++;
+            return (ent->id == RPA_ID_UNKNOWN) ? RPA_NONE : ent->id;
+        }
+
+        ent->id = RPA_ID_EMPTY;
+    }
+
+    if (!rpa_env.busy)
+    {
+        rpa_resolv_send(&addr->addr);
+    }
+    else
+    {
+        rpa_env.stat.pends++;
+    }
+
+    return RPA_PEND;
+}
+
+void rpa_solved_ind(const bd_addr_t *addr, const struct gap_sec_key *irk)
+{
+    if (!rpa_env.busy || rpa_env.stale)
+    {
+        return;
+    }
+
+    for (uint8_t idx = 0; idx < rpa_env.nb_id; idx++)
+    {
+        if (!memcmp(&rpa_env.ids[idx].irk, irk, sizeof(struct gap_sec_key)))
+        {
+            DEBUG("solved(idx:%d)", idx);
+
+            rpa_cache_put(addr, idx);
+            rpa_env.solved = true;
+            break;
+        }
+    }
+}
+
+void rpa_cmp_evt(uint8_t status)
+{
+    // not resolved by any IRK, else busy or error not cached
+    if ((status == GAP_ERR_NOT_FOUND) && !rpa_env.stale && !rpa_env.solved)
+    {
+        rpa_cache_put(&rpa_env.pend_addr, RPA_ID_UNKNOWN);
+    }
+
+    rpa_env.busy = false;
+}
+
+const struct rpa_stat *rpa_stat(void)
+{
+    return &rpa_env.stat;
+}
+
+#endif //(RPA_CACHE)
@@ -0,0 +1,133 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_rpa.h
+ *
+ * @brief Header file - Resolvable Private Address Cache(RPA to Identity of bonded peers).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_RPA_H_
+#define APP_RPA_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gap.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Cache, app_actv_report_ind() resolves addresses of reports via cache
+#if !defined(RPA_CACHE)
+    #define RPA_CACHE                (0)
+#endif
+
+/// Entries of cache, power of 2
+#if !defined(RPA_CACHE_NB)
+    #define RPA_CACHE_NB             (16)
+#endif
+
+/// Lifetime of entry, unit in 1s(15min recommended timeout of RPA)
+#if !defined(RPA_CACHE_TIME)
+    #define RPA_CACHE_TIME           (900)
+#endif
+
+/// Max number of identities(IRK of bonded peers)
+#if !defined(RPA_IRK_MAX)
+    #define RPA_IRK_MAX              (4)
+#endif
+
+/// Identities kept in flash, loaded at init so bonded peers found after reset
+#if !defined(RPA_IRK_STORE)
+    #define RPA_IRK_STORE            (1)
+#endif
+
+/// Flash offset of identities, one page(0x100)
+#if !defined(RPA_IRK_OFFSET)
+    #define RPA_IRK_OFFSET           (0x1300)
+#endif
+
+/// Reports only of bonded peers passed to app, others dropped
+#if !defined(RPA_BOND_ONLY)
+    #define RPA_BOND_ONLY            (0)
+#endif
+
+/// Address not of any identity, or not resolved by any IRK
+#define RPA_NONE                     (-1)
+/// Resolution in progress, result in cache later
+#define RPA_PEND                     (-2)
+
+/// Statistics of cache
+struct rpa_stat
+{
+    /// Random resolvable addresses looked up
+    uint32_t lookups;
+    /// Answered by cache, identity or not
+    uint32_t hits;
+    /// Resolutions sent to stack(AES of each IRK)
+    uint32_t resolves;
+    /// Lookups while resolution in progress
+    uint32_t pends;
+    /// Old RPA of identity evicted by new one resolved
+    uint32_t rotations;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (RPA_CACHE)
+/**
+ ****************************************************************************************
+ * @brief Add identity of bonded peer(e.g. on GAPC_IRK_EXCH), saved in flash if RPA_IRK_STORE.
+ *        Cache is cleared, since unresolved addresses maybe resolved by new IRK.
+ *
+ * @param[in] irk   IRK of peer
+ * @param[in] addr  Identity address of peer
+ *
+ * @return Index of identity(same IRK updated), RPA_NONE if no room.
+ ****************************************************************************************
+ */
+int8_t rpa_irk_add(const struct gap_sec_key *irk, const struct gap_bdaddr *addr);
+
+/// Remove all identities(also in flash), and clear cache
+void rpa_irk_clear(void);
+
+/// Load identities of bonded peers saved in flash, called at init(BLE_CONFIGURED)
+void rpa_irk_load(void);
+
+/// Identity address of index, NULL if invalid
+const struct gap_bdaddr *rpa_id_addr(uint8_t idx);
+
+/**
+ ****************************************************************************************
+ * @brief Lookup identity of address in report. Identity address matched directly,
+ *        RPA answered from cache, else resolution sent to stack(one at a time).
+ *
+ * @param[in] addr  Address of report(trans_addr)
+ *
+ * @return Index of identity, RPA_NONE or RPA_PEND.
+ ****************************************************************************************
+ */
+int8_t rpa_resolve(const struct gap_bdaddr *addr);
+
+/// Feed of GAPM events, called in app_gapm.c
+void rpa_solved_ind(const bd_addr_t *addr, const struct gap_sec_key *irk);
+void rpa_cmp_evt(uint8_t status);
+
+/// Statistics of cache
+const struct rpa_stat *rpa_stat(void);
+#endif //(RPA_CACHE)
+
+#endif // APP_RPA_H_
@@ -0,0 +1,351 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_scan.c
+ *
+ * @brief Scan Report Filter - Example
+ *
+ *  Rule table compiled once by scan_filt_conf():
+ *    - RSSI floor of all rules: weak reports dropped before anything
+ *    - Bitmap of AD types referenced: other AD structures skipped by one bit test
+ *    - Rules of each AD type as bitmask, only them compared with value/mask
+ *  Report hashed(address, type and data) into a small direct-mapped cache first,
+ *  same report seen within SCAN_DUP_TIME_MS dropped without parsing.
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "app_scan.h"
+
+#if (APP_SCAN_FILT)
+
+#if (DBG_SCAN)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (SCAN_FILT_MAX > 8)
+#error "SCAN_FILT_MAX no more than 8, rules mask in uint8_t"
+#endif
+
+#if (SCAN_DUP_NB & (SCAN_DUP_NB - 1))
+#error "SCAN_DUP_NB must be power of 2"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Dup time in half-slot
+#define SCAN_DUP_HS           BLE_MS2HS(SCAN_DUP_TIME_MS)
+
+/// Rules of one AD type
+struct filt_ad
+{
+    uint8_t ad_type;
+    uint8_t rules;
+};
+
+/// Entry of recently-seen cache, sig 0 as empty
+struct dup_ent
+{
+    uint32_t sig;
+    uint32_t time;
+};
+
+/// Filter environment
+struct filt_env_tag
+{
+    const struct scan_filt *rules;
+    uint8_t  nb_rule;
+    uint8_t  nb_ad;
+    /// Rules without AD type
+    uint8_t  any_rules;
+    /// Lowest RSSI floor of rules
+    int8_t   rssi_floor;
+    /// Bitmap of AD types referenced
+    uint32_t ad_map[8];
+    struct filt_ad ad_idx[SCAN_FILT_MAX];
+
+    struct scan_filt_stat stat;
+
+    #if (SCAN_DUP_NB)
+    struct dup_ent dup[SCAN_DUP_NB];
+    #endif
+};
+
+static struct filt_env_tag filt_env;
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+#if (SCAN_DUP_NB)
+/// FNV-1a
+static uint32_t dup_hash(uint32_t h, const uint8_t *data, uint16_t len)
+{
+    while (len--)
+    {
+        h = (h ^ *data++) * 16777619UL;
+    }
+
+    return h;
+}
+
+/// Return true if same report in cache, else record it
+static bool dup_check(struct gapm_ext_adv_report_ind const* report)
+{
+    uint32_t now = ble_time_get();
+    uint32_t sig = 2166136261UL;
+    struct dup_ent *ent;
+
+    sig = dup_hash(sig, (const uint8_t *)&report->trans_addr, sizeof(struct gap_bdaddr));
+    sig = dup_hash(sig, &report->info, 1);
+    sig = dup_hash(sig, report->data, report->length);
+    if (sig == 0) sig = 1;
+
+    ent = &filt_env.dup[(sig ^ (sig >> 16)) & (SCAN_DUP_NB - 1)];
+
+    if ((ent->sig == sig) && (BLE_TIME_DIFF(now, ent->time) < SCAN_DUP_HS))
+    {
+        return true;
+    }
+
+    ent->sig  = sig;
+    ent->time = now;
+    return false;
+}
+#endif
+
+static bool filt_addr(const struct scan_filt *rule, const struct gap_bdaddr *addr)
+{
+    if (rule->addr_nb == 0)
+    {
+        return true;
+    }
+
+    for (uint8_t i = 0; i < rule->addr_nb; i++)
+    {
+        if (!memcmp(&rule->addr_list[i], addr, sizeof(struct gap_bdaddr)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static bool filt_data(const struct scan_filt *rule, const uint8_t *data, uint8_t len)
+{
+    if ((rule->flags & SCAN_FILT_EXACT) && (len != rule->len))
+    {
+        return false;
+    }
+
+    if (rule->len == 0)
+    {
+        return true;
+    }
+
+    for (uint8_t off = 0; off + rule->len <= len; off += rule->len)
+    {
+        uint8_t i;
+
+        for (i = 0; i < rule->len; i++)
+        {
+            if ((data[off + i] ^ rule->value[i]) & rule->mask[i])
+                break;
+        }
+
+        if (i == rule->len)
+        {
+            return true;
+        }
+
+        if (!(rule->flags & SCAN_FILT_LIST))
+            break;
+    }
+
+    return false;
+}
+
+/// Rules of AD type, 0 if not referenced
+__STATIC_INLINE uint8_t filt_ad_rules(uint8_t ad_type)
+{
+    if (filt_env.ad_map[ad_type >> 5] & (1UL << (ad_type & 0x1F)))
+    {
+        for (uint8_t i = 0; i < filt_env.nb_ad; i++)
+        {
+            if (filt_env.ad_idx[i].ad_type == ad_type)
+                return filt_env.ad_idx[i].rules;
+        }
+    }
+
+    return 0;
+}
+
+/// Return index of lowest rule in mask that also passes address
+static int8_t filt_hit(uint8_t mask, const struct gap_bdaddr *addr)
+{
+    for (uint8_t r = 0; mask; r++, mask >>= 1)
+    {
+        if ((mask & 0x01) && filt_addr(&filt_env.rules[r], addr))
+        {
+            filt_env.stat.hits[r]++;
+            return r;
+        }
+    }
+
+    return SCAN_FILT_NONE;
+}
+
+uint8_t scan_filt_conf(const struct scan_filt *rules, uint8_t nb)
+{
+    if (nb > SCAN_FILT_MAX)
+    {
+        nb = SCAN_FILT_MAX;
+    }
+
+    // value/mask compared up to len, reject before table touched
+    for (uint8_t r = 0; r < nb; r++)
+    {
+        if (rules[r].len > SCAN_FILT_VAL_LEN)
+        {
+            DEBUG("filt rule%d len(%d) err", r, rules[r].len);
+            return GAP_ERR_INVALID_PARAM;
+        }
+    }
+
+    memset(&filt_env, 0, sizeof(filt_env));
+
+    filt_env.rules      = rules;
+    filt_env.nb_rule    = nb;
+    filt_env.rssi_floor = 127;
+
+    for (uint8_t r = 0; r < nb; r++)
+    {
+        const struct scan_filt *rule = &rules[r];
+
+        if (rule->rssi_min < filt_env.rssi_floor)
+        {
+            filt_env.rssi_floor = rule->rssi_min;
+        }
+
+        if (rule->ad_type == 0)
+        {
+            filt_env.any_rules |= (1 << r);
+            continue;
+        }
+
+        uint8_t i;
+
+        for (i = 0; i < filt_env.nb_ad; i++)
+        {
+            if (filt_env.ad_idx[i].ad_type == rule->ad_type)
+                break;
+        }
+
+        if (i == filt_env.nb_ad)
+        {
+            filt_env.ad_idx[i].ad_type = rule->ad_type;
+            filt_env.nb_ad++;
+            filt_env.ad_map[rule->ad_type >> 5] |= (1UL << (rule->ad_type & 0x1F));
+        }
+
+        filt_env.ad_idx[i].rules |= (1 << r);
+    }
+
+    DEBUG("filt conf(rules:%d,ad:%d,rssi:%d)", nb, filt_env.nb_ad, filt_env.rssi_floor);
+    return GAP_ERR_NO_ERROR;
+}
+
+int8_t scan_filt_match(struct gapm_ext_adv_report_ind const* report)
+{
+    const uint8_t *p_cursor = report->data;
+    const uint8_t *p_end    = report->data + report->length;
+    uint8_t cand = 0;
+    int8_t  hit;
+
+    filt_env.stat.reports++;
+
+    if (report->rssi < filt_env.rssi_floor)
+    {
+        filt_env.stat.rssi_drops++;
+        return SCAN_FILT_NONE;
+    }
+
+    #if (SCAN_DUP_NB)
+    if (dup_check(report))
+    {
+        filt_env.stat.dup_drops++;
+        return SCAN_FILT_NONE;
+    }
+    #endif
+
+    // rules passed RSSI floor
+    for (uint8_t r = 0; r < filt_env.nb_rule; r++)
+    {
+        if (report->rssi >= filt_env.rules[r].rssi_min)
+            cand |= (1 << r);
+    }
+
+    hit = filt_hit(cand & filt_env.any_rules, &report->trans_addr);
+    if (hit != SCAN_FILT_NONE)
+    {
+        return hit;
+    }
+
+    while (p_cursor + 1 < p_end)
+    {
+        uint8_t ad_len = *p_cursor;
+
+        // zero-length or truncated AD structure
+        if ((ad_len == 0) || (ad_len >= p_end - p_cursor))
+            break;
+
+        uint8_t mask = filt_ad_rules(*(p_cursor + 1)) & cand;
+
+        for (uint8_t r = 0; mask >> r; r++)
+        {
+            if (((mask >> r) & 0x01) && !filt_data(&filt_env.rules[r], p_cursor + 2, ad_len - 1))
+            {
+                mask &= ~(1 << r);
+            }
+        }
+
+        hit = filt_hit(mask, &report->trans_addr);
+        if (hit != SCAN_FILT_NONE)
+        {
+            return hit;
+        }
+
+        /* Go to next advertising info */
+        p_cursor += (ad_len + 1);
+    }
+
+    filt_env.stat.misses++;
+    return SCAN_FILT_NONE;
+}
+
+void scan_dup_clear(void)
+{
+    #if (SCAN_DUP_NB)
+    memset(filt_env.dup, 0, sizeof(filt_env.dup));
+    #endif
+}
+
+const struct scan_filt_stat *scan_filt_stat(void)
+{
+    return &filt_env.stat;
+}
+
+#endif //(APP_SCAN_FILT)
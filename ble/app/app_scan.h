@@ -0,0 +1,139 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_scan.h
+ *
+ * @brief Header file - Scan Report Filter(Rule table and Recently-seen cache).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_SCAN_H_
+#define APP_SCAN_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "gapm.h"
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Filter, app_actv_report_ind() match reports via rule table
+#if !defined(APP_SCAN_FILT)
+    #define APP_SCAN_FILT            (0)
+#endif
+
+/// Max number of rules in table
+#if !defined(SCAN_FILT_MAX)
+    #define SCAN_FILT_MAX            (8)
+#endif
+
+/// Max bytes of value/mask in rule
+#if !defined(SCAN_FILT_VAL_LEN)
+    #define SCAN_FILT_VAL_LEN        (8)
+#endif
+
+/// Entries of recently-seen cache, power of 2 (0: no cache)
+#if !defined(SCAN_DUP_NB)
+    #define SCAN_DUP_NB              (16)
+#endif
+
+/// Same report within the time is dropped, unit in 1ms
+#if !defined(SCAN_DUP_TIME_MS)
+    #define SCAN_DUP_TIME_MS         (1000)
+#endif
+
+/// No rule matched or report dropped
+#define SCAN_FILT_NONE               (-1)
+
+/// Flags of rule
+enum scan_filt_flag
+{
+    /// AD data is a list of 'len' bytes item(e.g. UUIDs), match any item
+    SCAN_FILT_LIST           = (1 << 0),
+    /// Length of AD data must equal 'len', else value matched as prefix
+    SCAN_FILT_EXACT          = (1 << 1),
+};
+
+/// Rule of filter
+struct scan_filt
+{
+    /// AD type to match @see enum gap_ad_type, 0 to match RSSI/address only
+    uint8_t  ad_type;
+    /// Flags @see enum scan_filt_flag
+    uint8_t  flags;
+    /// Bytes of value/mask compared at head of AD data(or each item), 0 for presence of AD type
+    uint8_t  len;
+    /// RSSI floor in dBm, -127 for none
+    int8_t   rssi_min;
+    /// Value and mask(bits set to compare)
+    uint8_t  value[SCAN_FILT_VAL_LEN];
+    uint8_t  mask[SCAN_FILT_VAL_LEN];
+    /// Number of address list, 0 for any device
+    uint8_t  addr_nb;
+    /// Address list of devices allowed
+    const struct gap_bdaddr *addr_list;
+};
+
+/// Statistics of filter
+struct scan_filt_stat
+{
+    /// Reports fed to filter
+    uint32_t reports;
+    /// Dropped by recently-seen cache
+    uint32_t dup_drops;
+    /// Dropped by RSSI floor of all rules
+    uint32_t rssi_drops;
+    /// Parsed but no rule matched
+    uint32_t misses;
+    /// Hits of each rule
+    uint32_t hits[SCAN_FILT_MAX];
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (APP_SCAN_FILT)
+/**
+ ****************************************************************************************
+ * @brief Compile rule table, statistics and cache are reset.
+ *
+ * @param[in] rules  table of rules, kept by caller while used(static or const)
+ * @param[in] nb     number of rules, no more than SCAN_FILT_MAX
+ *
+ * @return GAP_ERR_INVALID_PARAM if any rule len over SCAN_FILT_VAL_LEN(table kept),
+ *         else GAP_ERR_NO_ERROR.
+ ****************************************************************************************
+ */
+uint8_t scan_filt_conf(const struct scan_filt *rules, uint8_t nb);
+
+/**
+ ****************************************************************************************
+ * @brief Match report with rules, duplicates in cache dropped before AD parsed.
+ *
+ * @param[in] report  Report of Advertising data be scanned
+ *
+ * @return Index of rule matched first in AD order, or SCAN_FILT_NONE.
+ ****************************************************************************************
+ */
+int8_t scan_filt_match(struct gapm_ext_adv_report_ind const* report);
+
+/// Clear recently-seen cache, called when scan start
+void scan_dup_clear(void);
+
+/// Statistics of filter, reset by scan_filt_conf()
+const struct scan_filt_stat *scan_filt_stat(void);
+#endif //(APP_SCAN_FILT)
+
+#endif // APP_SCAN_H_
@@ -0,0 +1,339 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_slat.c
+ *
+ * @brief Adaptive Slave Latency - Example
+ *
+ *  Link negotiated once with SLAT_LATENCY(param update only if master gave less), then
+ *  latency switched locally via ble_latency_applied(), no LL procedure and nothing to reject:
+ *    - Busy: SLAT_BURST_NB inputs within SLAT_BURST_MS, wake every event(no latency)
+ *    - Idle: no input for SLAT_IDLE_MS, latency applied to save power
+ *  Entered busy at once, left only after long quiet(hysteresis), so typing never churns.
+ *  Time in each state, events woken and input-to-air delay counted, so settings can be
+ *  compared with same input trace replayed(e.g. key reports fed via UART).
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "app_slat.h"
+
+#if (APP_SLAT_EN)
+
+#if (DBG_SLAT)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+#if (SLAT_LATENCY > 499) || (SLAT_BURST_NB == 0)
+#error "SLAT_LATENCY no more than 499, SLAT_BURST_NB at least 1"
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Time in half-slot
+#define SLAT_IDLE_HS          BLE_MS2HS(SLAT_IDLE_MS)
+#define SLAT_BURST_HS         BLE_MS2HS(SLAT_BURST_MS)
+#define SLAT_NEGO_HS          BLE_MS2HS(SLAT_NEGO_MS)
+
+/// Fold time if not queried long, far before counter wrapped
+#define SLAT_FOLD_HS          (0x04000000)
+
+/// Max supervision timeout, unit in 10ms
+#define SLAT_TIME_OUT_MAX     (3200)
+
+/// Step of latency negotiation
+enum slat_nego
+{
+    SLAT_NEGO_WAIT,
+    SLAT_NEGO_SENT,
+    SLAT_NEGO_DONE,
+};
+
+/// Controller environment
+struct slat_env_tag
+{
+    struct slat_stat stat;
+
+    uint8_t  conidx;
+    bool     active;
+    uint8_t  nego;
+    uint8_t  burst_cnt;
+
+    /// Time of last fold, half-slot not yet folded into ms and wakeups
+    uint32_t fold_time;
+    uint32_t ms_hs;
+    uint32_t evt_hs;
+
+    uint32_t input_time;
+    uint32_t burst_time;
+    uint32_t nego_time;
+    /// Time of input waiting completed
+    uint32_t air_time;
+    bool     air_pend;
+};
+
+static struct slat_env_tag slat_env;
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+/// Fold time elapsed into state time and wakeups with param in use
+static void slat_fold(uint32_t now)
+{
+    struct slat_stat *stat = &slat_env.stat;
+    uint32_t diff = BLE_TIME_DIFF(now, slat_env.fold_time);
+    uint32_t ms;
+
+    slat_env.fold_time = now;
+    slat_env.ms_hs  += diff;
+    slat_env.evt_hs += diff;
+
+    // 16 half-slots exactly 5ms
+    ms = ble_time_fold(&slat_env.ms_hs, 16) * 5;
+
+    if (stat->idle)
+        stat->idle_ms += ms;
+    else
+        stat->busy_ms += ms;
+
+    if (stat->intv)
+    {
+        // woken once per (1 + latency) events while latency applied
+        uint32_t period = BLE_INTV2HS(stat->intv) * (stat->idle ? (1 + stat->latency) : 1);
+
+        stat->wakeups += ble_time_fold(&slat_env.evt_hs, period);
+    }
+}
+
+static void slat_idle_set(bool idle, uint32_t now)
+{
+    slat_fold(now);
+
+    slat_env.stat.idle = idle;
+    ble_latency_applied(idle);
+
+    DEBUG("slat %s(in:%"PRIu32",busy:%"PRIu32"ms,idle:%"PRIu32"ms,wake:%"PRIu32")", idle ? "idle" : "busy",
+          slat_env.stat.inputs, slat_env.stat.busy_ms, slat_env.stat.idle_ms, slat_env.stat.wakeups);
+}
+
+static void slat_nego_send(void)
+{
+    struct slat_stat *stat = &slat_env.stat;
+    struct gapc_conn_param param;
+    uint32_t lat = SLAT_LATENCY;
+    // timeout 2x of (1 + latency) * interval * 2, bounded by max
+    uint32_t lat_max = (SLAT_TIME_OUT_MAX * 2) / stat->intv - 1;
+    uint32_t time_out;
+
+    if (lat > lat_max)
+    {
+        lat = lat_max;
+    }
+
+    time_out = ((1 + lat) * stat->intv) / 2;
+    if (time_out < stat->time_out)
+    {
+        time_out = stat->time_out;
+    }
+
+    // interval kept, only latency changed
+    param.intv_min = stat->intv;
+    param.intv_max = stat->intv;
+    param.latency  = lat;
+    param.time_out = time_out;
+
+    DEBUG("slat nego(intv:%d,late:%d,to:%d)", param.intv_min, param.latency, param.time_out);
+
+    slat_env.nego = SLAT_NEGO_SENT;
+    stat->nego++;
+    gapc_update_param(slat_env.conidx, &param);
+}
+
+void app_slat_conn_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out)
+{
+    uint32_t now;
+
+    if (slat_env.active)
+    {
+        // only one link controlled
+        return;
+    }
+
+    now = ble_time_get();
+    memset(&slat_env, 0, sizeof(slat_env));
+
+    slat_env.conidx = conidx;
+    slat_env.active = true;
+    slat_env.nego   = SLAT_NEGO_WAIT;
+    slat_env.fold_time = slat_env.input_time = slat_env.nego_time = now;
+
+    slat_env.stat.intv     = intv;
+    slat_env.stat.latency  = latency;
+    slat_env.stat.time_out = time_out;
+
+    // host discovery and pairing as busy
+    slat_env.stat.idle = false;
+    ble_latency_applied(false);
+}
+
+void app_slat_conn_lost(uint8_t conidx)
+{
+    if (slat_env.active && (slat_env.conidx == conidx))
+    {
+        slat_fold(ble_time_get());
+        slat_env.active = false;
+
+        // default of stack
+        ble_latency_applied(true);
+
+        DEBUG("slat stop(in:%"PRIu32",burst:%"PRIu32",busy:%"PRIu32"ms,idle:%"PRIu32"ms,wake:%"PRIu32","
+              "air:%"PRIu32"/%"PRIu32"/%d,nego:%d/%d)",
+              slat_env.stat.inputs, slat_env.stat.bursts, slat_env.stat.busy_ms, slat_env.stat.idle_ms,
+              slat_env.stat.wakeups, slat_env.stat.air_cnt, slat_env.stat.air_sum, slat_env.stat.air_max,
+              slat_env.stat.nego, slat_env.stat.rejects);
+    }
+}
+
+void app_slat_cmp(uint8_t conidx, uint8_t operation, uint8_t status)
+{
+    if (!slat_env.active || (slat_env.conidx != conidx) || (operation != GAPC_UPDATE_PARAMS)
+        || (slat_env.nego != SLAT_NEGO_SENT))
+    {
+        return;
+    }
+
+    if (status == GAP_ERR_NO_ERROR)
+    {
+        slat_env.nego = SLAT_NEGO_DONE;
+    }
+    else
+    {
+        DEBUG("slat nego fail(sta:0x%X)", status);
+
+        // retry later, or keep param of master
+        slat_env.stat.rejects++;
+        slat_env.nego = (slat_env.stat.rejects < SLAT_NEGO_RETRY) ? SLAT_NEGO_WAIT : SLAT_NEGO_DONE;
+        slat_env.nego_time = ble_time_get();
+    }
+}
+
+void app_slat_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out)
+{
+    if (slat_env.active && (slat_env.conidx == conidx))
+    {
+        // wakeups so far with old param
+        slat_fold(ble_time_get());
+
+        slat_env.stat.intv     = intv;
+        slat_env.stat.latency  = latency;
+        slat_env.stat.time_out = time_out;
+    }
+}
+
+void app_slat_input(uint8_t conidx)
+{
+    uint32_t now;
+
+    if (!slat_env.active || (slat_env.conidx != conidx))
+    {
+        return;
+    }
+
+    now = ble_time_get();
+    slat_env.input_time = now;
+    slat_env.stat.inputs++;
+
+    if (!slat_env.air_pend)
+    {
+        slat_env.air_pend = true;
+        slat_env.air_time = now;
+    }
+
+    if (slat_env.stat.idle)
+    {
+        if (BLE_TIME_DIFF(now, slat_env.burst_time) > SLAT_BURST_HS)
+        {
+            slat_env.burst_time = now;
+            slat_env.burst_cnt  = 0;
+        }
+
+        if (++slat_env.burst_cnt >= SLAT_BURST_NB)
+        {
+            slat_env.burst_cnt = 0;
+            slat_env.stat.bursts++;
+            slat_idle_set(false, now);
+        }
+    }
+}
+
+void app_slat_sent(uint8_t conidx)
+{
+    if (slat_env.active && (slat_env.conidx == conidx) && slat_env.air_pend)
+    {
+        uint32_t air = BLE_TIME_DIFF(ble_time_get(), slat_env.air_time) >> 2;
+
+        slat_env.air_pend = false;
+        slat_env.stat.air_cnt++;
+        slat_env.stat.air_sum += air;
+
+        if (air > slat_env.stat.air_max)
+        {
+            slat_env.stat.air_max = (air > 0xFFFF) ? 0xFFFF : air;
+        }
+    }
+}
+
+void app_slat_proc(void)
+{
+    uint32_t now;
+
+    if (!slat_env.active)
+    {
+        return;
+    }
+
+    now = ble_time_get();
+
+    if (!slat_env.stat.idle && (BLE_TIME_DIFF(now, slat_env.input_time) >= SLAT_IDLE_HS))
+    {
+        slat_idle_set(true, now);
+    }
+
+    if ((slat_env.nego == SLAT_NEGO_WAIT) && (BLE_TIME_DIFF(now, slat_env.nego_time) >= SLAT_NEGO_HS))
+    {
+        if ((slat_env.stat.latency >= SLAT_LATENCY) || (slat_env.stat.intv == 0))
+            slat_env.nego = SLAT_NEGO_DONE;
+        else
+            slat_nego_send();
+    }
+
+    if (BLE_TIME_DIFF(now, slat_env.fold_time) > SLAT_FOLD_HS)
+    {
+        slat_fold(now);
+    }
+}
+
+const struct slat_stat *app_slat_stat(void)
+{
+    if (slat_env.active)
+    {
+        slat_fold(ble_time_get());
+    }
+
+    return &slat_env.stat;
+}
+
+#endif //(APP_SLAT_EN)
@@ -0,0 +1,139 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_slat.h
+ *
+ * @brief Header file - Adaptive Slave Latency(Input activity of HID or Remote Control).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_SLAT_H_
+#define APP_SLAT_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Controller, input counted by prf_hids.c, link fed by app_gapc.c
+#if !defined(APP_SLAT_EN)
+    #define APP_SLAT_EN              (0)
+#endif
+
+/// Latency requested once if link has less, applied only while idle
+#if !defined(SLAT_LATENCY)
+    #define SLAT_LATENCY             (49)
+#endif
+
+/// Delay of latency request after connected(host discovery done), and retry after rejected
+#if !defined(SLAT_NEGO_MS)
+    #define SLAT_NEGO_MS             (5000)
+#endif
+
+/// Max times of latency request rejected, then keep param of master
+#if !defined(SLAT_NEGO_RETRY)
+    #define SLAT_NEGO_RETRY          (2)
+#endif
+
+/// Inputs within SLAT_BURST_MS to leave idle, 1 for any input
+#if !defined(SLAT_BURST_NB)
+    #define SLAT_BURST_NB            (1)
+#endif
+
+#if !defined(SLAT_BURST_MS)
+    #define SLAT_BURST_MS            (300)
+#endif
+
+/// No input for the time to back idle(latency applied), unit in 1ms
+#if !defined(SLAT_IDLE_MS)
+    #define SLAT_IDLE_MS             (2000)
+#endif
+
+/// Statistics of link, to compare settings with same input trace replayed
+struct slat_stat
+{
+    /// Inputs(reports given to stack), and bursts(idle -> busy)
+    uint32_t inputs;
+    uint32_t bursts;
+    /// Time in busy(every event) and idle(latency applied), unit in 1ms
+    uint32_t busy_ms;
+    uint32_t idle_ms;
+    /// Connection events woken, estimated by interval and latency in use(proxy of current)
+    uint32_t wakeups;
+
+    /// Input to air(report completed), count, sum and max unit in 1.25ms
+    uint32_t air_cnt;
+    uint32_t air_sum;
+    uint16_t air_max;
+
+    /// Connection param in use(interval unit in 1.25ms, timeout in 10ms)
+    uint16_t intv;
+    uint16_t latency;
+    uint16_t time_out;
+
+    /// Latency request sent and rejected
+    uint8_t  nego;
+    uint8_t  rejects;
+    /// Latency applied now
+    bool     idle;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (APP_SLAT_EN)
+/**
+ ****************************************************************************************
+ * @brief Start on link, busy(no latency applied) till first idle time.
+ *        ble_latency_applied() is global, so only one slave link controlled.
+ *
+ * @param[in] conidx    connection index
+ * @param[in] intv      connection interval, unit in 1.25ms
+ * @param[in] latency   slave latency
+ * @param[in] time_out  supervision timeout, unit in 10ms
+ ****************************************************************************************
+ */
+void app_slat_conn_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out);
+
+/// Stop on link lost, latency applied as default
+void app_slat_conn_lost(uint8_t conidx);
+
+/// Feed of GAPC events, called in app_gapc.c
+void app_slat_cmp(uint8_t conidx, uint8_t operation, uint8_t status);
+void app_slat_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out);
+
+/// Feed of input, called in prf_hids.c: report given to stack, and its ATTS_CMP_EVT
+void app_slat_input(uint8_t conidx);
+void app_slat_sent(uint8_t conidx);
+
+/**
+ ****************************************************************************************
+ * @brief Poll in main loop, back idle after SLAT_IDLE_MS, request latency if needed.
+ ****************************************************************************************
+ */
+void app_slat_proc(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get statistics of link, time and wakeups brought up to date.
+ *
+ * @return Pointer of statistics(kept after link lost until next start).
+ ****************************************************************************************
+ */
+const struct slat_stat *app_slat_stat(void);
+#endif //(APP_SLAT_EN)
+
+#endif // APP_SLAT_H_
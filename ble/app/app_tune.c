@@ -0,0 +1,293 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_tune.c
+ *
+ * @brief Link Throughput Tuner - Example
+ *
+ *  When connected, negotiate in order: DLE(LE_MAX_OCTETS) -> PHY(APP_TUNE_PHY) -> MTU(BLE_MTU),
+ *  each step started after previous GAPC_CMP_EVT, rejected by peer is ignored.
+ *  Then data counted via app_tune_count() is measured per APP_TUNE_WIN_MS window:
+ *    - Above APP_TUNE_BULK_BPS  : go bulk mode at once (short interval, no latency)
+ *    - Below for APP_TUNE_IDLE_WIN windows : back interactive mode (longer interval, latency)
+ *
+ * < If want to modify it, recommend to copy the file to 'user porject'/src >
+ ****************************************************************************************
+ */
+
+#include "bledef.h"
+#include "app.h"
+#include "app_tune.h"
+
+#if (APP_TUNE_EN)
+
+#if (DBG_TUNE)
+#include "dbg.h"
+#define DEBUG(format, ...)    debug("<%s,%d>" format "\r\n", __MODULE__, (int)__LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Window in half-slot
+#define TUNE_WIN_HS           BLE_MS2HS(APP_TUNE_WIN_MS)
+
+/// Link environment
+struct tune_link
+{
+    struct app_tune_stat stat;
+
+    /// Bytes of current window
+    uint32_t tx_win;
+    uint32_t rx_win;
+    /// Start time of current window
+    uint32_t win_start;
+
+    /// Mode forced by user, or TUNE_MODE_AUTO
+    uint8_t  force;
+    /// Windows below threshold continuously
+    uint8_t  idle_win;
+};
+
+static struct tune_link tune_env[BLE_CONNECTION_MAX];
+
+/// Connection param of mode
+static const struct gapc_conn_param tune_param[] =
+{
+    [TUNE_MODE_BULK]  = { APP_TUNE_BULK_INTV_MIN,  APP_TUNE_BULK_INTV_MAX,  APP_TUNE_BULK_LATENCY,  APP_TUNE_BULK_TIME_OUT  },
+    [TUNE_MODE_INTER] = { APP_TUNE_INTER_INTV_MIN, APP_TUNE_INTER_INTV_MAX, APP_TUNE_INTER_LATENCY, APP_TUNE_INTER_TIME_OUT },
+};
+
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+static void tune_param_apply(uint8_t conidx, uint8_t mode)
+{
+    struct tune_link *link = &tune_env[conidx];
+    const struct gapc_conn_param *param = &tune_param[mode];
+
+    link->stat.mode = mode;
+
+    // Already in range, no request
+    if ((link->stat.intv >= param->intv_min) && (link->stat.intv <= param->intv_max)
+        && (link->stat.latency == param->latency))
+    {
+        return;
+    }
+
+    DEBUG("tune mode(cid:%d,mode:%d,intv:%d~%d,late:%d)", conidx, mode,
+          param->intv_min, param->intv_max, param->latency);
+
+    link->stat.updates++;
+    gapc_update_param(conidx, param);
+}
+
+static void tune_step_next(uint8_t conidx)
+{
+    struct tune_link *link = &tune_env[conidx];
+
+    switch (link->stat.step)
+    {
+        case TUNE_STEP_DLE:
+        {
+            #if (APP_TUNE_PHY)
+            link->stat.step = TUNE_STEP_PHY;
+            gapc_update_phy(conidx, APP_TUNE_PHY, APP_TUNE_PHY, 0);
+            break;
+            #endif
+        } // fall through
+
+        case TUNE_STEP_PHY:
+        {
+            // last step, result in GATT_MTU_CHANGED_IND, read back when measure
+            link->stat.step = TUNE_STEP_DONE;
+            if (gatt_get_mtu(conidx) < BLE_MTU)
+            {
+                gatt_exmtu(conidx, BLE_MTU);
+            }
+
+            link->win_start = ble_time_get();
+            DEBUG("tune nego done(cid:%d)", conidx);
+        } break;
+
+        default:
+            break;
+    }
+}
+
+static void tune_win_close(uint8_t conidx, uint32_t dur)
+{
+    struct tune_link *link = &tune_env[conidx];
+    struct app_tune_stat *stat = &link->stat;
+
+    // B/s = bytes / (dur * 312.5us)
+    stat->tx_bps = link->tx_win * 3200 / dur;
+    stat->rx_bps = link->rx_win * 3200 / dur;
+    stat->mtu    = gatt_get_mtu(conidx);
+
+    uint32_t bps = (stat->tx_bps > stat->rx_bps) ? stat->tx_bps : stat->rx_bps;
+
+    if (bps > stat->peak_bps)
+    {
+        stat->peak_bps = bps;
+    }
+
+    link->tx_win = 0;
+    link->rx_win = 0;
+
+    DEBUG("tune stat(cid:%d,tx:%"PRIu32"B/s,rx:%"PRIu32"B/s,mtu:%d,dle:%d/%d,phy:%d/%d,intv:%d,late:%d)", conidx,
+          stat->tx_bps, stat->rx_bps, stat->mtu, stat->tx_octets, stat->rx_octets,
+          stat->tx_phy, stat->rx_phy, stat->intv, stat->latency);
+
+    if (link->force != TUNE_MODE_AUTO)
+    {
+        if (stat->mode != link->force)
+        {
+            tune_param_apply(conidx, link->force);
+        }
+        return;
+    }
+
+    if (bps >= APP_TUNE_BULK_BPS)
+    {
+        link->idle_win = 0;
+
+        if (stat->mode != TUNE_MODE_BULK)
+        {
+            tune_param_apply(conidx, TUNE_MODE_BULK);
+        }
+    }
+    else if ((stat->mode == TUNE_MODE_NONE) || (++link->idle_win >= APP_TUNE_IDLE_WIN))
+    {
+        link->idle_win = 0;
+
+        if (stat->mode != TUNE_MODE_INTER)
+        {
+            tune_param_apply(conidx, TUNE_MODE_INTER);
+        }
+    }
+}
+
+void app_tune_start(uint8_t conidx)
+{
+    struct tune_link *link = &tune_env[conidx];
+
+    memset(link, 0, sizeof(struct tune_link));
+    link->force = TUNE_MODE_AUTO;
+    link->stat.mtu = gatt_get_mtu(conidx);
+    link->stat.step = TUNE_STEP_DLE;
+
+    gapc_update_dle(conidx, LE_MAX_OCTETS, LE_MAX_TIME);
+}
+
+void app_tune_stop(uint8_t conidx)
+{
+    DEBUG("tune stop(cid:%d,tx:%"PRIu32",rx:%"PRIu32",peak:%"PRIu32"B/s,upd:%d)", conidx, tune_env[conidx].stat.tx_total,
+          tune_env[conidx].stat.rx_total, tune_env[conidx].stat.peak_bps, tune_env[conidx].stat.updates);
+
+    tune_env[conidx].stat.step = TUNE_STEP_OFF;
+}
+
+void app_tune_cmp(uint8_t conidx, uint8_t operation, uint8_t status)
+{
+    struct tune_link *link = &tune_env[conidx];
+
+    if (((operation == GAPC_SET_LE_PKT_SIZE) && (link->stat.step == TUNE_STEP_DLE))
+        || ((operation == GAPC_SET_PHY) && (link->stat.step == TUNE_STEP_PHY)))
+    {
+        if (status != GAP_ERR_NO_ERROR)
+        {
+            DEBUG("tune op:%d fail(sta:0x%X)", operation, status);
+        }
+
+        tune_step_next(conidx);
+    }
+    else if ((operation == GAPC_UPDATE_PARAMS) && (status != GAP_ERR_NO_ERROR))
+    {
+        // rejected, retry at next window
+        link->stat.mode = TUNE_MODE_NONE;
+    }
+}
+
+void app_tune_dle_ind(uint8_t conidx, uint16_t tx_octets, uint16_t rx_octets)
+{
+    tune_env[conidx].stat.tx_octets = tx_octets;
+    tune_env[conidx].stat.rx_octets = rx_octets;
+}
+
+void app_tune_phy_ind(uint8_t conidx, uint8_t tx_phy, uint8_t rx_phy)
+{
+    tune_env[conidx].stat.tx_phy = tx_phy;
+    tune_env[conidx].stat.rx_phy = rx_phy;
+}
+
+void app_tune_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out)
+{
+    tune_env[conidx].stat.intv     = intv;
+    tune_env[conidx].stat.latency  = latency;
+    tune_env[conidx].stat.time_out = time_out;
+}
+
+void app_tune_count(uint8_t conidx, uint16_t tx_len, uint16_t rx_len)
+{
+    struct tune_link *link = &tune_env[conidx];
+
+    link->tx_win += tx_len;
+    link->rx_win += rx_len;
+    link->stat.tx_total += tx_len;
+    link->stat.rx_total += rx_len;
+}
+
+void app_tune_mode(uint8_t conidx, uint8_t mode)
+{
+    struct tune_link *link = &tune_env[conidx];
+
+    link->force    = mode;
+    link->idle_win = 0;
+
+    if ((mode != TUNE_MODE_AUTO) && (link->stat.step == TUNE_STEP_DONE))
+    {
+        tune_param_apply(conidx, mode);
+    }
+}
+
+void app_tune_proc(void)
+{
+    uint32_t now = ble_time_get();
+
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        struct tune_link *link = &tune_env[conidx];
+
+        if (link->stat.step == TUNE_STEP_DONE)
+        {
+            uint32_t dur = BLE_TIME_DIFF(now, link->win_start);
+
+            if (dur >= TUNE_WIN_HS)
+            {
+                link->win_start = now;
+                tune_win_close(conidx, dur);
+            }
+        }
+    }
+}
+
+const struct app_tune_stat *app_tune_stat(uint8_t conidx)
+{
+    if ((conidx < BLE_CONNECTION_MAX) && (tune_env[conidx].stat.step != TUNE_STEP_OFF))
+    {
+        return &tune_env[conidx].stat;
+    }
+
+    return NULL;
+}
+
+#endif //(APP_TUNE_EN)
@@ -0,0 +1,189 @@
+/**
+ ****************************************************************************************
+ *
+ * @file app_tune.h
+ *
+ * @brief Header file - Link Throughput Tuner(DLE, PHY, MTU and Connection Parameters).
+ *
+ ****************************************************************************************
+ */
+
+#ifndef APP_TUNE_H_
+#define APP_TUNE_H_
+
+/*
+ * INCLUDE FILES
+ ****************************************************************************************
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Enable of Tuner, negotiate when connected then adapt param to workload
+#if !defined(APP_TUNE_EN)
+    #define APP_TUNE_EN              (0)
+#endif
+
+/// PHY to request after DLE(0: skip, keep BLE_PHY) @see enum gap_phy
+#if !defined(APP_TUNE_PHY)
+    #define APP_TUNE_PHY             (0x02) // GAP_PHY_LE_2MBPS
+#endif
+
+/// Window to measure throughput, unit in 1ms
+#if !defined(APP_TUNE_WIN_MS)
+    #define APP_TUNE_WIN_MS          (1000)
+#endif
+
+/// Throughput(B/s) of one direction to go bulk mode
+#if !defined(APP_TUNE_BULK_BPS)
+    #define APP_TUNE_BULK_BPS        (2000)
+#endif
+
+/// Continuous windows below threshold to back interactive mode
+#if !defined(APP_TUNE_IDLE_WIN)
+    #define APP_TUNE_IDLE_WIN        (3)
+#endif
+
+/// Bulk mode: short interval, no latency (interval unit in 1.25ms, timeout in 10ms)
+#if !defined(APP_TUNE_BULK_INTV_MIN)
+    #define APP_TUNE_BULK_INTV_MIN   (6)
+    #define APP_TUNE_BULK_INTV_MAX   (12)
+    #define APP_TUNE_BULK_LATENCY    (0)
+    #define APP_TUNE_BULK_TIME_OUT   (300)
+#endif
+
+/// Interactive mode: longer interval with latency to save power
+#if !defined(APP_TUNE_INTER_INTV_MIN)
+    #define APP_TUNE_INTER_INTV_MIN  (24)
+    #define APP_TUNE_INTER_INTV_MAX  (40)
+    #define APP_TUNE_INTER_LATENCY   (2)
+    #define APP_TUNE_INTER_TIME_OUT  (400)
+#endif
+
+/// Workload mode of link
+enum tune_mode
+{
+    // Not decided, wait first window
+    TUNE_MODE_NONE           = 0,
+    // Bulk transfer, favor throughput
+    TUNE_MODE_BULK,
+    // Interactive, favor power with bounded latency
+    TUNE_MODE_INTER,
+
+    // Follow workload measured, only for app_tune_mode()
+    TUNE_MODE_AUTO           = 0xFF,
+};
+
+/// Negotiation step of link
+enum tune_step
+{
+    TUNE_STEP_OFF            = 0,
+    TUNE_STEP_DLE,
+    TUNE_STEP_PHY,
+    TUNE_STEP_DONE,
+};
+
+/// Live statistics of link
+struct app_tune_stat
+{
+    /// Negotiated result
+    uint16_t mtu;
+    uint16_t tx_octets;
+    uint16_t rx_octets;
+    uint8_t  tx_phy;
+    uint8_t  rx_phy;
+
+    /// Connection param in use
+    uint16_t intv;
+    uint16_t latency;
+    uint16_t time_out;
+
+    /// Throughput of last window, unit in B/s
+    uint32_t tx_bps;
+    uint32_t rx_bps;
+    /// Peak of tx_bps and rx_bps since connected
+    uint32_t peak_bps;
+
+    /// Total bytes since connected
+    uint32_t tx_total;
+    uint32_t rx_total;
+
+    /// Current mode @see enum tune_mode, step @see enum tune_step
+    uint8_t  mode;
+    uint8_t  step;
+    /// Number of param update requested
+    uint8_t  updates;
+};
+
+
+/*
+ * FUNCTION DECLARATIONS
+ ****************************************************************************************
+ */
+
+#if (APP_TUNE_EN)
+/**
+ ****************************************************************************************
+ * @brief Start negotiation on link established: DLE -> PHY -> MTU.
+ *
+ * @param[in] conidx  connection index
+ ****************************************************************************************
+ */
+void app_tune_start(uint8_t conidx);
+
+/// Stop on link lost
+void app_tune_stop(uint8_t conidx);
+
+/// Feed of GAPC events, called in app_gapc.c
+void app_tune_cmp(uint8_t conidx, uint8_t operation, uint8_t status);
+void app_tune_dle_ind(uint8_t conidx, uint16_t tx_octets, uint16_t rx_octets);
+void app_tune_phy_ind(uint8_t conidx, uint8_t tx_phy, uint8_t rx_phy);
+void app_tune_param_ind(uint8_t conidx, uint16_t intv, uint16_t latency, uint16_t time_out);
+
+/**
+ ****************************************************************************************
+ * @brief Count application data of link, measure workload.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] tx_len  length of data sent
+ * @param[in] rx_len  length of data received
+ ****************************************************************************************
+ */
+void app_tune_count(uint8_t conidx, uint16_t tx_len, uint16_t rx_len);
+
+/**
+ ****************************************************************************************
+ * @brief Force mode of link, or TUNE_MODE_AUTO to follow workload.
+ *
+ * @param[in] conidx  connection index
+ * @param[in] mode    @see enum tune_mode
+ ****************************************************************************************
+ */
+void app_tune_mode(uint8_t conidx, uint8_t mode);
+
+/**
+ ****************************************************************************************
+ * @brief Poll in main loop, close window and adapt connection param.
+ ****************************************************************************************
+ */
+void app_tune_proc(void);
+
+/**
+ ****************************************************************************************
+ * @brief Get live statistics of link.
+ *
+ * @param[in] conidx  connection index
+ *
+ * @return Pointer of statistics, NULL if not connected.
+ ****************************************************************************************
+ */
+const struct app_tune_stat *app_tune_stat(uint8_t conidx);
+#endif //(APP_TUNE_EN)
+
+#endif // APP_TUNE_H_
@@ -18,6 +18,12 @@
 
 #include "prf.h"
 #include "hid_desc.h"   // application-specific, #include "prf_hids.h"
+#include "app_lstat.h"
+#include "app_slat.h"
+
+#if (HID_RPT_MERGE)
+#include "bledef.h"
+#endif
 
 #if (DBG_HIDS)
 #include "dbg.h"
@@ -98,6 +104,35 @@ typedef struct hids_env_tag
 /// Global Variable Declarations
 __VAR_ENV hids_env_t hids_env;
 
+#if (HID_RPT_MERGE)
+#if (HID_MERGE_INFLIGHT < 1) || (HID_MERGE_INFLIGHT > HID_NB_PKT_MAX)
+#error "HID_MERGE_INFLIGHT out of range"
+#endif
+
+/// Report released key(s) of previous state, not collapse into it
+#define HID_RPT_REL             (0x01)
+
+/// Pending report
+typedef struct hid_rpt_tag
+{
+    uint8_t  rep_idx;
+    uint8_t  rep_len;
+    uint8_t  flags;
+    uint8_t  rep_val[HID_MERGE_LEN];
+} hid_rpt_t;
+
+/// Merge queue of each connection, reports kept in order
+typedef struct hid_mrgq_tag
+{
+    uint8_t  head;
+    uint8_t  cnt;
+    struct hid_merge_stat stat;
+    hid_rpt_t rpt[HID_MERGE_DEPTH];
+} hid_mrgq_t;
+
+static hid_mrgq_t hids_mrgq[HID_CONN_MAX];
+#endif //(HID_RPT_MERGE)
+
 
 /**
  ****************************************************************************************
@@ -764,6 +799,267 @@ static void hids_att_read_cfm(uint8_t conidx, uint8_t att_idx, uint16_t handle)
     }
 }
 
+/// Notify report if buffer free
+static uint8_t hids_ntf_send(uint8_t conidx, uint8_t rep_idx, uint16_t rep_len, const uint8_t* rep_val)
+{
+    uint8_t status = PRF_ERR_REQ_DISALLOWED;
+
+    if ((rep_len > 0) && (hids_env.nb_pkt > 0))
+    {
+        if (HID_RPT_NTF_GET(conidx, rep_idx) == PRF_CLI_START_NTF)
+        {
+            uint16_t handle = hids_get_rpt_handle(rep_idx);
+
+            if (handle != ATT_INVALID_HDL)
+            {
+                hids_env.nb_pkt--; // allocate
+                DEBUG("hid_ntf_send(len:%d,nb:%d)", rep_len, hids_env.nb_pkt);
+                debugHex(rep_val, rep_len);
+                gatt_ntf_send(conidx, handle, rep_len, rep_val);
+                status = LE_SUCCESS;
+            }
+        }
+        else
+        {
+            status = PRF_ERR_NTF_DISABLED;
+        }
+    }
+
+    #if (LINK_STAT)
+    if (status == LE_SUCCESS)
+        lstat_ntf_queued(conidx);
+    else if (rep_len > 0)
+        lstat_ntf_busy(conidx);
+    #endif
+
+    return status;
+}
+
+#if (HID_RPT_MERGE)
+/// Boot mouse X/Y/Wheel range, fixed by HID spec
+#define HID_BOOT_MOUSE_MIN      (-127)
+#define HID_BOOT_MOUSE_MAX      (127)
+
+/// Add relative value within logical range, part out of range left in 'add'(0 if none)
+static int32_t hids_rel_add(int32_t val, int32_t *add, int32_t min, int32_t max)
+{
+    val += *add;
+
+    if (val > max)
+    {
+        *add = val - max;
+        val  = max;
+    }
+    else if (val < min)
+    {
+        *add = val - min;
+        val  = min;
+    }
+    else
+    {
+        *add = 0;
+    }
+
+    return val;
+}
+
+/// Keyboard state: modifiers at [0], keycodes at [2..], true if all keys of 'sub' also in 'val'
+static bool hids_kb_subset(const uint8_t *sub, const uint8_t *val, uint8_t len)
+{
+    if ((sub[0] & ~val[0]) != 0)
+    {
+        return false;
+    }
+
+    for (uint8_t i = 2; i < len; i++)
+    {
+        if (sub[i] && (memchr(&val[2], sub[i], len - 2) == NULL))
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Merge new report into pending one of same index.
+ *   - Mouse: same buttons, sum X/Y/Wheel deltas within logical range. Part out of
+ *     range left in 'val' as remainder and not merged, to be queued as new report.
+ *   - Keyboard: pending one only pressed keys, newer state is superset of it.
+ *   - Others: same value, duplicate state.
+ *   If force(queue full), merge anyway and newest buttons/keys win, remainder lost.
+ *
+ * @return true if merged
+ ****************************************************************************************
+ */
+static bool hids_rpt_merge(hid_rpt_t *rpt, uint8_t *val, bool force)
+{
+    uint8_t len = rpt->rep_len;
+
+    if ((rpt->rep_idx == RPT_IDX_MOUSE) || (rpt->rep_idx == RPT_IDX_BOOT_MOUSE))
+    {
+        bool carry = false;
+        int32_t add;
+
+        if ((rpt->rep_val[0] != val[0]) && !force)
+        {
+            return false;
+        }
+
+        rpt->rep_val[0] = val[0];
+
+        if ((rpt->rep_idx == RPT_IDX_MOUSE) && (len >= 5))
+        {
+            // 1B(button) + 2B(X) + 2B(Y) + 1B(Wheel)
+            for (uint8_t i = 1; i < 5; i += 2)
+            {
+                add = (int16_t)read16p(&val[i]);
+                write16p(&rpt->rep_val[i], (uint16_t)hids_rel_add((int16_t)read16p(&rpt->rep_val[i]), &add,
+                                                                  HID_MOUSE_XY_MIN, HID_MOUSE_XY_MAX));
+                write16p(&val[i], (uint16_t)add);
+                carry |= (add != 0);
+            }
+
+            if (len >= 6)
+            {
+                add = (int8_t)val[5];
+                rpt->rep_val[5] = hids_rel_add((int8_t)rpt->rep_val[5], &add, HID_MOUSE_WHEEL_MIN, HID_MOUSE_WHEEL_MAX);
+                val[5] = add;
+                carry |= (add != 0);
+            }
+        }
+        else
+        {
+            // 1B(button) + 1B(X) + 1B(Y) + 1B(Wheel)
+            for (uint8_t i = 1; (i < len) && (i < 4); i++)
+            {
+                add = (int8_t)val[i];
+                rpt->rep_val[i] = hids_rel_add((int8_t)rpt->rep_val[i], &add, HID_BOOT_MOUSE_MIN, HID_BOOT_MOUSE_MAX);
+                val[i] = add;
+                carry |= (add != 0);
+            }
+        }
+
+        // pending one full, remainder carried into new report
+        return (!carry || force);
+    }
+
+    if (((rpt->rep_idx == RPT_IDX_KB) || (rpt->rep_idx == RPT_IDX_BOOT_KB)) && (len > 2))
+    {
+        if (!force && ((rpt->flags & HID_RPT_REL) || !hids_kb_subset(rpt->rep_val, val, len)))
+        {
+            return false;
+        }
+    }
+    else if (!force && (memcmp(rpt->rep_val, val, len) != 0))
+    {
+        return false;
+    }
+
+    memcpy(rpt->rep_val, val, len);
+    return true;
+}
+
+/// Notify pending reports in order, keep no more than HID_MERGE_INFLIGHT in flight
+static void hids_merge_flush(uint8_t conidx)
+{
+    hid_mrgq_t *mq = &hids_mrgq[conidx];
+
+    if (gapc_get_conhdl(conidx) == GAP_INVALID_CONHDL)
+    {
+        // peer gone, drop pending
+        mq->head = mq->cnt = 0;
+        return;
+    }
+
+    while ((mq->cnt > 0) && ((HID_NB_PKT_MAX - hids_env.nb_pkt) < HID_MERGE_INFLIGHT))
+    {
+        hid_rpt_t *rpt = &mq->rpt[mq->head];
+
+        // failed one(notify disabled) dropped also
+        if (hids_ntf_send(conidx, rpt->rep_idx, rpt->rep_len, rpt->rep_val) == LE_SUCCESS)
+        {
+            mq->stat.sent++;
+        }
+
+        mq->head = (mq->head + 1) % HID_MERGE_DEPTH;
+        mq->cnt--;
+    }
+}
+
+/// Queue report, merge into pending one of same index if possible
+static uint8_t hids_merge_push(uint8_t conidx, uint8_t rep_idx, uint16_t rep_len, const uint8_t* rep_val)
+{
+    hid_mrgq_t *mq = &hids_mrgq[conidx];
+    hid_rpt_t *last = NULL;
+    uint8_t val[HID_MERGE_LEN];
+
+    if (HID_RPT_NTF_GET(conidx, rep_idx) != PRF_CLI_START_NTF)
+    {
+        return PRF_ERR_NTF_DISABLED;
+    }
+
+    if (hids_get_rpt_handle(rep_idx) == ATT_INVALID_HDL)
+    {
+        return PRF_ERR_REQ_DISALLOWED;
+    }
+
+    mq->stat.reports++;
+
+    // mouse delta out of range left here by merge
+    memcpy(val, rep_val, rep_len);
+
+    // latest pending of same index
+    for (uint8_t i = mq->cnt; i > 0; i--)
+    {
+        hid_rpt_t *rpt = &mq->rpt[(mq->head + i - 1) % HID_MERGE_DEPTH];
+
+        if (rpt->rep_idx == rep_idx)
+        {
+            if (rpt->rep_len == rep_len)
+            {
+                last = rpt;
+            }
+            break;
+        }
+    }
+
+    if ((last != NULL) && hids_rpt_merge(last, val, false))
+    {
+        mq->stat.merged++;
+    }
+    else if (mq->cnt < HID_MERGE_DEPTH)
+    {
+        hid_rpt_t *rpt = &mq->rpt[(mq->head + mq->cnt) % HID_MERGE_DEPTH];
+
+        rpt->rep_idx = rep_idx;
+        rpt->rep_len = rep_len;
+        // unknown previous state if sent already, treat as released
+        rpt->flags   = ((last == NULL) || !hids_kb_subset(last->rep_val, val, rep_len)) ? HID_RPT_REL : 0;
+        memcpy(rpt->rep_val, val, rep_len);
+
+        if (++mq->cnt > mq->stat.depth_max)
+        {
+            mq->stat.depth_max = mq->cnt;
+        }
+    }
+    else if ((last != NULL) && hids_rpt_merge(last, val, true))
+    {
+        mq->stat.forced++;
+    }
+    else
+    {
+        mq->stat.drops++;
+        return PRF_ERR_REQ_DISALLOWED;
+    }
+
+    hids_merge_flush(conidx);
+    return LE_SUCCESS;
+}
+#endif //(HID_RPT_MERGE)
+
 /// Handles reception of the atts request from peer device
 static void hids_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const void *param)
 {
@@ -803,6 +1099,28 @@ static void hids_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const
             hids_env.nb_pkt++; // release
 
             DEBUG("  cmp_evt(op:0x%x,sta:0x%x,nb:%d)", evt->operation, evt->status, hids_env.nb_pkt);
+
+            #if (LINK_STAT)
+            if ((evt->operation == GATT_NOTIFY) || (evt->operation == GATT_INDICATE))
+            {
+                lstat_ntf_cmp(conidx, evt->status);
+            }
+            #endif
+
+            #if (APP_SLAT_EN)
+            if (evt->operation == GATT_NOTIFY)
+            {
+                app_slat_sent(conidx);
+            }
+            #endif
+
+            #if (HID_RPT_MERGE)
+            // freshest pending reports out in next connection event
+            for (uint8_t idx = 0; idx < HID_CONN_MAX; idx++)
+            {
+                hids_merge_flush(idx);
+            }
+            #endif
             // add 'if' to avoid warning #117-D: "evt" never referenced
             if (evt->operation == GATT_NOTIFY)
             {
@@ -899,31 +1217,34 @@ void hids_set_ccc(uint8_t conidx, uint8_t rpt_ntf)
  */
 uint8_t hids_report_send(uint8_t conidx, uint8_t rep_idx, uint16_t rep_len, const uint8_t* rep_val)
 {
-    uint8_t status = PRF_ERR_REQ_DISALLOWED;
+    #if (APP_SLAT_EN)
+    // input activity, leave idle before report queued
+    app_slat_input(conidx);
+    #endif
 
-    if ((rep_len > 0) && (hids_env.nb_pkt > 0))
+    #if (HID_RPT_MERGE)
+    if ((rep_len > 0) && (rep_len <= HID_MERGE_LEN))
     {
-        if (HID_RPT_NTF_GET(conidx, rep_idx) == PRF_CLI_START_NTF)
-        {
-            uint16_t handle = hids_get_rpt_handle(rep_idx);
+        return hids_merge_push(conidx, rep_idx, rep_len, rep_val);
+    }
 
-            if (handle != ATT_INVALID_HDL)
-            {
-                hids_env.nb_pkt--; // allocate
-                DEBUG("hid_ntf_send(len:%d,nb:%d)", rep_len, hids_env.nb_pkt);
-                debugHex(rep_val, rep_len);
-                gatt_ntf_send(conidx, handle, rep_len, rep_val);
-                status = LE_SUCCESS;
-            }
-        }
-        else
-        {
-            status = PRF_ERR_NTF_DISABLED;
-        }
+    // longer report not queued, not overtake pending ones to keep input order
+    hids_merge_flush(conidx);
+    if (hids_mrgq[conidx].cnt > 0)
+    {
+        return PRF_ERR_REQ_DISALLOWED;
     }
+    #endif
 
-    return status;
+    return hids_ntf_send(conidx, rep_idx, rep_len, rep_val);
+}
+
+#if (HID_RPT_MERGE)
+const struct hid_merge_stat *hids_merge_stat(uint8_t conidx)
+{
+    return &hids_mrgq[conidx].stat;
 }
+#endif //(HID_RPT_MERGE)
 
 
 #endif //(PRF_HIDS)
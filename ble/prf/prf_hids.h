@@ -34,6 +34,45 @@
     #define HID_REPORT_MAX_LEN      (64)
 #endif
 
+/// Merge pending reports when link busy: mouse deltas summed, keyboard presses collapsed
+#if !defined(HID_RPT_MERGE)
+    #define HID_RPT_MERGE           (0)
+#endif
+
+#if (HID_RPT_MERGE)
+/// Number of pending reports of each connection
+#if !defined(HID_MERGE_DEPTH)
+    #define HID_MERGE_DEPTH         (8)
+#endif
+
+/// Maximal length of report to merge, longer ones sent as-is once pending reports sent
+#if !defined(HID_MERGE_LEN)
+    #define HID_MERGE_LEN           (8)
+#endif
+
+/// Reports in flight, the others wait and merge (1 ~ HID_NB_PKT_MAX)
+#if !defined(HID_MERGE_INFLIGHT)
+    #define HID_MERGE_INFLIGHT      (2)
+#endif
+
+/// Logical range of mouse X/Y and Wheel in Report Map, merged deltas kept in it
+#if !defined(HID_MOUSE_XY_MIN)
+    #define HID_MOUSE_XY_MIN        (-248)
+#endif
+
+#if !defined(HID_MOUSE_XY_MAX)
+    #define HID_MOUSE_XY_MAX        (255)
+#endif
+
+#if !defined(HID_MOUSE_WHEEL_MIN)
+    #define HID_MOUSE_WHEEL_MIN     (-127)
+#endif
+
+#if !defined(HID_MOUSE_WHEEL_MAX)
+    #define HID_MOUSE_WHEEL_MAX     (127)
+#endif
+#endif //(HID_RPT_MERGE)
+
 /// Size of HID BOOT keyboard/mouse report
 #define HID_BOOT_REPORT_MAX_LEN     (8)
 #define HID_BOOT_KB_RPT_SIZE        (8) // 1B(ctrlKeys) + 1B(resv0) + 6B(KeyCode)
@@ -120,6 +159,26 @@ struct hid_report_ref
 };
 
 
+#if (HID_RPT_MERGE)
+/// Statistics of merge queue
+struct hid_merge_stat
+{
+    /// Reports from application
+    uint32_t reports;
+    /// Reports notified
+    uint32_t sent;
+    /// Reports merged into pending one
+    uint32_t merged;
+    /// Queue full, merged with button/key transition lost
+    uint32_t forced;
+    /// Queue full and nothing to merge, rejected
+    uint32_t drops;
+    /// Max number of pending reports
+    uint8_t  depth_max;
+};
+#endif //(HID_RPT_MERGE)
+
+
 /*
  * FUNCTION DECLARATIONS
  ****************************************************************************************
@@ -162,10 +221,15 @@ void hids_set_ccc(uint8_t conidx, uint8_t rpt_ntf);
  * @param[in] rep_idx  Report Index
  * @param[in] rep_len  Report Length
  * @param[in] rep_val  Report Value
- * @return Status of the operation @see prf_err
+ * @return Status of the operation @see prf_err, LE_SUCCESS also if queued(HID_RPT_MERGE)
  ****************************************************************************************
  */
 uint8_t hids_report_send(uint8_t conidx, uint8_t rep_idx, uint16_t rep_len, const uint8_t* rep_val);
 
+#if (HID_RPT_MERGE)
+/// Statistics of merge queue
+const struct hid_merge_stat *hids_merge_stat(uint8_t conidx);
+#endif //(HID_RPT_MERGE)
+
 
 #endif /* PRF_HIDS_H_ */
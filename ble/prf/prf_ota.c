@@ -21,6 +21,7 @@
 #include "app.h"
 #include "prf.h"
 #include "prf_ota.h"
+#include "CRCxx.h"
 
 #if (DBG_OTA)
 #include "dbg.h"
@@ -103,11 +104,125 @@
 #error "ERROR, Receive Buff NOT PAGE ALIGN."
 #endif
 
+/// 支持压缩镜像(heatshrink LZSS格式), 接收时流式解压到recv_data再写flash
+/// 主机压缩命令: heatshrink -e -w OTA_LZ_WINDOW_SZ2 -l OTA_LZ_LOOKAHEAD_SZ2
+#ifndef OTA_LZ_SUP
+#define OTA_LZ_SUP (0)
+#endif
+
+#if (OTA_LZ_SUP)
+/// Window size in bits(window = 1 << sz2 bytes of SRAM)
+#ifndef OTA_LZ_WINDOW_SZ2
+#define OTA_LZ_WINDOW_SZ2 (8)
+#endif
+
+/// Lookahead size in bits(max backref count = 1 << sz2)
+#ifndef OTA_LZ_LOOKAHEAD_SZ2
+#define OTA_LZ_LOOKAHEAD_SZ2 (4)
+#endif
+
+#if ((OTA_LZ_WINDOW_SZ2 < 4) || (OTA_LZ_WINDOW_SZ2 > 15) || (OTA_LZ_LOOKAHEAD_SZ2 < 3) ||       \
+    (OTA_LZ_LOOKAHEAD_SZ2 >= OTA_LZ_WINDOW_SZ2))
+#error "ERROR, Invalid OTA_LZ_WINDOW_SZ2 or OTA_LZ_LOOKAHEAD_SZ2."
+#endif
+
+#define OTA_LZ_WINDOW_SIZE (1UL << OTA_LZ_WINDOW_SZ2)
+#define OTA_LZ_WINDOW_MASK (OTA_LZ_WINDOW_SIZE - 1)
+
+/// Decoder state, field being collected from bit stream
+enum ota_lz_state
+{
+    LZ_STA_TAG,
+    LZ_STA_LITERAL,
+    LZ_STA_INDEX,
+    LZ_STA_COUNT,
+};
+
+/// Streaming decoder of heatshrink(LZSS) image
+struct ota_lz_tag
+{
+    uint16_t head;
+    uint16_t index;
+    uint16_t bits;
+    uint8_t  bit_ct;
+    uint8_t  state;
+    uint8_t  window[OTA_LZ_WINDOW_SIZE];
+};
+#endif // OTA_LZ_SUP
+
+/// 支持差分升级: 由当前运行bank + 补丁流(块拷贝/字面数据)重建新镜像
+/// 补丁生成及校验工具: tools\ota_diff.py
+#ifndef OTA_DIFF_SUP
+#define OTA_DIFF_SUP (0)
+#endif
+
+#if (OTA_DIFF_SUP)
+/// Max size of running image referenced by COPY record
+#define OTA_DIFF_SRC_MAX (OTA_BANK_B_BASE - OTA_BANK_A_BASE)
+
+/// Patch record opcode, fields in little endian
+enum ota_diff_op
+{
+    // 0x01 Src(4) Len(2): copy Len bytes from running bank at offset Src
+    OTA_DIFF_COPY = 0x01,
+    // 0x02 Len(2) Data(Len): literal bytes
+    OTA_DIFF_DATA = 0x02,
+};
+
+/// Patch stream applier
+struct ota_diff_tag
+{
+    uint32_t src_base;
+    uint16_t remain;
+    uint8_t  hdr_len;
+    uint8_t  hdr[7];
+};
+#endif // OTA_DIFF_SUP
+
+#define OTA_DEC_SUP (OTA_LZ_SUP || OTA_DIFF_SUP)
+
+/// 窗口传输: 包按序号放入独立环形缓存ota_win_buff, 允许乱序, 通过SACK位图选择性重传,
+/// 连续数据满页即写flash, 无需等待OTA_CMD_DATA_WR往返. 仅支持原始bin
+#ifndef OTA_WIN_SUP
+#define OTA_WIN_SUP (0)
+#endif
+
+#if (OTA_WIN_SUP)
+/// Max packets in flight, width of SACK bitmap
+#define OTA_WIN_MAX     (32)
+
+/// Ring buffer of window: OTA_WIN_MAX packets of max length, plus one page not yet written
+#ifndef OTA_WIN_BUFF_LEN
+#define OTA_WIN_BUFF_LEN (ALIGN(OTA_WIN_MAX * (OTA_PKT_LEN - OTA_DATA_POS), FLASH_PAGE_SIZE) + FLASH_PAGE_SIZE)
+#endif
+
+#if ((OTA_WIN_BUFF_LEN <= FLASH_PAGE_SIZE) || (OTA_WIN_BUFF_LEN % FLASH_PAGE_SIZE))
+#error "ERROR, Window Buff NOT PAGE ALIGN."
+#endif
+
+/// Window receiver
+struct ota_win_tag
+{
+    uint32_t bitmap;
+    uint32_t wr_pos;
+    uint32_t time;
+    uint16_t base;
+    uint16_t ack_base;
+    uint16_t plen;
+    uint16_t retx;
+    uint8_t  nb;
+    uint8_t  gap;
+};
+#endif // OTA_WIN_SUP
+
 enum ota_flag
 {
     FLAG_OTA_NTF  = 0x01,
     FLAG_OTA_END  = 0x02,
     FLAG_OTA_PROC = 0x04,
+    FLAG_OTA_LZ   = 0x08,
+    FLAG_OTA_DIFF = 0x10,
+    FLAG_OTA_WIN  = 0x20,
 };
 
 #define OTA_FLAG_SET(flag) (ota_env.ota_flag |= (flag))
@@ -132,17 +247,33 @@ struct ota_env_tag
 {
     uint32_t bank;
     uint32_t bin_len;
-    uint32_t data_sum;
+    uint32_t data_crc;
     uint16_t ota_flag;
     uint16_t start_hdl;
     uint16_t pkt_idx;
     uint16_t data_pos;
+    uint32_t bin_size;
+    uint32_t er_pos;
+#if (OTA_LZ_SUP)
+    struct ota_lz_tag lz;
+#endif
+#if (OTA_DIFF_SUP)
+    struct ota_diff_tag diff;
+#endif
+#if (OTA_WIN_SUP)
+    struct ota_win_tag win;
+#endif
     uint8_t  recv_data[OTA_BUFF_LEN];
 } __DATA_ALIGNED(4);
 
 /// Global Variable Declarations
 __ATTR_SRAM struct ota_env_tag ota_env;
 
+#if (OTA_WIN_SUP)
+/// Window ring buffer, apart from recv_data to keep whole SACK bitmap in flight
+__ATTR_SRAM static uint8_t ota_win_buff[OTA_WIN_BUFF_LEN] __DATA_ALIGNED(4);
+#endif
+
 /**
  ****************************************************************************************
  * @section ATTRIBUTES DEFINITION
@@ -424,7 +555,6 @@ uint8_t ota_ntf_send(uint8_t conidx, uint16_t len, const uint8_t *data)
  ****************************************************************************************
  */
 
-#if (CFG_USE_LOAD)
 OTA_SRAMFN(block_er) static void flash_b64k_erase(uint32_t offset)
 {
     GLOBAL_INT_DISABLE();
@@ -433,13 +563,13 @@ OTA_SRAMFN(block_er) static void flash_b64k_erase(uint32_t offset)
 
     CACHE->CCR.Word    = 0; // disable cache
     CACHE->CIR.INV_ALL = 1; // flush cache
-    fshc_erase(offset, 0xD8 /*FSH_CMD_ER_B64K*/);
+    fshc_erase(offset, FSH_CMD_ER_BLOCK64);
     CACHE->CCR.Word = 1;    // enable cache
 
     GLOBAL_INT_RESTORE();
 }
-#else
-OTA_SRAMFN(block_er) static void flash_sector_erase(uint32_t offset)
+
+OTA_SRAMFN(sector_er) static void flash_sector_erase(uint32_t offset)
 {
     GLOBAL_INT_DISABLE();
 
@@ -453,6 +583,7 @@ OTA_SRAMFN(block_er) static void flash_sector_erase(uint32_t offset)
     GLOBAL_INT_RESTORE();
 }
 
+#if (!CFG_USE_LOAD)
 OTA_SRAMFN(wr_protect) void flash_wr_protect(uint8_t val)
 {
     GLOBAL_INT_DISABLE();
@@ -491,6 +622,7 @@ typedef void (*flash_wr_rd)(uint32_t, uint32_t *, uint32_t);
 struct ota_flash_op_tag
 {
     flash_er volatile block_er;
+    flash_er volatile sector_er;
 #if (!CFG_USE_LOAD)
     flash_er volatile page_er;
     flash_wr_reg volatile wr_reg;
@@ -500,15 +632,14 @@ struct ota_flash_op_tag
 };
 
 const struct ota_flash_op_tag ota_flash_op = {
-#if (CFG_USE_LOAD)
-    .block_er = flash_b64k_erase,
-#else
-    .block_er = flash_sector_erase,
-    .page_er  = flash_page_erase,
-    .wr_reg   = flash_wr_protect,
+    .block_er  = flash_b64k_erase,
+    .sector_er = flash_sector_erase,
+#if (!CFG_USE_LOAD)
+    .page_er   = flash_page_erase,
+    .wr_reg    = flash_wr_protect,
 #endif
-    .word_wr = flash_write,
-    .word_rd = flash_read,
+    .word_wr   = flash_write,
+    .word_rd   = flash_read,
 };
 
 // State/CMD/Head
@@ -516,8 +647,9 @@ enum ota_info
 {
     /************************************/
     // state
-    OTA_OK  = 0x00,
-    OTA_ERR = 0x01,
+    OTA_OK   = 0x00,
+    OTA_ERR  = 0x01,
+    OTA_BUSY = 0x02,
 
     /************************************/
     // cmd
@@ -526,6 +658,7 @@ enum ota_info
     OTA_CMD_DATA_WC,
     OTA_CMD_DATA_WR,
     OTA_CMD_END,
+    OTA_CMD_DATA_WIN,
 
     /************************************/
     // head
@@ -533,10 +666,456 @@ enum ota_info
     OTA_CMD_HEAD = 0xBA,
 };
 
+// Image mode of OTA_CMD_START, optional byte after Reset_Handler
+enum ota_mode
+{
+    OTA_MODE_RAW  = 0x00,
+    OTA_MODE_LZ   = 0x01,
+    OTA_MODE_DIFF = 0x02,
+    // bit7: windowed transport with OTA_CMD_DATA_WIN
+    OTA_MODE_WIN  = 0x80,
+};
+
 static bool is_no_ota_cmd(uint8_t ota_cmd)
 {
-    return ((ota_cmd < OTA_CMD_VER) || (ota_cmd > OTA_CMD_END));
+    return ((ota_cmd < OTA_CMD_VER) || (ota_cmd > OTA_CMD_DATA_WIN));
+}
+
+/// Write one page to bank, erase just ahead of write pointer
+static void ota_page_write(uint32_t wr_offset, const uint8_t *page)
+{
+    while (wr_offset + FLASH_PAGE_SIZE > ota_env.er_pos)
+    {
+#if (CFG_USE_LOAD)
+        // bankB仅用于存储, 可整块擦除
+        uint32_t blk_lmt = FLASH_SIZE;
+#else
+        // 整个64KB块都将写入时才用块擦除, 避免擦到bank外数据
+        uint32_t blk_lmt = ota_env.bank + ota_env.bin_size;
+#endif
+
+        if (((ota_env.er_pos % FLASH_B64K_SIZE) == 0) && (ota_env.er_pos + FLASH_B64K_SIZE <= blk_lmt))
+        {
+            ota_flash_op.block_er(ota_env.er_pos);
+            ota_env.er_pos += FLASH_B64K_SIZE;
+        }
+        else
+        {
+            ota_flash_op.sector_er(ota_env.er_pos);
+            ota_env.er_pos += FLASH_SECTOR_SIZE;
+        }
+    }
+
+    ota_flash_op.word_wr(wr_offset, (uint32_t *)page, FLASH_PAGE_SIZE_WLEN);
+}
+
+/// Write received buffer to flash, page by page
+static void ota_buff_write(uint32_t wr_offset, uint16_t length)
+{
+#if (OTA_BUFF_LEN > FLASH_PAGE_SIZE)
+
+    uint8_t page_num = (length / FLASH_PAGE_SIZE) + (!!(length % FLASH_PAGE_SIZE));
+
+    for (uint8_t i = 0; i < page_num; ++i)
+    {
+        ota_page_write(wr_offset, ota_env.recv_data + i * FLASH_PAGE_SIZE);
+        wr_offset += FLASH_PAGE_SIZE;
+    }
+#else
+    ota_page_write(wr_offset, ota_env.recv_data);
+#endif
+}
+
+/// Read back image from bank, return CRC-32 of flash content
+static uint32_t ota_bank_crc(void)
+{
+    uint32_t crc    = 0;
+    uint32_t offset = 0;
+
+    while (offset < ota_env.bin_len)
+    {
+        uint32_t length = ota_env.bin_len - offset;
+
+        if (length > OTA_BUFF_LEN)
+        {
+            length = OTA_BUFF_LEN;
+        }
+
+        ota_flash_op.word_rd(ota_env.bank + offset, (uint32_t *)ota_env.recv_data, ALIGN(length, 4) >> 2);
+        crc     = crc32_update(crc, ota_env.recv_data, length);
+        offset += length;
+    }
+
+    return crc;
+}
+
+#if (OTA_DEC_SUP)
+/// Write decoded bytes in recv_data, tail padding with 0xFF
+static void ota_dec_flush(void)
+{
+    uint16_t length = ota_env.data_pos;
+
+    if (length)
+    {
+        uint32_t wr_offset = ota_env.bank + ota_env.bin_len - length;
+
+        ota_env.data_crc = crc32_update(ota_env.data_crc, ota_env.recv_data, length);
+        memset(ota_env.recv_data + length, 0xFF, ALIGN(length, FLASH_PAGE_SIZE) - length);
+        ota_buff_write(wr_offset, length);
+        ota_env.data_pos = 0;
+    }
+}
+
+static void ota_dec_output(uint8_t byte)
+{
+    ota_env.recv_data[ota_env.data_pos++] = byte;
+    ota_env.bin_len++;
+
+    if (ota_env.data_pos == OTA_BUFF_LEN)
+    {
+        ota_dec_flush();
+    }
+}
+#endif // OTA_DEC_SUP
+
+#if (OTA_LZ_SUP)
+static void ota_lz_init(void)
+{
+    memset(&ota_env.lz, 0x00, sizeof(ota_env.lz));
+
+    ota_env.lz.state  = LZ_STA_TAG;
+    ota_env.lz.bit_ct = 1;
+}
+
+static void ota_lz_output(uint8_t byte)
+{
+    ota_env.lz.window[ota_env.lz.head++ & OTA_LZ_WINDOW_MASK] = byte;
+
+    ota_dec_output(byte);
+}
+
+/// Decode compressed stream, return false if image overflow bin_size
+static bool ota_lz_decode(const uint8_t *data, uint16_t len)
+{
+    struct ota_lz_tag *lz = &ota_env.lz;
+
+    for (uint16_t i = 0; i < len; ++i)
+    {
+        for (uint8_t mask = 0x80; mask; mask >>= 1)
+        {
+            lz->bits = (lz->bits << 1) | ((data[i] & mask) ? 1 : 0);
+
+            if (--lz->bit_ct)
+            {
+                continue;
+            }
+
+            switch (lz->state)
+            {
+                case LZ_STA_TAG:
+                {
+                    // 1 - literal byte, 0 - backref(index, count)
+                    lz->state  = (lz->bits) ? LZ_STA_LITERAL : LZ_STA_INDEX;
+                    lz->bit_ct = (lz->bits) ? 8 : OTA_LZ_WINDOW_SZ2;
+                } break;
+
+                case LZ_STA_LITERAL:
+                {
+                    if (ota_env.bin_len >= ota_env.bin_size)
+                    {
+                        return false;
+                    }
+
+                    ota_lz_output(lz->bits);
+                    lz->state  = LZ_STA_TAG;
+                    lz->bit_ct = 1;
+                } break;
+
+                case LZ_STA_INDEX:
+                {
+                    lz->index  = lz->bits + 1;
+                    lz->state  = LZ_STA_COUNT;
+                    lz->bit_ct = OTA_LZ_LOOKAHEAD_SZ2;
+                } break;
+
+                default: // LZ_STA_COUNT
+                {
+                    uint16_t count = lz->bits + 1;
+
+                    if (ota_env.bin_len + count > ota_env.bin_size)
+                    {
+                        return false;
+                    }
+
+                    while (count--)
+                    {
+                        ota_lz_output(lz->window[(lz->head - lz->index) & OTA_LZ_WINDOW_MASK]);
+                    }
+                    lz->state  = LZ_STA_TAG;
+                    lz->bit_ct = 1;
+                } break;
+            }
+
+            lz->bits = 0;
+        }
+    }
+
+    return true;
+}
+#endif // OTA_LZ_SUP
+
+#if (OTA_DIFF_SUP)
+static void ota_diff_init(void)
+{
+    memset(&ota_env.diff, 0x00, sizeof(ota_env.diff));
+
+    // 新镜像写入ota_env.bank, 另一个bank即当前运行镜像
+    ota_env.diff.src_base = (ota_env.bank == OTA_BANK_A) ? OTA_BANK_B_BASE : OTA_BANK_A_BASE;
+}
+
+/// Apply patch stream, return false if record invalid or image overflow bin_size
+static bool ota_diff_apply(const uint8_t *data, uint16_t len)
+{
+    struct ota_diff_tag *diff = &ota_env.diff;
+
+    while (len)
+    {
+        if (diff->remain)
+        {
+            uint16_t count = (diff->remain < len) ? diff->remain : len;
+
+            if (count > ota_env.bin_size - ota_env.bin_len)
+            {
+                return false;
+            }
+
+            diff->remain -= count;
+            len          -= count;
+
+            while (count--)
+            {
+                ota_dec_output(*data++);
+            }
+            continue;
+        }
+
+        diff->hdr[diff->hdr_len++] = *data++;
+        len--;
+
+        switch (diff->hdr[0])
+        {
+            case OTA_DIFF_COPY:
+            {
+                if (diff->hdr_len < 7)
+                {
+                    continue;
+                }
+
+                uint32_t src   = read32p(diff->hdr + 1);
+                uint16_t count = read16p(diff->hdr + 5);
+
+                // peer supplied src/count, compare by remaining space to avoid wrap
+                if ((src > OTA_DIFF_SRC_MAX) || (count > OTA_DIFF_SRC_MAX - src) ||
+                    (count > ota_env.bin_size - ota_env.bin_len))
+                {
+                    return false;
+                }
+
+                // 运行bank可直接通过XIP读取
+                const uint8_t *old = (const uint8_t *)(diff->src_base + src);
+
+                while (count--)
+                {
+                    ota_dec_output(*old++);
+                }
+            } break;
+
+            case OTA_DIFF_DATA:
+            {
+                if (diff->hdr_len < 3)
+                {
+                    continue;
+                }
+
+                diff->remain = read16p(diff->hdr + 1);
+            } break;
+
+            default:
+            {
+                return false;
+            }
+        }
+
+        diff->hdr_len = 0;
+    }
+
+    return true;
+}
+#endif // OTA_DIFF_SUP
+
+#if (OTA_DEC_SUP)
+/// Feed compressed or patch stream, return false on error
+static bool ota_dec_input(const uint8_t *data, uint16_t len)
+{
+#if (OTA_LZ_SUP)
+    if (OTA_FLAG_GET(FLAG_OTA_LZ))
+    {
+        return ota_lz_decode(data, len);
+    }
+#endif
+#if (OTA_DIFF_SUP)
+    if (OTA_FLAG_GET(FLAG_OTA_DIFF))
+    {
+        return ota_diff_apply(data, len);
+    }
+#endif
+    return false;
+}
+#endif // OTA_DEC_SUP
+
+#if (OTA_WIN_SUP)
+/// Init window receiver, return window size in packets(0 means plen invalid)
+static uint8_t ota_win_init(uint16_t plen)
+{
+    uint16_t nb;
+
+    if ((plen == 0) || (plen > OTA_PKT_LEN - OTA_DATA_POS))
+    {
+        return 0;
+    }
+
+    memset(&ota_env.win, 0x00, sizeof(ota_env.win));
+
+    // 保留一页给未写入flash的数据, 默认缓存可容纳OTA_WIN_MAX个最大包
+    nb = (OTA_WIN_BUFF_LEN - FLASH_PAGE_SIZE) / plen;
+
+    ota_env.win.plen = plen;
+    ota_env.win.nb   = (nb > OTA_WIN_MAX) ? OTA_WIN_MAX : nb;
+
+    return ota_env.win.nb;
+}
+
+/// Send SACK: AB 00 15 Base(2) Bitmap(4)
+static void ota_win_sack(uint8_t conidx)
+{
+    uint8_t sack[9];
+
+    sack[0] = OTA_RSP_HEAD;
+    sack[1] = OTA_OK;
+    sack[2] = OTA_CMD_DATA_WIN;
+    write16p(sack + 3, ota_env.win.base);
+    write32p(sack + 5, ota_env.win.bitmap);
+
+    ota_env.win.ack_base = ota_env.win.base;
+    ota_ntf_send(conidx, sizeof(sack), sack);
+}
+
+/// Write continuous data in ring to flash, last page padding with 0xFF
+static void ota_win_write(uint32_t contig)
+{
+    struct ota_win_tag *win = &ota_env.win;
+
+    while (win->wr_pos < contig)
+    {
+        uint8_t *page = ota_win_buff + (win->wr_pos % OTA_WIN_BUFF_LEN);
+        uint32_t left = contig - win->wr_pos;
+
+        if (left < FLASH_PAGE_SIZE)
+        {
+            if (contig < ota_env.bin_size)
+            {
+                break;
+            }
+
+            // CRC按镜像顺序计算, 乱序到达的包在此处才连续
+            ota_env.data_crc = crc32_update(ota_env.data_crc, page, left);
+            memset(page + left, 0xFF, FLASH_PAGE_SIZE - left);
+        }
+        else
+        {
+            ota_env.data_crc = crc32_update(ota_env.data_crc, page, FLASH_PAGE_SIZE);
+        }
+
+        ota_page_write(ota_env.bank + win->wr_pos, page);
+        win->wr_pos += FLASH_PAGE_SIZE;
+    }
+}
+
+/// Receive packet of OTA_CMD_DATA_WIN, return false if packet invalid
+static bool ota_win_recv(uint8_t conidx, uint16_t seq, uint16_t dlen, const uint8_t *data)
+{
+    struct ota_win_tag *win = &ota_env.win;
+    uint32_t offset = (uint32_t)seq * win->plen;
+    uint16_t diff   = seq - win->base;
+
+    // 仅最后一包允许短包
+    if ((offset + dlen > ota_env.bin_size) ||
+        ((dlen != win->plen) && (offset + dlen != ota_env.bin_size)))
+    {
+        return false;
+    }
+
+    if ((diff >= win->nb) || (win->bitmap & (1UL << diff)))
+    {
+        // 重复或超出窗口, 回复SACK让对端同步
+        win->retx++;
+        ota_win_sack(conidx);
+        return true;
+    }
+
+    if ((win->base == 0) && (win->bitmap == 0))
+    {
+        win->time = ble_time_get();
+    }
+
+    uint16_t pos   = offset % OTA_WIN_BUFF_LEN;
+    uint16_t first = (OTA_WIN_BUFF_LEN - pos < dlen) ? (OTA_WIN_BUFF_LEN - pos) : dlen;
+
+    memcpy(ota_win_buff + pos, data, first);
+    memcpy(ota_win_buff, data + first, dlen - first);
+
+    // 滑动窗口到第一个缺失包
+    win->bitmap |= (1UL << diff);
+
+    while (win->bitmap & 0x01)
+    {
+        win->bitmap >>= 1;
+        win->base++;
+    }
+
+    uint32_t contig = (uint32_t)win->base * win->plen;
+
+    if (contig > ota_env.bin_size)
+    {
+        contig = ota_env.bin_size;
+    }
+
+    ota_env.bin_len = contig;
+    ota_win_write(contig);
+
+    if (win->bitmap)
+    {
+        // 出现空洞立即请求重传, 窗口用尽时再次请求
+        if ((!win->gap) || (win->bitmap & (1UL << (win->nb - 1))))
+        {
+            win->gap = 1;
+            ota_win_sack(conidx);
+        }
+    }
+    else
+    {
+        win->gap = 0;
+
+        if (((uint16_t)(win->base - win->ack_base) >= (win->nb + 1) / 2) ||
+            (contig == ota_env.bin_size))
+        {
+            ota_win_sack(conidx);
+        }
+    }
+
+    return true;
 }
+#endif // OTA_WIN_SUP
 
 __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
 {
@@ -554,7 +1133,7 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
     uint16_t data_len;
     bool     ntf_send = true;
 
-    uint8_t rsp_data[16];
+    uint8_t rsp_data[20];
 
     rsp_data[0] = OTA_RSP_HEAD;
     rsp_data[1] = OTA_OK;
@@ -563,12 +1142,22 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
 
     OTA_FLAG_SET(FLAG_OTA_PROC);
 
+#if (OTA_WIN_SUP)
+    // 窗口传输中拒绝WC/WR, 避免破坏窗口状态及bin_len, 直到新的OTA_CMD_START
+    if (OTA_FLAG_GET(FLAG_OTA_WIN) && ((ota_cmd == OTA_CMD_DATA_WC) || (ota_cmd == OTA_CMD_DATA_WR)))
+    {
+        rsp_data[1] = OTA_BUSY;
+        ota_ntf_send(conidx, 3, rsp_data);
+        return;
+    }
+#endif
+
     switch (ota_cmd)
     {
         case OTA_CMD_VER:
         {
             ota_env.bin_len  = 0;
-            ota_env.data_sum = 0;
+            ota_env.data_crc = 0;
             ota_env.pkt_idx  = 0;
             ota_env.data_pos = 0;
 
@@ -610,7 +1199,11 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
         {
             uint32_t size         = flash_size();
             uint32_t bin_size     = read32p(data + 2);
-            DEBUG("bin_size:%"PRIX32", flash_size:%"PRIX32, bin_size, size);
+            uint8_t  bin_mode     = (len > 10) ? data[10] : OTA_MODE_RAW;
+#if (OTA_WIN_SUP)
+            uint16_t win_plen     = (len > 12) ? read16p(data + 11) : 0;
+#endif
+            DEBUG("bin_size:%"PRIX32", flash_size:%"PRIX32", mode:%d", bin_size, size, bin_mode);
             len = 3;
 
             // 判断bin_size合法性.
@@ -621,12 +1214,53 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
                 break;
             }
 
-#if (CFG_USE_LOAD)
-            // 0x20000 - 0x30000
-            flash_b64k_erase(OTA_BANK_B_BASE - FLASH_BASE);
-            // 0x30000 - 0x40000
-            flash_b64k_erase(OTA_BANK_B_BASE - FLASH_BASE + FLASH_B64K_SIZE);
-#else
+            // 压缩/差分模式下bin_size为重建后镜像长度
+            OTA_FLAG_CLR(FLAG_OTA_LZ | FLAG_OTA_DIFF | FLAG_OTA_WIN);
+            ota_env.bin_size = bin_size;
+
+#if (OTA_WIN_SUP)
+            if (bin_mode == OTA_MODE_WIN)
+            {
+                uint8_t win_nb = ota_win_init(win_plen);
+
+                if (win_nb == 0)
+                {
+                    rsp_data[1] = OTA_ERR;
+                    OTA_FLAG_SET(FLAG_OTA_END);
+                    break;
+                }
+
+                // 回复窗口大小(包数)
+                rsp_data[3] = win_nb;
+                len = 4;
+                OTA_FLAG_SET(FLAG_OTA_WIN);
+            }
+            else
+#endif
+#if (OTA_LZ_SUP)
+            if (bin_mode == OTA_MODE_LZ)
+            {
+                ota_lz_init();
+                OTA_FLAG_SET(FLAG_OTA_LZ);
+            }
+            else
+#endif
+#if (OTA_DIFF_SUP)
+            if (bin_mode == OTA_MODE_DIFF)
+            {
+                ota_diff_init();
+                OTA_FLAG_SET(FLAG_OTA_DIFF);
+            }
+            else
+#endif
+            if (bin_mode != OTA_MODE_RAW)
+            {
+                rsp_data[1] = OTA_ERR;
+                OTA_FLAG_SET(FLAG_OTA_END);
+                break;
+            }
+
+#if (!CFG_USE_LOAD)
             uint32_t curr_rst_hdl = RD_32(FLASH_INFO_CODE_ADDR) & 0xFFFFFF00UL;
             uint32_t peer_rst_hdl = read32p(data + 6) & 0xFFFFFF00UL;
             DEBUG("curr_hdl:%X, peer_hdl:%X", curr_rst_hdl, peer_rst_hdl);
@@ -638,15 +1272,10 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
                 OTA_FLAG_SET(FLAG_OTA_END);
                 break;
             }
-            // Erase
-            uint32_t erase_offset = (ota_env.bank & 0xFFFFF000UL);
-            uint32_t erase_end    = erase_offset + ALIGN(bin_size, FLASH_SECTOR_SIZE);
-
-            for (; erase_offset < erase_end; erase_offset += FLASH_SECTOR_SIZE)
-            {
-                ota_flash_op.block_er(erase_offset);
-            }
 #endif
+
+            // 写入时才擦除(@see ota_page_write), 避免开始命令长时间阻塞链路
+            ota_env.er_pos = (ota_env.bank & ~(FLASH_SECTOR_SIZE - 1));
         }
         break;
 
@@ -655,33 +1284,45 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
             peer_pkt_idx = read16p(data + 2);
             data_len     = read16p(data + 4);
             DEBUG("id:%d, %d", peer_pkt_idx, data_len);
+            ntf_send     = false;
+
+#if (OTA_DEC_SUP)
+            if (OTA_FLAG_GET(FLAG_OTA_LZ | FLAG_OTA_DIFF))
+            {
+                // data_len from peer, must be within packet received
+                if ((len < OTA_DATA_POS + data_len) || (!ota_dec_input(data + OTA_DATA_POS, data_len)))
+                {
+                    len         = 3;
+                    rsp_data[1] = OTA_ERR;
+                    ntf_send    = true;
+                    OTA_FLAG_SET(FLAG_OTA_END);
+                    break;
+                }
+
+                ota_env.pkt_idx++;
+                break;
+            }
+#endif
 
             memcpy(ota_env.recv_data + ota_env.data_pos, data + OTA_DATA_POS, data_len);
 
             ota_env.bin_len  += data_len;
             ota_env.data_pos += data_len;
             ota_env.pkt_idx++;
-
-            for (uint16_t i = 0; i < data_len; ++i)
-            {
-                ota_env.data_sum += data[OTA_DATA_POS + i];
-            }
-
-            ntf_send = false;
+            ota_env.data_crc = crc32_update(ota_env.data_crc, data + OTA_DATA_POS, data_len);
         }
         break;
 
         case OTA_CMD_DATA_WR:
         {
-            len          = 3;
             peer_pkt_idx = read16p(data + 2);
             data_len     = read16p(data + 4);
             DEBUG("id:%d, %d", peer_pkt_idx, data_len);
-
-            memcpy(ota_env.recv_data + ota_env.data_pos, data + OTA_DATA_POS, data_len);
-            ota_env.data_pos += data_len;
-            DEBUG("local_len:%"PRIu32", pos:%"PRIu16", dlen:%"PRIu16", blen:%"PRIu32, ota_env.bin_len, ota_env.data_pos,
-                data_len, OTA_BUFF_LEN);
+#if (OTA_DEC_SUP)
+            // data_len from peer, must be within packet received
+            bool pkt_ok  = (len >= OTA_DATA_POS + data_len);
+#endif
+            len          = 3;
 
             if (peer_pkt_idx != ota_env.pkt_idx)
             {
@@ -692,49 +1333,95 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
                 break;
             }
 
-            // write flash
-            uint32_t wr_offset = (ota_env.bin_len / OTA_BUFF_LEN) * OTA_BUFF_LEN + ota_env.bank;
-
-#if (OTA_BUFF_LEN > FLASH_PAGE_SIZE)
-
-            uint8_t page_num =
-                (ota_env.data_pos / FLASH_PAGE_SIZE) + (!!(ota_env.data_pos % FLASH_PAGE_SIZE));
-
-            for (uint8_t i = 0; i < page_num; ++i)
+#if (OTA_DEC_SUP)
+            if (OTA_FLAG_GET(FLAG_OTA_LZ | FLAG_OTA_DIFF))
             {
-                ota_flash_op.word_wr(wr_offset,
-                    (uint32_t *)(ota_env.recv_data + i * FLASH_PAGE_SIZE), FLASH_PAGE_SIZE_WLEN);
-                wr_offset += FLASH_PAGE_SIZE;
+                // 解码满OTA_BUFF_LEN即写flash, 剩余部分在OTA_CMD_END写入
+                if ((!pkt_ok) || (!ota_dec_input(data + OTA_DATA_POS, data_len)))
+                {
+                    rsp_data[1] = OTA_ERR;
+                    OTA_FLAG_SET(FLAG_OTA_END);
+                    break;
+                }
+
+                ota_env.pkt_idx++;
+                break;
             }
-#else
-            ota_flash_op.word_wr(wr_offset, (uint32_t *)ota_env.recv_data, FLASH_PAGE_SIZE_WLEN);
 #endif
 
+            memcpy(ota_env.recv_data + ota_env.data_pos, data + OTA_DATA_POS, data_len);
+            ota_env.data_pos += data_len;
+            DEBUG("local_len:%"PRIu32", pos:%"PRIu16", dlen:%"PRIu16", blen:%"PRIu32, ota_env.bin_len, ota_env.data_pos,
+                data_len, OTA_BUFF_LEN);
+
+            // write flash
+            uint32_t wr_offset = (ota_env.bin_len / OTA_BUFF_LEN) * OTA_BUFF_LEN + ota_env.bank;
+
+            ota_buff_write(wr_offset, ota_env.data_pos);
+
             ota_env.bin_len  += data_len;
             ota_env.data_pos  = 0;
             ota_env.pkt_idx++;
+            ota_env.data_crc = crc32_update(ota_env.data_crc, data + OTA_DATA_POS, data_len);
+        }
+        break;
 
-            for (uint16_t i = 0; i < data_len; ++i)
+#if (OTA_WIN_SUP)
+        case OTA_CMD_DATA_WIN:
+        {
+            peer_pkt_idx = read16p(data + 2);
+            data_len     = read16p(data + 4);
+            ntf_send     = false;
+            DEBUG("win id:%d, %d, base:%d", peer_pkt_idx, data_len, ota_env.win.base);
+
+            if ((!OTA_FLAG_GET(FLAG_OTA_WIN)) || (len < OTA_DATA_POS + data_len) ||
+                (!ota_win_recv(conidx, peer_pkt_idx, data_len, data + OTA_DATA_POS)))
             {
-                ota_env.data_sum += data[OTA_DATA_POS + i];
+                len         = 3;
+                rsp_data[1] = OTA_ERR;
+                ntf_send    = true;
+                OTA_FLAG_SET(FLAG_OTA_END);
             }
         }
         break;
+#endif
 
         case OTA_CMD_END:
         {
             uint32_t peer_bin_len  = read32p(data + 2);
-            uint32_t peer_data_sum = read32p(data + 6);
+            uint32_t peer_data_crc = read32p(data + 6);
             DEBUG("bank:%"PRIX32", sum:%"PRIX32", peer_len:%"PRIu32", lsum:%"PRIX32", local_len:%"PRIu32, ota_env.bank,
-                peer_data_sum, peer_bin_len, ota_env.data_sum, ota_env.bin_len);
+                peer_data_crc, peer_bin_len, ota_env.data_crc, ota_env.bin_len);
+
+#if (OTA_DEC_SUP)
+            if (OTA_FLAG_GET(FLAG_OTA_LZ | FLAG_OTA_DIFF))
+            {
+                ota_dec_flush();
+            }
+#endif
 
             write32p(rsp_data + 3, ota_env.bin_len);
-            write32p(rsp_data + 7, ota_env.data_sum);
+            write32p(rsp_data + 7, ota_env.data_crc);
             len = 11;
 
+#if (OTA_WIN_SUP)
+            if (OTA_FLAG_GET(FLAG_OTA_WIN))
+            {
+                // 统计: 传输耗时(312.5us), 重传/重复包数, 对端结合连接间隔计算每间隔吞吐
+                uint32_t time = BLE_TIME_DIFF(ble_time_get(), ota_env.win.time);
+
+                write32p(rsp_data + 11, time);
+                write16p(rsp_data + 15, ota_env.win.retx);
+                len = 17;
+                DEBUG("win time:%"PRIu32", retx:%d", time, ota_env.win.retx);
+            }
+#endif
+
             OTA_FLAG_SET(FLAG_OTA_END);
 
-            if ((peer_bin_len != ota_env.bin_len) || (peer_data_sum != ota_env.data_sum))
+            // 回读bank校验, 防止写flash失败的镜像被引导
+            if ((peer_bin_len != ota_env.bin_len) || (peer_data_crc != ota_env.data_crc) ||
+                (ota_bank_crc() != ota_env.data_crc))
             {
                 ntf_send    = false;
                 rsp_data[1] = OTA_ERR;
@@ -749,6 +1436,7 @@ __WEAK void ota_recv(uint8_t conidx, uint16_t len, const uint8_t *data)
             write32p(ota_env.recv_data + 0, 0x55AA5AA5);
             write32p(ota_env.recv_data + 4, ota_env.bin_len);
             write32p(ota_env.recv_data + 8, OTA_BANK_B_BASE);
+            write32p(ota_env.recv_data + 12, ota_env.data_crc);
 
             ota_flash_op.word_wr(LOADER_INFO_BASE - FLASH_BASE, (uint32_t *)ota_env.recv_data,
                 FLASH_PAGE_SIZE_WLEN);
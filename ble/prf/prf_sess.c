@@ -18,6 +18,12 @@
 
 #include "prf.h"
 #include "prf_sess.h"
+#include "app_lstat.h"
+
+#if (SES_TXQ_SIZE)
+#include <stddef.h>
+#include "bledef.h"
+#endif
 
 #if (DBG_SESS)
 #include "dbg.h"
@@ -43,6 +49,22 @@
     #define SES_NB_PKT_MAX          (5)
 #endif
 
+#if (SES_TXQ_SIZE)
+/// Max length of segment, MTU-3 limited also
+#if !defined(SES_TXQ_SEG_MAX)
+    #if defined(BLE_MTU)
+    #define SES_TXQ_SEG_MAX         (BLE_MTU - 3)
+    #else
+    #define SES_TXQ_SEG_MAX         (124 - 3)
+    #endif
+#endif
+
+/// Gap of TX complete time(half-slot) to split connection events
+#if !defined(SES_TXQ_EVT_GAP)
+    #define SES_TXQ_EVT_GAP         (4)
+#endif
+#endif //(SES_TXQ_SIZE)
+
 /// Version String for SES_IDX_READ_VAL Read
 #define SES_VERS_STR                ("Ver:1.25")
 #define SES_VERS_STR_LEN            (sizeof(SES_VERS_STR) - 1)
@@ -78,6 +100,32 @@ typedef struct sess_env_tag
 /// Global Variable Declarations
 sess_env_t sess_env;
 
+#if (SES_TXQ_SIZE)
+/// TX Queue of each connection
+typedef struct sess_txq_tag
+{
+    uint16_t head;
+    uint16_t tail;
+    uint16_t len;
+    /// Packets completed in current event
+    uint8_t  evt_pkt;
+    /// Time of last completed, split events
+    uint32_t cmp_time;
+
+    struct sess_txq_stat stat;
+
+    uint8_t  data[SES_TXQ_SIZE];
+} sess_txq_t;
+
+static sess_txq_t sess_txq[BLE_CONNECTION_MAX];
+
+/// Segment across end of queue
+static uint8_t sess_txq_seg[SES_TXQ_SEG_MAX];
+
+/// Next link to serve, round-robin across connections
+static uint8_t sess_txq_rr;
+#endif //(SES_TXQ_SIZE)
+
 
 /**
  ****************************************************************************************
@@ -106,6 +154,12 @@ enum ses_att_idx
     SES_IDX_READ_VAL,
     #endif
 
+    #if (LINK_STAT && LINK_STAT_CHAR)
+    // Link Statistics Char.
+    SES_IDX_LSTAT_CHAR,
+    SES_IDX_LSTAT_VAL,
+    #endif
+
     // Max Index, *NOTE* Minus 1(Svc Decl) is .nb_att
     SES_IDX_NB,
 };
@@ -123,6 +177,10 @@ const uint8_t ses_char_txd_notify[] = SES_ATT_UUID128(0xFF01);
 const uint8_t ses_char_rxd_write[]  = SES_ATT_UUID128(0xFF02);
 /// Serial Read Command UUID128
 const uint8_t ses_char_val_read[]   = SES_ATT_UUID128(0xFF03);
+#if (LINK_STAT && LINK_STAT_CHAR)
+/// Link Statistics UUID128
+const uint8_t ses_char_lstat_read[] = SES_ATT_UUID128(0xFF04);
+#endif
 
 /// Attributes Description
 const att_decl_t ses_atts[] =
@@ -141,6 +199,12 @@ const att_decl_t ses_atts[] =
     ATT_ELMT_DECL_CHAR( SES_IDX_READ_CHAR ),
     ATT_ELMT128( SES_IDX_READ_VAL, ses_char_val_read,   PROP_RD,             0 ),
     #endif //(SES_READ_SUP)
+
+    #if (LINK_STAT && LINK_STAT_CHAR)
+    // Link Statistics Char. Declaration and Value
+    ATT_ELMT_DECL_CHAR( SES_IDX_LSTAT_CHAR ),
+    ATT_ELMT128( SES_IDX_LSTAT_VAL, ses_char_lstat_read, PROP_RD,            0 ),
+    #endif //(LINK_STAT_CHAR)
 };
 
 /// Service Description
@@ -162,6 +226,8 @@ const struct svc_decl ses_svc_db =
 #define SES_CHAR_RXD_WRITE          ATT_UUID16(0xFF02)
 /// Serial Read Command UUID
 #define SES_CHAR_VAL_READ           ATT_UUID16(0xFF03)
+/// Link Statistics UUID
+#define SES_CHAR_LSTAT_READ         ATT_UUID16(0xFF04)
 
 /// Attributes Description
 const att_decl_t ses_atts[] =
@@ -180,6 +246,12 @@ const att_decl_t ses_atts[] =
     ATT_ELMT_DECL_CHAR( SES_IDX_READ_CHAR ),
     ATT_ELMT( SES_IDX_READ_VAL, SES_CHAR_VAL_READ,   PROP_RD,             0 ),
     #endif //(SES_READ_SUP)
+
+    #if (LINK_STAT && LINK_STAT_CHAR)
+    // Link Statistics Char. Declaration and Value
+    ATT_ELMT_DECL_CHAR( SES_IDX_LSTAT_CHAR ),
+    ATT_ELMT( SES_IDX_LSTAT_VAL, SES_CHAR_LSTAT_READ, PROP_RD,            0 ),
+    #endif //(LINK_STAT_CHAR)
 };
 
 /// Service Description
@@ -220,6 +292,110 @@ static uint8_t sess_get_att_idx(uint16_t handle)
     return handle - sess_env.start_hdl;
 }
 
+#if (SES_TXQ_SIZE)
+/// Empty queue of conidx, new link or client config changed
+static void sess_txq_reset(uint8_t conidx)
+{
+    memset(&sess_txq[conidx], 0, offsetof(sess_txq_t, data));
+}
+
+/// Send one segment of queued data, return true if more remain
+static bool sess_txq_send(uint8_t conidx)
+{
+    sess_txq_t *txq = &sess_txq[conidx];
+    uint16_t seg_max;
+
+    if (txq->len == 0)
+    {
+        return false;
+    }
+
+    if ((gapc_get_conhdl(conidx) == GAP_INVALID_CONHDL) || (SES_NTF_CFG_GET(conidx) == PRF_CLI_STOP_NTFIND))
+    {
+        // peer gone or not listen, drop data
+        txq->head = txq->tail = txq->len = 0;
+        return false;
+    }
+
+    seg_max = gatt_get_mtu(conidx) - 3;
+    if (seg_max > SES_TXQ_SEG_MAX)
+    {
+        seg_max = SES_TXQ_SEG_MAX;
+    }
+
+    uint16_t seg = (txq->len < seg_max) ? txq->len : seg_max;
+    uint16_t run = SES_TXQ_SIZE - txq->tail;
+    const uint8_t *p_seg = &txq->data[txq->tail];
+
+    if (run < seg)
+    {
+        // wrap around, copy into one segment
+        memcpy(sess_txq_seg, p_seg, run);
+        memcpy(sess_txq_seg + run, txq->data, seg - run);
+        p_seg = sess_txq_seg;
+    }
+
+    gatt_ntf_send(conidx, sess_get_att_handle(SES_IDX_TXD_VAL), seg, p_seg);
+    sess_env.nb_pkt--; // allocate
+    #if (LINK_STAT)
+    lstat_ntf_queued(conidx);
+    #endif
+
+    txq->tail = (txq->tail + seg) % SES_TXQ_SIZE;
+    txq->len -= seg;
+    txq->stat.tx_bytes += seg;
+    txq->stat.tx_pkts++;
+    DEBUG("txq_send(cid:%d,len:%d,remain:%d,nb:%d)", conidx, seg, txq->len, sess_env.nb_pkt);
+
+    return (txq->len > 0);
+}
+
+/// Send queued data as many as controller buffers free, one segment per link in turn
+static void sess_txq_flush(void)
+{
+    bool more = true;
+
+    while ((sess_env.nb_pkt > 0) && more)
+    {
+        more = false;
+
+        for (uint8_t i = 0; (i < BLE_CONNECTION_MAX) && (sess_env.nb_pkt > 0); i++)
+        {
+            uint8_t conidx = sess_txq_rr;
+
+            sess_txq_rr = (sess_txq_rr + 1) % BLE_CONNECTION_MAX;
+
+            if (sess_txq_send(conidx))
+            {
+                more = true;
+            }
+        }
+    }
+}
+
+/// Account packet completed, then refill from all queues
+static void sess_txq_cmp(uint8_t conidx)
+{
+    sess_txq_t *txq = &sess_txq[conidx];
+    uint32_t now = ble_time_get();
+
+    // completed together in one connection event
+    if (BLE_TIME_DIFF(now, txq->cmp_time) > SES_TXQ_EVT_GAP)
+    {
+        txq->stat.evt_cnt++;
+        txq->evt_pkt = 0;
+    }
+    txq->cmp_time = now;
+
+    if (++txq->evt_pkt > txq->stat.evt_pkt_max)
+    {
+        txq->stat.evt_pkt_max = txq->evt_pkt;
+    }
+
+    sess_txq_flush();
+}
+#endif //(SES_TXQ_SIZE)
+
 /// Handles reception of the atts request from peer device
 static void sess_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const void *param)
 {
@@ -250,6 +426,17 @@ static void sess_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const
             }
             #endif //(SES_READ_SUP)
 
+            #if (LINK_STAT && LINK_STAT_CHAR)
+            if (att_idx == SES_IDX_LSTAT_VAL)
+            {
+                // block of this link, refreshed on read
+                const struct lstat_blk *blk = lstat_get(conidx);
+
+                gatt_read_cfm(conidx, LE_SUCCESS, handle, sizeof(struct lstat_blk), (uint8_t *)blk);
+                break;
+            }
+            #endif //(LINK_STAT_CHAR)
+
             // Send error response
             gatt_read_cfm(conidx, PRF_ERR_APP_ERROR, handle, 0, NULL);
         } break;
@@ -282,6 +469,9 @@ static void sess_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const
                         DEBUG("  set txd_ntf(cid:%d,cfg:%d)", conidx, cli_cfg);
 
                         SES_NTF_CFG_SET(conidx, cli_cfg);
+                        #if (SES_TXQ_SIZE)
+                        sess_txq_reset(conidx);
+                        #endif
                         // Send write conform quickly!
                         gatt_write_cfm(conidx, LE_SUCCESS, handle);
 
@@ -332,7 +522,24 @@ static void sess_svc_func(uint8_t conidx, uint8_t opcode, uint16_t handle, const
             if (evt->operation == GATT_NOTIFY)
             {
                 // Notify result
+                #if (LINK_STAT)
+                lstat_ntf_cmp(conidx, evt->status);
+                #endif
+
+                #if (SES_TXQ_SIZE)
+                sess_txq_cmp(conidx);
+                #endif
+            }
+            #if (LINK_STAT)
+            else if (evt->operation == GATT_INDICATE)
+            {
+                lstat_ntf_cmp(conidx, evt->status);
             }
+            #endif
+
+            #if (SES_TXD_CMP)
+            sess_cb_cmp(conidx, evt->status);
+            #endif
         } break;
 
         default:
@@ -389,6 +596,10 @@ void sess_set_ccc(uint8_t conidx, uint8_t cli_cfg)
     {
         // update configuration
         SES_NTF_CFG_SET(conidx, cli_cfg);
+
+        #if (SES_TXQ_SIZE)
+        sess_txq_reset(conidx);
+        #endif
     }
 }
 
@@ -425,9 +636,82 @@ uint8_t sess_txd_send(uint8_t conidx, uint16_t len, const uint8_t* data)
         }
     }
 
+    #if (LINK_STAT)
+    if (status == LE_SUCCESS)
+        lstat_ntf_queued(conidx);
+    else if (len > 0)
+        lstat_ntf_busy(conidx);
+    #endif
+
     return status;
 }
 
+#if (SES_TXQ_SIZE)
+/**
+ ****************************************************************************************
+ * @brief Queue data to peer device, sent via NTF when controller buffer free
+ *
+ * @param[in] conidx   peer device connection index
+ * @param[in] len      Length of data
+ * @param[in] data     pointer of buffer
+ *
+ * @return Status of the operation @see prf_err, all or none of data queued
+ ****************************************************************************************
+ */
+uint8_t sess_txq_push(uint8_t conidx, uint16_t len, const uint8_t *data)
+{
+    sess_txq_t *txq = &sess_txq[conidx];
+
+    if (SES_NTF_CFG_GET(conidx) == PRF_CLI_STOP_NTFIND)
+    {
+        return PRF_ERR_NTF_DISABLED;
+    }
+
+    if ((len == 0) || (len > SES_TXQ_SIZE - txq->len))
+    {
+        return PRF_ERR_REQ_DISALLOWED;
+    }
+
+    for (uint16_t i = 0; i < len; )
+    {
+        uint16_t run = SES_TXQ_SIZE - txq->head;
+
+        if (run > len - i)
+        {
+            run = len - i;
+        }
+
+        memcpy(&txq->data[txq->head], data + i, run);
+        txq->head = (txq->head + run) % SES_TXQ_SIZE;
+        i += run;
+    }
+
+    txq->len += len;
+    if (txq->len > txq->stat.peak_len)
+    {
+        txq->stat.peak_len = txq->len;
+    }
+
+    sess_txq_flush();
+    return LE_SUCCESS;
+}
+
+uint16_t sess_txq_len(uint8_t conidx)
+{
+    return sess_txq[conidx].len;
+}
+
+uint16_t sess_txq_avail(uint8_t conidx)
+{
+    return SES_TXQ_SIZE - sess_txq[conidx].len;
+}
+
+const struct sess_txq_stat *sess_txq_stat(uint8_t conidx)
+{
+    return &sess_txq[conidx].stat;
+}
+#endif //(SES_TXQ_SIZE)
+
 /**
  ****************************************************************************************
  * @brief Callback on received data from peer device via WC or WQ (__WEAK func)
@@ -472,6 +756,22 @@ __WEAK void sess_cb_rdv(uint8_t conidx, uint8_t attidx, uint16_t handle)
 }
 #endif //(SES_READ_SUP)
 
+#if (SES_TXD_CMP)
+/**
+ ****************************************************************************************
+ * @brief Callback on NTF/IND completed, once per packet sent (__WEAK func)
+ *
+ * @param[in] conidx   peer device connection index
+ * @param[in] status   Status of the operation @see le_err
+ ****************************************************************************************
+ */
+__WEAK void sess_cb_cmp(uint8_t conidx, uint8_t status)
+{
+    // user override
+    (void)conidx;(void)status;
+}
+#endif //(SES_TXD_CMP)
+
 #if (SES_CLI_CFG)
 /**
  ****************************************************************************************
@@ -39,6 +39,32 @@
     #define SES_CLI_CFG             (0)
 #endif
 
+/// Callback of NTF/IND completed
+#if !defined(SES_TXD_CMP)
+    #define SES_TXD_CMP             (0)
+#endif
+
+/// TX Queue size of each connection(0 = disabled), sent via NTF segmented to MTU-3
+#if !defined(SES_TXQ_SIZE)
+    #define SES_TXQ_SIZE            (0)
+#endif
+
+#if (SES_TXQ_SIZE)
+/// Statistics of TX Queue
+struct sess_txq_stat
+{
+    /// Bytes and packets sent
+    uint32_t tx_bytes;
+    uint32_t tx_pkts;
+    /// Connection events which packets completed in, pkts/event = tx_pkts / evt_cnt
+    uint32_t evt_cnt;
+    /// Max packets completed in one event
+    uint8_t  evt_pkt_max;
+    /// Max bytes queued
+    uint16_t peak_len;
+};
+#endif
+
 
 /*
  * FUNCTION DECLARATIONS
@@ -78,6 +104,42 @@ void sess_set_ccc(uint8_t conidx, uint8_t cli_cfg);
  */
 uint8_t sess_txd_send(uint8_t conidx, uint16_t len, const uint8_t *data);
 
+#if (SES_TXQ_SIZE)
+/**
+ ****************************************************************************************
+ * @brief Queue data to peer device, sent via NTF when controller buffer free
+ *
+ * @param[in] conidx   peer device connection index
+ * @param[in] len      Length of data
+ * @param[in] data     pointer of buffer
+ *
+ * @return Status of the operation @see prf_err, all or none of data queued
+ ****************************************************************************************
+ */
+uint8_t sess_txq_push(uint8_t conidx, uint16_t len, const uint8_t *data);
+
+/// Bytes waiting in TX Queue
+uint16_t sess_txq_len(uint8_t conidx);
+
+/// Bytes free in TX Queue
+uint16_t sess_txq_avail(uint8_t conidx);
+
+/// Statistics of TX Queue, reset when client config written
+const struct sess_txq_stat *sess_txq_stat(uint8_t conidx);
+#endif //(SES_TXQ_SIZE)
+
+#if (SES_TXD_CMP)
+/**
+ ****************************************************************************************
+ * @brief Callback on NTF/IND completed, once per packet sent (__WEAK func)
+ *
+ * @param[in] conidx   peer device connection index
+ * @param[in] status   Status of the operation @see le_err
+ ****************************************************************************************
+ */
+void sess_cb_cmp(uint8_t conidx, uint8_t status);
+#endif //(SES_TXD_CMP)
+
 /**
  ****************************************************************************************
  * @brief Callback on received data from peer device via WC or WQ (__WEAK func)
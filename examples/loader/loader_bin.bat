@@ -20,8 +20,9 @@ for %%i in (%AppFile%) do (
 )
 
 set /a bin_sz=%app_bin_size%+%MAG_OFFSET% 
-::不足256字节的补全00
-set /a last_sz=256-%bin_sz%
+::补全00到256字节整数倍(loader可超过一页)
+set /a last_sz=(256-%bin_sz%%%256)%%256
+if %last_sz%==0 set /a last_sz=256
 
 if not exist %zeroFile% (
 	fsutil file createNew %zeroFile% %last_sz%
@@ -9,9 +9,8 @@ SET LDR_TYPE_COPY=0x55AA5AA5
 SET InfoFile=.\info.bin
 SET SREC_CAT=..\..\tools\srec_cat.exe
 
-if not exist %InfoFile% (
-	fsutil file createNew %InfoFile% 256
-)
+::info页填充0xFF: 0x10后为搬运进度标记(0x00=该扇区已搬运), 须为擦除态
+%SREC_CAT% -generate 0x00 0x100 -constant 0xFF -o %InfoFile% -binary
 
 for %%i in (%AppFile%) do (
 	SET app_bin_size=%%~zi
@@ -21,6 +20,10 @@ for %%i in (%AppFile%) do (
 %SREC_CAT% -generate 0x00 0x04 -constant-l-e %LDR_TYPE_COPY% 4 %InfoFile% -binary -exclude 0x00 0x04 -o %InfoFile% -binary 
 %SREC_CAT% -generate 0x04 0x08 -constant-l-e %app_bin_size%  4 %InfoFile% -binary -exclude 0x04 0x08 -o %InfoFile% -binary 
 %SREC_CAT% -generate 0x08 0x0C -constant-l-e %OTA_ADDR%      4 %InfoFile% -binary -exclude 0x08 0x0C -o %InfoFile% -binary 
+::CRC-32(同zlib crc32) of AppFile at 0x0C, loader校验后才搬运
+set /a crc_end=%app_bin_size%+4
+set /a crc_ofs=%app_bin_size%-12
+%SREC_CAT% %InfoFile% -binary -exclude 0x0C 0x10 %AppFile% -binary -crc32-l-e %app_bin_size% -crop %app_bin_size% %crc_end% -offset -%crc_ofs% -o %InfoFile% -binary
 
 %SREC_CAT% %InfoFile% -binary %AppFile% -binary -offset 0x100 -o %OutFile% -binary
 
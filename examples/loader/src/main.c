@@ -29,9 +29,14 @@
  *
  * Boot flow:
  * 1. Read loader info from LDR_INFO_ADDR
- * 2. If ldrType == TYPE_COPY: copy OTA image to LDR_RUN_ADDR
- * 3. Erase loader info to prevent re-copy on next boot
- * 4. Jump to application at LDR_RUN_ADDR
+ * 2. If ldrType == TYPE_COPY: check CRC-32 of OTA image, copy it to LDR_RUN_ADDR
+ *    and check again (re-copy up to LDR_COPY_RETRY times, then reset), bad image is dropped.
+ *    Copy by 4KB sector: unchanged sector is skipped, whole changed 64KB block uses
+ *    block erase, last sector erased by page to keep run region data after image end,
+ *    finished sector is marked in info page to resume after power loss
+ * 3. Erase loader info to prevent re-copy on next boot, only if copy verified (or image
+ *    dropped), otherwise keep it and reset to copy again
+ * 4. Jump to application at LDR_RUN_ADDR if its vector table looks valid
  *
  ****************************************************************************************
  */
@@ -50,6 +55,21 @@
 #endif
 
 #define PAGE_SIZE_WLEN       (PAGE_SIZE >> 2)
+#define SECTOR_SIZE          0x1000
+#define BLOCK_SIZE           0x10000
+#define BLOCK_SECTORS        (BLOCK_SIZE / SECTOR_SIZE)
+
+/// Max copies of image until run region matches CRC-32
+#define LDR_COPY_RETRY       3
+
+/// Progress marker after ldr_info_t: byte[n] programmed to 0x00 once sector n copied,
+/// rest of info page must be 0xFF(erased) when staged @see ota_firmware.bat
+#define LDR_MARK_OFFSET      0x10
+#define LDR_MARK_DONE(mark, n) (*(volatile uint8_t *)((mark) + (n)) == 0x00)
+
+/// Top of stack of application: SRAM or BLE EM(RETN, 8KB) end
+#define APP_SP_MIN           (SRAM_BASE)
+#define APP_SP_MAX           (RETN_BASE + 0x2000)
 
 /// Loader type
 #define LDR_TYPE_NONE        0xFFFFFFFF
@@ -61,6 +81,7 @@ typedef struct
     uint32_t ldrType;   ///< Loader type: TYPE_COPY or TYPE_NONE
     uint32_t otaLen;    ///< OTA image length in bytes
     uint32_t otaAddr;   ///< OTA image source address (typically INFO_ADDR + 0x100)
+    uint32_t otaCrc;    ///< CRC-32 of OTA image (IEEE 802.3, same as zlib crc32)
 } ldr_info_t;
 
 
@@ -71,51 +92,191 @@ typedef struct
 
 /**
  ****************************************************************************************
- * @brief Validate application at given address
+ * @brief Validate application at given address via its vector table
  *
  * @param[in] run_addr  Application base address
  *
- * @return true if application appears valid
- *
- * @note Currently always returns true; add checks as needed.
+ * @return true if initial SP points into RAM and Reset_Handler is a thumb address in flash,
+ *         false if region erased(0xFFFFFFFF) or holds no image
  ****************************************************************************************
  */
 static bool app_is_ok(uint32_t run_addr)
 {
-    (void)run_addr;
+    uint32_t init_sp  = RD_32(run_addr + 0);
+    uint32_t rst_hdlr = RD_32(run_addr + 4);
+
+    if ((init_sp & 0x03) || (init_sp <= APP_SP_MIN) || (init_sp > APP_SP_MAX))
+    {
+        return false;
+    }
+
+    return ((rst_hdlr & 0x01) && (rst_hdlr > FLASH_BASE) && (rst_hdlr < CACHE_REG_BASE));
+}
+
+/// CRC-32 table by nibble (reflected 0xEDB88320), 64 bytes instead of 1KB
+static const uint32_t crc32_nib[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C,
+};
+
+/**
+ ****************************************************************************************
+ * @brief CRC-32 of image in flash (nibble table, keep loader small)
+ *
+ * @param[in] addr  Image address (XIP)
+ * @param[in] len   Image length in bytes
+ *
+ * @return CRC-32 value
+ ****************************************************************************************
+ */
+static uint32_t img_crc32(uint32_t addr, uint32_t len)
+{
+    const uint8_t *data = (const uint8_t *)addr;
+    uint32_t crc = 0xFFFFFFFF;
+
+    while (len--)
+    {
+        crc ^= *data++;
+        crc = (crc >> 4) ^ crc32_nib[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nib[crc & 0x0F];
+    }
+
+    return ~crc;
+}
+
+/**
+ ****************************************************************************************
+ * @brief Check whether destination already holds source data (compare via XIP)
+ *
+ * @param[in] dst  Destination address
+ * @param[in] src  Source address
+ * @param[in] len  Length in bytes, multiple of 4
+ ****************************************************************************************
+ */
+static bool sect_same(uint32_t dst, uint32_t src, uint32_t len)
+{
+    for (uint32_t i = 0; i < len; i += 4)
+    {
+        if (RD_32(dst + i) != RD_32(src + i))
+        {
+            return false;
+        }
+    }
 
     return true;
 }
 
 /**
  ****************************************************************************************
- * @brief Copy OTA image from info region to run region (page by page)
+ * @brief Program erased destination with source data (page by page)
  *
- * @param[in] run_addr  Destination address
- * @param[in] cpy_addr  Source address
- * @param[in] cpy_len   Number of bytes to copy
+ * @param[in] wr_offset  Destination flash offset
+ * @param[in] rd_offset  Source flash offset
+ * @param[in] len        Length in bytes, multiple of PAGE_SIZE
  ****************************************************************************************
  */
-static void ota_copy(uint32_t run_addr, uint32_t cpy_addr, uint32_t cpy_len)
+static void sect_write(uint32_t wr_offset, uint32_t rd_offset, uint32_t len)
 {
     uint32_t tmp_data[PAGE_SIZE_WLEN];
-    uint32_t wr_page  = (run_addr     & 0x00FFFF00) / PAGE_SIZE;
-    uint32_t rd_page  = (cpy_addr     & 0x00FFFF00) / PAGE_SIZE;
-    uint32_t nb_pages = (cpy_len + (PAGE_SIZE - 1)) / PAGE_SIZE;
 
-    while (nb_pages--)
+    for (uint32_t i = 0; i < len; i += PAGE_SIZE)
     {
-        // Read source page
-        uint32_t offset = rd_page * PAGE_SIZE;
-        fshc_read(offset, tmp_data, PAGE_SIZE_WLEN, FSH_CMD_RD);
+        fshc_read(rd_offset + i, tmp_data, PAGE_SIZE_WLEN, FSH_CMD_RD);
+        fshc_write(wr_offset + i, tmp_data, PAGE_SIZE_WLEN, FSH_CMD_WR);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Erase destination before write: whole sector, or only pages of image tail
+ *        to keep data placed after image end in the same sector
+ *
+ * @param[in] offset  Destination flash offset, aligned to SECTOR_SIZE
+ * @param[in] len     Length in bytes, SECTOR_SIZE or multiple of PAGE_SIZE
+ ****************************************************************************************
+ */
+static void sect_erase(uint32_t offset, uint32_t len)
+{
+    if (len == SECTOR_SIZE)
+    {
+        fshc_erase(offset, FSH_CMD_ER_SECTOR);
+        return;
+    }
+
+    for (uint32_t i = 0; i < len; i += PAGE_SIZE)
+    {
+        fshc_erase(offset + i, FSH_CMD_ER_PAGE);
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Copy OTA image from info region to run region (sector by sector)
+ *
+ * @param[in] run_addr   Destination address, aligned to SECTOR_SIZE
+ * @param[in] cpy_addr   Source address, aligned to PAGE_SIZE
+ * @param[in] cpy_len    Number of bytes to copy
+ * @param[in] mark_addr  Progress marker address, 0 to ignore marker (compare only)
+ ****************************************************************************************
+ */
+static void ota_copy(uint32_t run_addr, uint32_t cpy_addr, uint32_t cpy_len, uint32_t mark_addr)
+{
+    uint32_t nb_sect = (cpy_len + (SECTOR_SIZE - 1)) / SECTOR_SIZE;
+    uint32_t tail    = ((cpy_len - 1) % SECTOR_SIZE + PAGE_SIZE) & ~(PAGE_SIZE - 1);
+    uint32_t sect    = 0;
+
+    while (sect < nb_sect)
+    {
+        uint32_t dst = run_addr + sect * SECTOR_SIZE;
+        uint32_t src = cpy_addr + sect * SECTOR_SIZE;
+        uint32_t len = (sect == nb_sect - 1) ? tail : SECTOR_SIZE;
+        uint32_t nb  = 1;
 
-        // Erase destination page and write
-        offset = wr_page * PAGE_SIZE;
-        fshc_erase(offset, FSH_CMD_ER_PAGE);
-        fshc_write(offset, tmp_data, PAGE_SIZE_WLEN, FSH_CMD_WR);
+        // Copied before power loss
+        if (mark_addr && LDR_MARK_DONE(mark_addr, sect))
+        {
+            sect++;
+            continue;
+        }
 
-        wr_page++;
-        rd_page++;
+        // Whole 64KB block changed: one block erase instead of 16 sector erases,
+        // not when block ends with partial tail sector(data after image kept)
+        if (((dst % BLOCK_SIZE) == 0) && (sect + BLOCK_SECTORS <= nb_sect)
+            && ((sect + BLOCK_SECTORS < nb_sect) || (tail == SECTOR_SIZE)))
+        {
+            while ((nb < BLOCK_SECTORS) && !(mark_addr && LDR_MARK_DONE(mark_addr, sect + nb)) &&
+                   !sect_same(dst + nb * SECTOR_SIZE, src + nb * SECTOR_SIZE, SECTOR_SIZE))
+            {
+                nb++;
+            }
+
+            nb = ((nb == BLOCK_SECTORS) && !sect_same(dst, src, SECTOR_SIZE)) ? BLOCK_SECTORS : 1;
+        }
+
+        if (nb == BLOCK_SECTORS)
+        {
+            fshc_erase(dst & 0x00FFFFFF, FSH_CMD_ER_BLOCK64);
+            sect_write(dst & 0x00FFFFFF, src & 0x00FFFFFF, BLOCK_SIZE);
+        }
+        else if (!sect_same(dst, src, len))
+        {
+            sect_erase(dst & 0x00FFFFFF, len);
+            sect_write(dst & 0x00FFFFFF, src & 0x00FFFFFF, len);
+        }
+
+        // Mark done: program marker byte to 0x00, others in word keep 0xFF
+        while (nb--)
+        {
+            if (mark_addr)
+            {
+                uint32_t word = ~(0xFFUL << ((sect & 3) * 8));
+
+                fshc_write((mark_addr & 0x00FFFFFF) + (sect & ~3UL), &word, 1, FSH_CMD_WR);
+            }
+
+            sect++;
+        }
     }
 }
 
@@ -129,6 +290,7 @@ static void ota_copy(uint32_t run_addr, uint32_t cpy_addr, uint32_t cpy_len)
 int __main(void)
 {
     ldr_info_t ldr_info;
+    bool copy_ok = true;
 
     // LDR_XXX_ADDR fixed after __Vectors (Entry at 0x20003600, Size=0x10)
     // @see link_ld.sct and startup_ld.s
@@ -142,18 +304,42 @@ int __main(void)
     {
         ldr_info.otaLen  = RD_32(ldr_info_addr + 4);
         ldr_info.otaAddr = RD_32(ldr_info_addr + 8);
+        ldr_info.otaCrc  = RD_32(ldr_info_addr + 12);
 
         // Disable watchdog during flash copy
         iwdt_disable();
 
-        // Copy OTA image to run address
-        ota_copy(ldr_run_addr, ldr_info.otaAddr, ldr_info.otaLen);
+        // Copy OTA image to run address only if image is intact, and verify the copy
+        if (img_crc32(ldr_info.otaAddr, ldr_info.otaLen) == ldr_info.otaCrc)
+        {
+            uint32_t mark_addr = ldr_info_addr + LDR_MARK_OFFSET;
+            uint8_t retry = 0;
+
+            do {
+                ota_copy(ldr_run_addr, ldr_info.otaAddr, ldr_info.otaLen, mark_addr);
+                CACHE->CIR.INV_ALL = 1;
+                // Retry by compare only, marker may be set on a bad copy
+                mark_addr = 0;
+            } while ((img_crc32(ldr_run_addr, ldr_info.otaLen) != ldr_info.otaCrc) &&
+                     (++retry < LDR_COPY_RETRY));
 
-        // Erase loader info to prevent re-copy on next boot
-        fshc_erase((ldr_info_addr & 0x00FFFF00), FSH_CMD_ER_PAGE);
+            copy_ok = (retry < LDR_COPY_RETRY);
+        }
+
+        // Erase loader info to prevent re-copy on next boot, kept on failure to copy again
+        if (copy_ok)
+        {
+            fshc_erase((ldr_info_addr & 0x00FFFF00), FSH_CMD_ER_PAGE);
+        }
 
         // Re-enable watchdog
         iwdt_conf(0x20000);
+
+        // Flash fault persists: reset to copy again rather than run a half-copied image
+        if (!copy_ok)
+        {
+            NVIC_SystemReset();
+        }
     }
 
     // Jump to application
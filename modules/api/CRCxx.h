@@ -308,6 +308,13 @@ uint32_t crc24_interlaken(uint8_t *data, ulen_t length);
 *****************************************************************************/
 uint32_t crc32(uint8_t *data, ulen_t length);
 
+/******************************************************************************
+* Name:    CRC-32 (table-driven, incremental)
+* Note:    crc = 0 to start, pass previous result to continue,
+*          crc32_update(crc32_update(0, a, n), b, m) == crc32(a|b, n+m)
+*****************************************************************************/
+uint32_t crc32_update(uint32_t crc, const uint8_t *data, ulen_t length);
+
 /******************************************************************************
 * Name:    CRC-32/MPEG-2
 * Poly:    0x4C11DB7  ( x32+x26+x23+x22+x16+x12+x11+x10+x8+x7+x5+x4+x2+x+1 )
@@ -0,0 +1,64 @@
+/**
+ ****************************************************************************************
+ *
+ * @file kscan.h
+ *
+ * @brief Header file - Key Matrix Scanner Module
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _KSCAN_H_
+#define _KSCAN_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Max number of keys(rows * cols), index of key = row * nb_col + col
+#if !defined(KSCAN_KEY_MAX)
+#define KSCAN_KEY_MAX       (64)
+#endif
+
+/// Change event: bit7 press(1) or release(0), bit0~6 index of key
+#define KSCAN_EVT(key, press)   (((press) ? 0x80 : 0x00) | (key))
+#define KSCAN_EVT_KEY(evt)      ((evt) & 0x7F)
+#define KSCAN_EVT_PRESS(evt)    (((evt) & 0x80) != 0)
+
+/// Callback of change events of one scan, in order of key index
+typedef void(*kscan_func_t)(const uint8_t *evts, uint8_t nb);
+
+
+/*
+ * FUNCTION DECLARATION
+ ****************************************************************************************
+ */
+
+/**
+ ****************************************************************************************
+ * @brief Init iopad and env of matrix, rows driven and cols read.
+ *
+ * @param[in] rows    iopad of rows, NULL if direct keys(cols to GND or VCC)
+ * @param[in] nb_row  number of rows, 0 if direct keys
+ * @param[in] cols    iopad of cols
+ * @param[in] nb_col  number of cols
+ ****************************************************************************************
+ */
+void kscan_init(const uint8_t *rows, uint8_t nb_row, const uint8_t *cols, uint8_t nb_col);
+
+/// Conf event handler and arm wake-on-press, disabled when 'hdl' is NULL
+void kscan_conf(kscan_func_t hdl);
+
+/// Poll in main loop, start fast scanning once woken by key press
+void kscan_schedule(void);
+
+/// Keys held or debouncing, scanning by timer
+bool kscan_busy(void);
+
+
+#endif  // _KSCAN_H_
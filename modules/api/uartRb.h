@@ -12,6 +12,7 @@
 #define _UARTRB_H_
 
 #include <stdint.h>
+#include <stdbool.h>
 #include "uart.h"
 
 
@@ -55,6 +56,15 @@ uint16_t uart1Rb_Len(void);
 /// Read data from RB, return the Length of data copied.
 uint16_t uart1Rb_Read(uint8_t *buff, uint16_t max);
 
+/// Peek data in RB from offset without copy, return the Length linear till end of RB.
+uint16_t uart1Rb_Peek(uint16_t offset, const uint8_t **ptr);
+
+/// Drop data from RB after used, be used with uart1Rb_Peek().
+void uart1Rb_Drop(uint16_t len);
+
+/// RX line idle(timeout) since last call, time to flush partial data.
+bool uart1Rb_Idle(void);
+
 #endif  //(USE_UART1)
 
 #if (USE_UART2)
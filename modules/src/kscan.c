@@ -0,0 +1,352 @@
+/**
+ ****************************************************************************************
+ *
+ * @file kscan.c
+ *
+ * @brief Key Matrix Scanner via EXTI wake and soft-timer.
+ *
+ *  - Idle: all rows driven active, any press changes a col -> EXTI, no scanning at all.
+ *  - Woken: scan at once, then every KSCAN_FAST_INTV while integrators moving,
+ *           every KSCAN_HOLD_INTV while keys held stable.
+ *  - All released for KSCAN_IDLE_CNT scans: back to idle, EXTI armed again.
+ *  Each key has an integrator(0 ~ KSCAN_DEB_CNT), state flips only at both ends,
+ *  so press reported (KSCAN_DEB_CNT - 1) * KSCAN_FAST_INTV after wake.
+ *
+ ****************************************************************************************
+ */
+
+#include "drvs.h"
+#include "sftmr.h"
+#include "kscan.h"
+
+
+/*
+ * USER CUSTOMIZE
+ ****************************************************************************************
+ */
+
+/// Active level: 1 - cols pull-up, rows drive low; 0 - cols pull-down, rows drive high
+#if !defined(KSCAN_ACT_LOW)
+#define KSCAN_ACT_LOW       (1)
+#endif
+
+/// Scan interval while integrators moving, and while keys held stable
+#if !defined(KSCAN_FAST_INTV)
+#define KSCAN_FAST_INTV     _MS(10)
+#endif
+
+#if !defined(KSCAN_HOLD_INTV)
+#define KSCAN_HOLD_INTV     _MS(20)
+#endif
+
+/// Integrator top, consecutive scans to confirm press or release
+#if !defined(KSCAN_DEB_CNT)
+#define KSCAN_DEB_CNT       (2)
+#endif
+
+/// Scans with all released before idle
+#if !defined(KSCAN_IDLE_CNT)
+#define KSCAN_IDLE_CNT      (2)
+#endif
+
+/// Cols also wake core from sleep @see wakeup_io_sw()
+#if !defined(KSCAN_WKUP_IO)
+#define KSCAN_WKUP_IO       (1)
+#endif
+
+/// Implement EXTI_IRQHandler here, disable if EXTI shared by user
+#if !defined(KSCAN_EXTI_IRQ)
+#define KSCAN_EXTI_IRQ      (1)
+#endif
+
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Max events delivered once
+#define KSCAN_EVT_MAX       (8)
+
+#define KEY_BIT_GET(bits, k)    (((bits)[(k) >> 3] >> ((k) & 7)) & 0x01)
+#define KEY_BIT_SET(bits, k)    ((bits)[(k) >> 3] |= (1 << ((k) & 7)))
+#define KEY_BIT_CLR(bits, k)    ((bits)[(k) >> 3] &= ~(1 << ((k) & 7)))
+
+typedef struct kscan_env_tag {
+    kscan_func_t   func;    // event call
+    const uint8_t *rows;    // iopad of rows
+    const uint8_t *cols;    // iopad of cols
+    uint32_t       row_msk;
+    uint32_t       col_msk;
+    uint8_t        nb_row;
+    uint8_t        nb_col;
+    uint8_t        tmrid;   // softTimer ID
+    uint8_t        idle;    // scans all released
+    volatile bool  wake;    // set by EXTI
+
+    uint8_t        held[(KSCAN_KEY_MAX + 7) / 8];  // debounced state
+    uint8_t        integ[KSCAN_KEY_MAX];           // integrators
+} kscan_env_t;
+
+/// global variables
+static kscan_env_t kscan_env;
+
+
+/*
+ * FUNCTION DEFINITIONS
+ ****************************************************************************************
+ */
+
+/// Active cols of current row, bit(n) of cols[n]
+static uint32_t kscan_get_cols(void)
+{
+    uint32_t level = 0;
+    uint32_t iostat = GPIO_PIN_GET();
+
+    #if (KSCAN_ACT_LOW)
+    iostat = ~iostat;
+    #endif
+
+    for (uint8_t c = 0; c < kscan_env.nb_col; c++)
+    {
+        if ((iostat >> kscan_env.cols[c]) & 0x01)
+        {
+            level |= (1UL << c);
+        }
+    }
+
+    return level;
+}
+
+/// Drive all rows active, then any press seen on cols
+static void kscan_arm(void)
+{
+    uint32_t col_msk = kscan_env.col_msk;
+
+    GPIO_DIR_SET(kscan_env.row_msk);
+
+    #if (KSCAN_WKUP_IO)
+    wakeup_io_sw(col_msk, KSCAN_ACT_LOW ? col_msk : 0);
+    #endif
+
+    #if (KSCAN_ACT_LOW)
+    exti_set(EXTI_FTS, exti_get(EXTI_FTS) | col_msk);
+    #else
+    exti_set(EXTI_RTS, exti_get(EXTI_RTS) | col_msk);
+    #endif
+    exti_set(EXTI_ICR, col_msk);
+    exti_set(EXTI_IER, col_msk);
+
+    // pressed before armed, edge missed
+    if (kscan_get_cols())
+    {
+        exti_set(EXTI_IDR, col_msk);
+        kscan_env.wake = true;
+    }
+}
+
+/// Feed integrator of key, return true if state flipped
+__STATIC_FORCEINLINE bool kscan_integ(uint8_t key, bool press)
+{
+    uint8_t *integ = &kscan_env.integ[key];
+
+    if (press)
+    {
+        if (*integ < KSCAN_DEB_CNT)
+        {
+            if (++(*integ) == KSCAN_DEB_CNT)
+            {
+                return !KEY_BIT_GET(kscan_env.held, key);
+            }
+        }
+    }
+    else
+    {
+        if (*integ > 0)
+        {
+            if (--(*integ) == 0)
+            {
+                return KEY_BIT_GET(kscan_env.held, key);
+            }
+        }
+    }
+
+    return false;
+}
+
+/// Scan matrix once, return 0 - all released, 1 - held stable, 2 - integrators moving
+static uint8_t kscan_scan(void)
+{
+    uint8_t evts[KSCAN_EVT_MAX];
+    uint8_t nb = 0, busy = 0;
+    uint8_t nb_row = (kscan_env.nb_row) ? kscan_env.nb_row : 1;
+
+    for (uint8_t r = 0; r < nb_row; r++)
+    {
+        uint32_t level;
+
+        if (kscan_env.nb_row)
+        {
+            // only current row driven
+            GPIO_DIR_SET(1UL << kscan_env.rows[r]);
+            level = kscan_get_cols();
+            GPIO_DIR_CLR(1UL << kscan_env.rows[r]);
+        }
+        else
+        {
+            level = kscan_get_cols();
+        }
+
+        for (uint8_t c = 0; c < kscan_env.nb_col; c++)
+        {
+            uint8_t key = r * kscan_env.nb_col + c;
+            bool press  = (level >> c) & 0x01;
+
+            if (key >= KSCAN_KEY_MAX)
+                break;
+
+            if (kscan_integ(key, press))
+            {
+                if (press)
+                    KEY_BIT_SET(kscan_env.held, key);
+                else
+                    KEY_BIT_CLR(kscan_env.held, key);
+
+                evts[nb++] = KSCAN_EVT(key, press);
+                if (nb == KSCAN_EVT_MAX)
+                {
+                    kscan_env.func(evts, nb);
+                    nb = 0;
+                }
+            }
+
+            if ((kscan_env.integ[key] != 0) && (kscan_env.integ[key] != KSCAN_DEB_CNT))
+                busy = 2;
+            else if ((busy == 0) && (kscan_env.integ[key] != 0))
+                busy = 1;
+        }
+    }
+
+    if (nb)
+    {
+        kscan_env.func(evts, nb);
+    }
+
+    return busy;
+}
+
+static tmr_tk_t kscan_timer_handler(tmr_id_t id)
+{
+    (void)id;
+    uint8_t busy = kscan_scan();
+
+    if (busy)
+    {
+        kscan_env.idle = 0;
+        return (busy == 2) ? KSCAN_FAST_INTV : KSCAN_HOLD_INTV;
+    }
+
+    if (++kscan_env.idle < KSCAN_IDLE_CNT)
+    {
+        return KSCAN_FAST_INTV;
+    }
+
+    // all released, sleep on EXTI
+    kscan_env.tmrid = TMR_ID_NONE;
+    kscan_arm();
+    return 0;
+}
+
+#if (KSCAN_EXTI_IRQ)
+void EXTI_IRQHandler(void)
+{
+    uint32_t irq_sta = exti_get(EXTI_RIF) & kscan_env.col_msk;
+
+    if (irq_sta)
+    {
+        // masked until idle again, scanning toggles rows
+        exti_set(EXTI_IDR, kscan_env.col_msk);
+        exti_set(EXTI_ICR, irq_sta);
+        kscan_env.wake = true;
+    }
+}
+#endif
+
+void kscan_schedule(void)
+{
+    if (kscan_env.wake && (kscan_env.func != NULL) && (kscan_env.tmrid == TMR_ID_NONE))
+    {
+        kscan_env.wake = false;
+        kscan_env.idle = 0;
+
+        // release rows, driven one by one when scanning
+        GPIO_DIR_CLR(kscan_env.row_msk);
+
+        kscan_env.tmrid = sftmr_start(KSCAN_FAST_INTV, kscan_timer_handler);
+        kscan_scan();
+    }
+}
+
+bool kscan_busy(void)
+{
+    return (kscan_env.wake || (kscan_env.tmrid != TMR_ID_NONE));
+}
+
+void kscan_conf(kscan_func_t hdl)
+{
+    exti_set(EXTI_IDR, kscan_env.col_msk);
+
+    // clear curr timer
+    if (kscan_env.tmrid != TMR_ID_NONE)
+    {
+        sftmr_clear(kscan_env.tmrid);
+        kscan_env.tmrid = TMR_ID_NONE;
+    }
+
+    kscan_env.func = hdl;
+    kscan_env.wake = false;
+    memset(kscan_env.held, 0, sizeof(kscan_env.held));
+    memset(kscan_env.integ, 0, sizeof(kscan_env.integ));
+
+    if (hdl)
+    {
+        kscan_arm();
+    }
+}
+
+void kscan_init(const uint8_t *rows, uint8_t nb_row, const uint8_t *cols, uint8_t nb_col)
+{
+    memset(&kscan_env, 0, sizeof(kscan_env_t));
+    //kscan_env.tmrid = TMR_ID_NONE;
+
+    kscan_env.rows   = rows;
+    kscan_env.nb_row = nb_row;
+    kscan_env.cols   = cols;
+    kscan_env.nb_col = nb_col;
+
+    // rows output when driven, else HiZ
+    for (uint8_t r = 0; r < nb_row; r++)
+    {
+        kscan_env.row_msk |= (1UL << rows[r]);
+        iom_ctrl(rows[r], IOM_HIZ);
+    }
+    GPIO_DIR_CLR(kscan_env.row_msk);
+    #if (KSCAN_ACT_LOW)
+    GPIO_DAT_CLR(kscan_env.row_msk);
+    #else
+    GPIO_DAT_SET(kscan_env.row_msk);
+    #endif
+
+    // cols input with pull
+    for (uint8_t c = 0; c < nb_col; c++)
+    {
+        kscan_env.col_msk |= (1UL << cols[c]);
+        iom_ctrl(cols[c], KSCAN_ACT_LOW ? IE_UP : IE_DOWN);
+    }
+    GPIO_DIR_CLR(kscan_env.col_msk);
+
+    // edge with hardware debounce, integrators do the rest
+    exti_init(EXTI_DBC(15, 4));
+    exti_set(EXTI_DBE, exti_get(EXTI_DBE) | kscan_env.col_msk);
+    NVIC_EnableIRQ(EXTI_IRQn);
+}
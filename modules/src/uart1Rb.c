@@ -50,7 +50,12 @@
 
 #include "dma.h"
 #define UART1_DMA_CHAN      DMA_CH7
-#define RBUF_SIZE           (0x300)
+
+/// Ping-Pong halves, each max 1024 bytes(DMA cycles)
+#if !defined(UART1_DMA_RBUF_SIZE)
+    #define UART1_DMA_RBUF_SIZE (0x300)
+#endif
+#define RBUF_SIZE           (UART1_DMA_RBUF_SIZE)
 #define RBUF_HALF_SIZE      (RBUF_SIZE/2)
 
 volatile bool pong;
@@ -67,6 +72,9 @@ volatile bool pong;
 
 /// RingBuffer for UART1
 static rbuf_t uart1RbRx;
+
+/// RX line idle(timeout) happened
+static volatile bool uart1RxIdle;
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -133,6 +141,7 @@ void CTMR_IRQHandler(void)
                 uart1RbRx.head = 0 + (RBUF_HALF_SIZE - remain_len);
             }
         }
+        uart1RxIdle = true;
 
         UART1->ICR.EOB = 1; // Clear EOB Interrupt Flag
         UART1->IER.EOB = 1; // Enable RXRD Interrupt
@@ -198,6 +207,36 @@ uint16_t uart1Rb_Read(uint8_t *buff, uint16_t max)
     return rbuf_gets(&uart1RbRx, buff, max);
 }
 
+uint16_t uart1Rb_Peek(uint16_t offset, const uint8_t **ptr)
+{
+    uint16_t len  = rbuf_len(&uart1RbRx);
+    uint16_t tail = (uart1RbRx.tail + offset) % RBUF_SIZE;
+
+    if (offset >= len)
+    {
+        return 0;
+    }
+
+    *ptr = &uart1RbRx.data[tail];
+    len -= offset;
+
+    // linear till end of buffer
+    return (len < RBUF_SIZE - tail) ? len : (RBUF_SIZE - tail);
+}
+
+void uart1Rb_Drop(uint16_t len)
+{
+    uart1RbRx.tail = (uart1RbRx.tail + len) % RBUF_SIZE;
+}
+
+bool uart1Rb_Idle(void)
+{
+    bool idle = uart1RxIdle;
+
+    uart1RxIdle = false;
+    return idle;
+}
+
 void UART1_IRQHandler(void)
 {
     uint32_t state = UART1->IFM.Word; // UART1->RIF.Word;
@@ -232,6 +271,7 @@ void UART1_IRQHandler(void)
                     uart1RbRx.head = 0 + (RBUF_HALF_SIZE - remain_len);
                 }
             }
+            uart1RxIdle = true;
         }
         #endif
     #else
@@ -256,6 +296,7 @@ void UART1_IRQHandler(void)
         {
             rbuf_putc(&uart1RbRx, UART1->RBR);
         }
+        uart1RxIdle = true;
 
         UART1->ICR.RTO = 1; // Clear RTO Interrupt Flag
         UART1->IER.RTO = 1; // Enable RTO Interrupt
@@ -12,6 +12,7 @@
 #include "drvs.h"
 #include "app.h"
 #include "gapm_api.h"
+#include "app_advs.h"
 
 #if (DBG_ACTV)
 #include "dbg.h"
@@ -125,6 +126,160 @@ static struct actv_env_tag actv_env;
  ****************************************************************************************
  */
 
+uint32_t g_rand_num;
+
+/// Build advertising data with new random, return length
+static uint8_t app_adv_data_build(uint8_t *adv_data)
+{
+    uint8_t length = ADV_DATA_TOTAL_LEN;
+
+    g_rand_num = sadc_rand_num();
+
+    // Set flags: 3B
+    adv_data[0] = ADV_FLAGS_TYPE_LEN;
+    adv_data[1] = GAP_AD_TYPE_FLAGS;
+    adv_data[2] = ADV_FLAGS_VALUE;
+
+    // Set manufacturer data: 6B
+    adv_data[3] = ADV_MANU_LEN;
+    adv_data[4] = GAP_AD_TYPE_MANU_SPECIFIC_DATA;
+    write32p(adv_data + 5, g_rand_num);
+
+    return length;
+}
+
+/// Build scan response data with suffix of random, return length
+static uint8_t app_adv_rsp_build(uint8_t *rsp_data)
+{
+    // Buffer: name(max 20) + header(2) + suffix '-' + 4 hex chars = 27
+    uint8_t length;
+
+    // Set device name
+    length = app_name_get(DEV_NAME_MAX_LEN, &rsp_data[2]);
+    rsp_data[0] = length + 6;
+    rsp_data[1] = GAP_AD_TYPE_COMPLETE_NAME; // 0x09
+    length += 2;
+
+    rsp_data[length++] = '-';
+    rsp_data[length++] = co_hex((g_rand_num >> 12) & 0x0F);
+    rsp_data[length++] = co_hex((g_rand_num >> 8)  & 0x0F);
+    rsp_data[length++] = co_hex((g_rand_num >> 4)  & 0x0F);
+    rsp_data[length++] = co_hex((g_rand_num >> 0)  & 0x0F);
+
+    return length;
+}
+
+#if (APP_ADV_SCH)
+static uint8_t app_adv_data_gen(uint8_t set, uint8_t *data, uint8_t max)
+{
+    (void)set;(void)max;
+    return app_adv_data_build(data);
+}
+
+static uint8_t app_adv_rsp_gen(uint8_t set, uint8_t *data, uint8_t max)
+{
+    (void)set;(void)max;
+    return app_adv_rsp_build(data);
+}
+
+/// Set of app, payload changed each ADV_CHNG_PERIOD while advertising
+static const struct advs_cfg app_adv_cfg =
+{
+    .prop      = GAPM_ADV_PROP_UNDIR_CONN_MASK,
+    .disc_mode = GAPM_ADV_MODE_GEN_DISC,
+    .chmap     = APP_ADV_CHMAP,
+    .intv_min  = APP_ADV_INT_MIN,
+    .intv_max  = APP_ADV_INT_MAX,
+    .on_time   = APP_ADV_DURATION,
+    .period    = 0,
+    .rotate    = ADV_CHNG_PERIOD / 10,
+    .adv_gen   = app_adv_data_gen,
+    .rsp_gen   = app_adv_rsp_gen,
+};
+
+/// Beacon beside, non-connectable: counter in manufacturer data, 1s on of each 3s
+static uint8_t bcn_adv_gen(uint8_t set, uint8_t *data, uint8_t max)
+{
+    static uint16_t bcn_cnt;
+    (void)set;(void)max;
+
+    // Manufacturer data: CompId(0x09C5) + Counter
+    data[0] = 0x05;
+    data[1] = GAP_AD_TYPE_MANU_SPECIFIC_DATA;
+    write16p(data + 2, 0x09C5);
+    write16p(data + 4, bcn_cnt++);
+
+    return 6;
+}
+
+static const struct advs_cfg bcn_adv_cfg =
+{
+    .prop      = GAPM_ADV_PROP_NON_CONN_NON_SCAN_MASK,
+    .disc_mode = GAPM_ADV_MODE_NON_DISC,
+    .chmap     = APP_ADV_CHMAP,
+    .intv_min  = 160,
+    .intv_max  = 160,
+    .on_time   = 100,
+    .period    = 300,
+    .rotate    = 100,
+    .adv_gen   = bcn_adv_gen,
+    .rsp_gen   = NULL,
+};
+
+/**
+ ****************************************************************************************
+ * @brief Action/Command of Advertising, set of app in scheduler
+ *
+ * @param[in] actv_op  Operation of activity
+ ****************************************************************************************
+ */
+void app_adv_action(uint8_t actv_op)
+{
+    switch (actv_op)
+    {
+        case ACTV_CREATE:
+        {
+            if (actv_env.advsta == ACTV_STATE_OFF)
+            {
+                // index of set in scheduler
+                actv_env.advidx = advs_add(&app_adv_cfg, true);
+                actv_env.advsta = ACTV_STATE_READY;
+                app_state_set(APP_READY);
+
+                advs_add(&bcn_adv_cfg, true);
+            }
+        } break;
+
+        case ACTV_START:
+        {
+            advs_start(actv_env.advidx);
+        } break;
+
+        case ACTV_STOP:
+        {
+            advs_stop(actv_env.advidx);
+        } break;
+
+        case ACTV_DELETE:
+        {
+            if (actv_env.advsta != ACTV_STATE_OFF)
+            {
+                advs_del(actv_env.advidx);
+                actv_env.advsta = ACTV_STATE_OFF;
+            }
+        } break;
+
+        case ACTV_RELOAD:
+        {
+            // payload updated while advertising, no stop and create again
+            advs_update(actv_env.advidx);
+        } break;
+
+        default:
+            break;
+    }
+}
+#else //!(APP_ADV_SCH)
 static void app_adv_create(void)
 {
     struct gapm_adv_create_param adv_param;
@@ -149,45 +304,18 @@ static void app_adv_create(void)
     gapm_create_advertising(GAPM_STATIC_ADDR, &adv_param);
 }
 
-uint32_t g_rand_num;
-
 static void app_adv_set_adv_data(void)
 {
     uint8_t adv_data[GAP_ADV_DATA_LEN];
-    uint8_t length = ADV_DATA_TOTAL_LEN;
-
-    g_rand_num = sadc_rand_num();
-
-    // Set flags: 3B
-    adv_data[0] = ADV_FLAGS_TYPE_LEN;
-    adv_data[1] = GAP_AD_TYPE_FLAGS;
-    adv_data[2] = ADV_FLAGS_VALUE;
-
-    // Set manufacturer data: 6B
-    adv_data[3] = ADV_MANU_LEN;
-    adv_data[4] = GAP_AD_TYPE_MANU_SPECIFIC_DATA;
-    write32p(adv_data + 5, g_rand_num);
+    uint8_t length = app_adv_data_build(adv_data);
 
     gapm_set_adv_data(actv_env.advidx, GAPM_SET_ADV_DATA, length, adv_data);
 }
 
 static void app_adv_set_scan_rsp(void)
 {
-    uint8_t length;
-    // Buffer: name(max 20) + header(2) + suffix '-' + 4 hex chars = 27
     uint8_t rsp_data[DEV_NAME_MAX_LEN+7];
-
-    // Set device name
-    length = app_name_get(DEV_NAME_MAX_LEN, &rsp_data[2]);
-    rsp_data[0] = length + 6;
-    rsp_data[1] = GAP_AD_TYPE_COMPLETE_NAME; // 0x09
-    length += 2;
-
-    rsp_data[length++] = '-';
-    rsp_data[length++] = co_hex((g_rand_num >> 12) & 0x0F);
-    rsp_data[length++] = co_hex((g_rand_num >> 8)  & 0x0F);
-    rsp_data[length++] = co_hex((g_rand_num >> 4)  & 0x0F);
-    rsp_data[length++] = co_hex((g_rand_num >> 0)  & 0x0F);
+    uint8_t length = app_adv_rsp_build(rsp_data);
 
     gapm_set_adv_data(actv_env.advidx, GAPM_SET_SCAN_RSP_DATA, length, rsp_data);
 }
@@ -312,6 +440,7 @@ void app_adv_event(uint8_t gapm_op, uint8_t status)
             break;
     }
 }
+#endif //(APP_ADV_SCH)
 
 #endif //(BLE_EN_ADV)
 
@@ -766,6 +895,10 @@ void app_init_event(uint8_t gapm_op, uint8_t status)
 void app_actv_create(void)
 {
     memset(&actv_env, 0, sizeof(actv_env));
+    #if (APP_ADV_SCH)
+    advs_init();
+    #endif //(APP_ADV_SCH)
+
     #if (BLE_EN_ADV)
     app_adv_action(ACTV_CREATE);
     #endif //(BLE_EN_ADV)
@@ -791,7 +924,14 @@ void app_actv_cmp_evt(uint8_t operation, uint8_t status)
 {
     switch (operation)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case (GAPM_CREATE_ADV_ACTIVITY):
+        case (GAPM_SET_ADV_DATA):
+        case (GAPM_SET_SCAN_RSP_DATA):
+        {
+            advs_cmp_evt(operation, status);
+        } break;
+        #elif (BLE_EN_ADV)
         case (GAPM_CREATE_ADV_ACTIVITY):
         case (GAPM_SET_ADV_DATA):
         case (GAPM_SET_SCAN_RSP_DATA):
@@ -831,7 +971,12 @@ void app_actv_created_ind(uint8_t actv_type, uint8_t actv_idx)
 {
     switch (actv_type)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case GAPM_ACTV_TYPE_ADV:
+        {
+            advs_created_ind(actv_idx);
+        } break;
+        #elif (BLE_EN_ADV)
         case GAPM_ACTV_TYPE_ADV:
         {
             actv_env.advidx = actv_idx;
@@ -870,7 +1015,17 @@ void app_actv_stopped_ind(uint8_t actv_type, uint8_t actv_idx, uint8_t reason)
     (void)actv_idx;
     switch (actv_type)
     {
-        #if (BLE_EN_ADV)
+        #if (APP_ADV_SCH)
+        case GAPM_ACTV_TYPE_ADV:
+        {
+            // Set of app stopped by connection or duration timeout, beacon by its budget
+            if ((advs_stopped_ind(actv_idx, reason) == actv_env.advidx)
+                && (reason == GAP_ERR_TIMEOUT) && (app_state_get() == APP_READY))
+            {
+                app_state_set(APP_IDLE);
+            }
+        } break;
+        #elif (BLE_EN_ADV)
         case GAPM_ACTV_TYPE_ADV:
         {
             // Advertising Stopped by slave connection or duration timeout
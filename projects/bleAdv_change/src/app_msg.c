@@ -149,7 +149,10 @@ void app_conf_fsm(uint8_t evt)
         // Create Activities
         app_actv_create();
 
+        #if !(APP_ADV_SCH)
+        // Rotated by scheduler in advs_proc(), else reload by timer
         ke_timer_set(APP_ADV_CHNG, TASK_APP, ADV_CHNG_PERIOD);
+        #endif
     }
 }
 
@@ -46,10 +46,15 @@
     #define DBG_GAPC           (1)
     #define DBG_DISS           (0)
     #define DBG_SESS           (0)
+    #define DBG_ADVS           (1)
 #endif
 
 /// Misc Options
 #define LED_PLAY               (1)
 #define CFG_SLEEP              (0)
 #define ADV_CHNG_PERIOD        (2000) // unit 1ms
+
+/// Advertising Scheduler @see app_advs.h, set of app + beacon
+#define APP_ADV_SCH            (1)
+#define ADVS_SET_MAX           (2)
 #endif  //_APP_CFG_H_
@@ -13,6 +13,7 @@
 #include "drvs.h"
 
 #include "app.h"
+#include "app_advs.h"
 #include "prf_sess.h"
 #include "uartRb.h"
 
@@ -133,5 +134,9 @@ void user_procedure(void)
     sleep_proc();
     #endif //(CFG_SLEEP)
 
+    #if (APP_ADV_SCH)
+    advs_proc();
+    #endif //(APP_ADV_SCH)
+
     data_proc();
 }
@@ -32,6 +32,12 @@
 #define PRF_BASS               (1)
 #define PRF_HIDS               (1)
 
+/// Merge reports queued when link busy @see prf_hids.h
+#define HID_RPT_MERGE          (1)
+
+/// Adaptive slave latency by key activity @see app_slat.h
+#define APP_SLAT_EN            (1)
+
 /// Debug Configure
 #if (DBG_MODE)
     #define DBG_APP            (1)
@@ -42,6 +48,7 @@
     #define DBG_KEYS           (0)
     #define DBG_HIDS           (0)
     #define DBG_BASS           (0)
+    #define DBG_SLAT           (1)
 #endif
 
 /// Misc Options
@@ -12,6 +12,7 @@
 #include "drvs.h"
 #include "app.h"
 #include "keys.h"
+#include "kscan.h"
 #include "hid_desc.h"
 
 #if (DBG_KEYS)
@@ -37,11 +38,6 @@
 #define LED1                BIT(PA_LED1)
 #define LEDS                (LED1 | LED0)
 
-#define BTN0                BIT(PA_BTN0)
-#define BTN1                BIT(PA_BTN1)
-#define BTN2                BIT(PA_BTN2)
-#define BTNS                (BTN0 | BTN1 | BTN2)
-
 /// HID keyboard LED lock bits
 #define LED_LOCK_NUM        (0x01)  ///< Num Lock LED bit
 #define LED_LOCK_CAPS       (0x02)  ///< Caps Lock LED bit
@@ -117,54 +113,64 @@ uint8_t hid_mouse_send_report(int8_t x)
     return ret;
 }
 
-void keys_init(void)
-{
-    GPIO_DIR_SET_HI(LEDS);
+/// Keys of kscan, direct to GND(no rows)
+static const uint8_t PA_BTNS[] = { PA_BTN0, PA_BTN1, PA_BTN2 };
+static const uint8_t KEY_MAP[] = { KEY_ENTER, KEY_UP, KEY_DOWN };
 
-    GPIO_DAT_CLR(BTNS);
-    GPIO_DIR_CLR(BTNS);
+#define NB_BTNS             sizeof(PA_BTNS)
 
-    iom_ctrl(PA_BTN0, IOM_PULLUP | IOM_INPUT);
-    iom_ctrl(PA_BTN1, IOM_PULLUP | IOM_INPUT);
-    iom_ctrl(PA_BTN2, IOM_PULLUP | IOM_INPUT);
-}
+/// Keyboard report of held keys: 1B(ctlkeys) + 1B(resv) + 6B(keycode)
+static uint8_t keybd_report[RPT_LEN_KB];
 
-void keys_scan(void)
+static void keys_event(const uint8_t *evts, uint8_t nb)
 {
-    static uint32_t btn_lvl = BTNS;
-    uint8_t ret = 0;
-    uint32_t value = GPIO_PIN_GET() & BTNS;
-    uint32_t chng = btn_lvl ^ value;
-    btn_lvl = value;
+    for (uint8_t i = 0; i < nb; i++)
+    {
+        uint8_t code = KEY_MAP[KSCAN_EVT_KEY(evts[i])];
+        uint8_t *pos = memchr(&keybd_report[2], code, RPT_LEN_KB - 2);
 
-    if (chng) {
-        uint8_t code = 0;
+        DEBUG("keys(evt:%02X,code:%d)", evts[i], code);
 
-        if ((chng & BTN0) && ((value & BTN0) == 0)) {
-            code = KEY_ENTER;
-        }
-        if ((chng & BTN1) && ((value & BTN1) == 0)) {
-            code = KEY_UP;
+        if (KSCAN_EVT_PRESS(evts[i]))
+        {
+            if ((pos == NULL) && ((pos = memchr(&keybd_report[2], 0, RPT_LEN_KB - 2)) != NULL))
+            {
+                *pos = code;
+            }
         }
-        if ((chng & BTN2) && ((value & BTN2) == 0)) {
-            code = KEY_DOWN;
+        else if (pos != NULL)
+        {
+            *pos = 0;
         }
+    }
 
-        DEBUG("keys(val:%X,chng:%X,code:%d)\r\n", btn_lvl, chng, code);
+    if (app_state_get() >= APP_CONNECTED)
+    {
+        uint8_t ret = keybd_report_send(app_env.curidx, keybd_report);
 
-        if (app_state_get() >= APP_CONNECTED)
-        {
-            ret = hid_keybd_send_report(code);
-            if (ret == 0) {
-                DEBUG("keys Fail(sta:%d)\r\n", ret);
-            }
+        if (ret != LE_SUCCESS) {
+            DEBUG("keys Fail(sta:%d)", ret);
+        }
 
-            if (code) {
-                hid_mouse_send_report(MOUSE_MOVE_DX);
-            }
-            else {
-                hid_mouse_send_report(-MOUSE_MOVE_DX);
-            }
+        if (KSCAN_EVT_PRESS(evts[nb - 1])) {
+            hid_mouse_send_report(MOUSE_MOVE_DX);
+        }
+        else {
+            hid_mouse_send_report(-MOUSE_MOVE_DX);
         }
     }
 }
+
+void keys_init(void)
+{
+    GPIO_DIR_SET_HI(LEDS);
+
+    // wake on press, scan by timer while held
+    kscan_init(NULL, 0, PA_BTNS, NB_BTNS);
+    kscan_conf(keys_event);
+}
+
+void keys_scan(void)
+{
+    kscan_schedule();
+}
@@ -55,8 +55,9 @@ static void devInit(void)
     debug("Start(rsn:%X)...\r\n", rsn);
     trace_init();
     
-    #if (LED_PLAY)
     sftmr_init();
+
+    #if (LED_PLAY)
     leds_init();
     leds_play(LED_FAST_BL);
     #endif //(LED_PLAY)
@@ -82,10 +83,8 @@ int main(void)
         // Schedule Messages & Events
         ble_schedule();
 
-        #if (LED_PLAY)
         // SoftTimer Polling
         sftmr_schedule();
-        #endif //(LED_PLAY)
 
         // User's Procedure
         user_procedure();
@@ -13,6 +13,7 @@
 #include "drvs.h"
 
 #include "app.h"
+#include "app_slat.h"
 #include "keys.h"
 #include "uartRb.h"
 #include "prf_bass.h"
@@ -170,4 +171,8 @@ void user_procedure(void)
     #endif //(UART_CMD)
 
     keys_scan();
+
+    #if (APP_SLAT_EN)
+    app_slat_proc();
+    #endif //(APP_SLAT_EN)
 }
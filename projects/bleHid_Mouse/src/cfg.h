@@ -35,6 +35,14 @@
 #define PRF_BASS               (1)
 #define PRF_HIDS               (1)
 
+/// Merge reports queued when link busy @see prf_hids.h
+#define HID_RPT_MERGE          (1)
+/// Logical range of X/Y and Wheel, *KEEP UP with hid_desc.c
+#define HID_MOUSE_XY_MIN       (-248)
+#define HID_MOUSE_XY_MAX       (255)
+#define HID_MOUSE_WHEEL_MIN    (-127)
+#define HID_MOUSE_WHEEL_MAX    (127)
+
 /// Debug Configure
 #if (DBG_MODE)
     #define DBG_APP            (1)
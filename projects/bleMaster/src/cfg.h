@@ -35,11 +35,19 @@
 #define GATT_CLI               (BLE_NB_MASTER)
 #define BLE_DBG_LTK            (BLE_NB_MASTER)
 
+/// Scan filter: rule table with recently-seen cache @see app_scan.h
+#define APP_SCAN_FILT          (1)
+
+/// RPA cache: bonded peers found by IRK, each RPA resolved once @see app_rpa.h
+#define RPA_CACHE              (1)
+
 /// Debug Configure
 #if (DBG_MODE)
     #define DBG_APP            (1)
     #define DBG_PROC           (0)
     #define DBG_ACTV           (1)
+    #define DBG_SCAN           (0)
+    #define DBG_RPA            (0)
     #define DBG_GAPM           (1)
     #define DBG_GAPC           (1)
     #define DBG_GATT           (1)
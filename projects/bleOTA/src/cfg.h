@@ -40,6 +40,11 @@
 #define SES_UUID_128           (1)
 #define SES_READ_SUP           (0)
 
+/// OTA Service @see prf_ota.c (Compressed bin, Diff patch, Window transfer)
+#define OTA_LZ_SUP             (1)
+#define OTA_DIFF_SUP           (1)
+#define OTA_WIN_SUP            (1)
+
 /// Debug Configure
 #if (DBG_MODE)
     #define DBG_APP            (0)
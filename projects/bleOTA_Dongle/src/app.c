@@ -16,6 +16,7 @@
 #include "prf_api.h"
 #include "leds.h"
 #include "CRCxx.h"
+#include "app_heap.h"
 
 #if (DBG_APP)
 #include "dbg.h"
@@ -212,6 +213,10 @@ __WEAK void app_init(uint16_t rsn)
         heap.size[MEM_MSG] = BLE_HEAP_MSG_SIZE;
         ble_heap(&heap);
 
+        #if (HEAP_STAT)
+        heap_stat_init(&heap);
+        #endif
+
         // Init BLE and App
         ble_init();
         ble_app();
@@ -366,6 +371,11 @@ __WEAK void app_conn_fsm(uint8_t evt, uint8_t conidx, const void *param)
         {
             // Connected state, record Index
             app_env.curidx = conidx;
+
+            #if (BLE_MULTI_CONN)
+            // Set Connection Bit of conidx
+            app_env.conbits |= (1 << conidx);
+            #endif //(BLE_MULTI_CONN)
         } break;
 
         case BLE_CONNECTED:
@@ -376,11 +386,23 @@ __WEAK void app_conn_fsm(uint8_t evt, uint8_t conidx, const void *param)
             // Enable profiles by role
 
             disc_ota_init(conidx);
+
+            #if (BLE_MULTI_CONN)
+            // Scan more devices for parallel OTA
+            if (OTA_LINK_FREE())
+            {
+                scan_list_reset();
+                init_timer_start();
+                app_scan_action(ACTV_START);
+            }
+            #endif //(BLE_MULTI_CONN)
         }
         break;
 
         case BLE_DISCONNECTED:
         {
+            ota_conn_close(conidx);
+
             if (((struct gapc_disconnect_ind *)param)->reason ==
                 LE_ERR_HL2HCI(LL_ERR_CON_TERM_BY_LOCAL_HOST))
             {
@@ -393,7 +415,23 @@ __WEAK void app_conn_fsm(uint8_t evt, uint8_t conidx, const void *param)
                 app_scan_action(ACTV_START);
             }
 
+            #if (BLE_MULTI_CONN)
+            // Clr Connection Bit of conidx
+            app_env.conbits &= ~(1 << conidx);
+
+            if (app_env.conbits == 0)
+            {
+                // Go READY when all disconnected
+                app_state_set(APP_READY);
+            }
+            else if (conidx == app_env.curidx)
+            {
+                // Least index of connection
+                app_env.curidx = co_ctz(app_env.conbits);
+            }
+            #else
             app_state_set(APP_READY);
+            #endif //(BLE_MULTI_CONN)
         }
         break;
 
@@ -12,6 +12,7 @@
 #include "app.h"
 #include "app_user.h"
 #include "gapm_api.h"
+#include "app_scan.h"
 
 #if (DBG_ACTV)
 #include "dbg.h"
@@ -376,6 +377,31 @@ const struct gap_bdaddr *scan_list_get(void)
     return scan_addr_list;
 }
 
+#if (APP_SCAN_FILT)
+/// Rule of COMPLETE_NAME prefixed with scan name, rebuilt when scan start
+static struct scan_filt name_rule;
+
+static void scan_name_rule(void)
+{
+    uint8_t  name_len;
+    uint8_t *p_adv_name = get_scan_name(&name_len);
+
+    if (name_len > SCAN_FILT_VAL_LEN)
+    {
+        name_len = SCAN_FILT_VAL_LEN;
+    }
+
+    memset(&name_rule, 0, sizeof(name_rule));
+    name_rule.ad_type  = GAP_AD_TYPE_COMPLETE_NAME;
+    name_rule.len      = name_len;
+    name_rule.rssi_min = -127;
+    memcpy(name_rule.value, p_adv_name, name_len);
+    memset(name_rule.mask, 0xFF, name_len);
+
+    scan_filt_conf(&name_rule, 1);
+}
+#endif //(APP_SCAN_FILT)
+
 /*
  * FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -433,6 +459,9 @@ void app_scan_action(uint8_t actv_op)
         case ACTV_START:
         {
             scan_cnt = 0;
+            #if (APP_SCAN_FILT)
+            scan_name_rule();
+            #endif
 
             DEBUG("ScanStarting:%d", actv_env.scansta);
             if (actv_env.scansta == ACTV_STATE_READY)
@@ -549,6 +578,11 @@ void app_scan_event(uint8_t gapm_op, uint8_t status)
  */
 void app_scan_result(const struct gap_bdaddr *paddr)
 {
+    if (ota_dev_done(paddr)) // updated already, maybe reboot with same name
+    {
+        return;
+    }
+
     for (uint8_t i = 0; i < scan_cnt; i++)
     {
         if (!memcmp(&scan_addr_list[i], paddr, sizeof(struct gap_bdaddr))) // save addr but diffrent
@@ -577,6 +611,14 @@ void app_actv_report_ind(struct gapm_ext_adv_report_ind const *report)
     uint8_t adv_info = report->info & GAPM_REPORT_INFO_REPORT_TYPE_MASK;
     if ((adv_info == GAPM_REPORT_TYPE_ADV_LEG) || (adv_info == GAPM_REPORT_TYPE_SCAN_RSP_LEG))
     {
+        #if (APP_SCAN_FILT)
+        if (scan_filt_match(report) != SCAN_FILT_NONE)
+        {
+            DEBUG("Find[rssi:%d]", report->rssi);
+            debugHex(report->trans_addr.addr.addr, GAP_BD_ADDR_LEN);
+            app_scan_result(&report->trans_addr);
+        }
+        #else
         const uint8_t *p_cursor    = report->data;
         const uint8_t *p_end_cusor = report->data + report->length;
         uint8_t  name_len;
@@ -604,6 +646,7 @@ void app_actv_report_ind(struct gapm_ext_adv_report_ind const *report)
             if (*p_cursor == 0) break;  // skip zero-length AD structure
             p_cursor += (*p_cursor + 1);
         }
+        #endif //(APP_SCAN_FILT)
     }
 }
 #endif //(BLE_EN_SCAN)
@@ -791,7 +834,7 @@ void app_init_event(uint8_t gapm_op, uint8_t status)
                 actv_env.initsta = ACTV_STATE_READY;
             }
 
-            if ((status == GAP_ERR_TIMEOUT) && (app_state_get() < APP_CONNECTED))
+            if ((status == GAP_ERR_TIMEOUT) && OTA_LINK_FREE())
             {
                 init_timer_start();
             }
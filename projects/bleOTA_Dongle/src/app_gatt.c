@@ -19,9 +19,22 @@
 #include "prf.h"
 #include "utils.h"
 #include "leds.h"
+#include "CRCxx.h"
+#include "bledef.h"
+#include "ota_img.h"
+#include "app_gcache.h"
+#include "app_gcli.h"
+#include "app_heap.h"
+
+#if (DBG_MODE)
+#include "dbg.h"
+/// OTA result and throughput statistics, output even DBG_GATT disabled
+#define OTA_STAT(format, ...) debug("<OTA>" format "\r\n", ##__VA_ARGS__)
+#else
+#define OTA_STAT(format, ...)
+#endif
 
 #if (DBG_GATT)
-#include "dbg.h"
 #define DEBUG(format, ...) debug("<%s,%d>" format "\r\n", __MODULE__, __LINE__, ##__VA_ARGS__)
 #define NEW_LINE           32
 #define debugDump(info, dat, len)                                                                  \
@@ -40,7 +53,6 @@
     } while (0)
 #else
 #define DEBUG(format, ...)
-#define debugHex(dat, len)
 #define debugDump(info, dat, len)
 #endif
 
@@ -63,8 +75,8 @@ const uint8_t ota_char_recv[] = OTA_BASE_UUID128(0x0F42);
  * DEFINES
  ****************************************************************************************
  */
-#define OTA_DATA_LEN          RD_32(0x18000010)
-#define OTA_DATA_STORE_POS    RD_32(0x18000014)
+#define OTA_DATA_LEN          ota_img_len()
+#define OTA_DATA_STORE_POS    ota_img_addr()
 #define OTA_DATA_STORE_OFFSET (OTA_DATA_STORE_POS - FLASH_BASE)
 // 1B(Head) + 1B(CMD) + 2B(IDX) + 2B(Len) + nB(data)
 #define OTA_DATA_POS          (6)
@@ -72,6 +84,17 @@ const uint8_t ota_char_recv[] = OTA_BASE_UUID128(0x0F42);
 #define BUFF_LEN  4096
 #define BUFF_WLEN (BUFF_LEN >> 2)
 
+/// Blocks of image cached in SRAM, shared by all sessions(read flash once)
+#if !defined(OTA_CACHE_NB)
+#define OTA_CACHE_NB          (2)
+#endif
+#define OTA_CACHE_NONE        (0xFF)
+
+/// Devices updated successfully, skipped when scanning(reboot with same name)
+#if !defined(OTA_DONE_MAX)
+#define OTA_DONE_MAX          (16)
+#endif
+
 enum prf_char_idx
 {
     CHAR_IDX_NTF,
@@ -80,30 +103,46 @@ enum prf_char_idx
     CHAR_IDX_MAX,
 };
 
-/// Structure containing the characteristics handles, value handles and
-/// descriptors
-struct ota_env_tag
+/// Block of image read from flash
+struct ota_cache_tag
 {
     uint32_t bin_data[BUFF_WLEN];
 
-    volatile uint16_t head;
-    volatile uint16_t tail;
+    uint32_t offset;
+    uint16_t length;
+    /// Sessions reading it, reloaded only when no user
+    uint8_t  users;
+    uint8_t  stamp;
+};
 
+/// OTA session of each connection, with the characteristics handles, value handles and
+/// descriptors of peer
+struct ota_conn_tag
+{
     uint32_t ota_bin_offset;
-    uint32_t ota_data_next;
     uint32_t ota_remain_size;
-    uint32_t ota_data_sum;
-    uint32_t ota_block_pkt_nb;
-    uint32_t ota_pkt_idx;
+    uint32_t ota_data_crc;
+    uint32_t ota_time;
+    /// Time connected, to first OTA response
+    uint32_t link_time;
 
+    uint16_t ota_pkt_idx;
+    uint16_t ota_blk_pos;
     uint16_t ota_block_size;
     uint16_t ota_pkt_size;
+    uint16_t ota_block_pkt_nb;
+
+    uint8_t  ota_fsm;
+    uint8_t  cache;
+
+    uint8_t  ota_next  : 1;
+    uint8_t  cccd_cfg  : 1;
+    uint8_t  wait_blk  : 1;
+    uint8_t  cached    : 1;
+    uint8_t  reserved  : 4;
 
-    uint32_t ota_fsm   : 8;
-    uint32_t ota_next  : 1;
-    uint32_t cccd_cfg  : 1;
-    uint32_t buff_full : 1;
-    uint32_t reserved  : 21;
+    /// Peer address, add to done list when success
+    struct gap_bdaddr peer;
 
     /// Service info:4
     struct prf_svc svc;
@@ -113,20 +152,36 @@ struct ota_env_tag
     struct prf_desc_inf descs[CHAR_IDX_MAX];
 };
 
-static struct ota_env_tag ota_env;
+/// Handles of peer, saved in GATT cache
+struct ota_hdl_map
+{
+    struct prf_svc      svc;
+    struct prf_char_inf chars[CHAR_IDX_MAX];
+    struct prf_desc_inf descs[CHAR_IDX_MAX];
+};
+
+struct ota_env_tag
+{
+    struct ota_cache_tag cache[OTA_CACHE_NB];
+    struct ota_conn_tag  conn[BLE_CONNECTION_MAX];
+
+    struct gap_bdaddr done_list[OTA_DONE_MAX];
+
+    /// Statistics since first session started
+    uint32_t start_time;
+    uint16_t done_cnt;
+    uint16_t fail_cnt;
+    uint16_t blk_load;
+    uint16_t blk_hit;
+
+    uint8_t  done_idx;
+    uint8_t  stamp;
+    uint8_t  started;
+};
 
-#define ota_fsm_sta ota_env.ota_fsm
+static struct ota_env_tag ota_env;
 
-#define ota_data_offset  ota_env.ota_bin_offset
-#define ota_data_next    ota_env.ota_next
-#define ota_total_size   ota_env.ota_remain_size
-#define ota_data_sum     ota_env.ota_data_sum
-#define ota_block_pkt_nb ota_env.ota_block_pkt_nb
-#define ota_pkt_idx      ota_env.ota_pkt_idx
-#define ota_block_size   ota_env.ota_block_size
-#define ota_pkt_size     ota_env.ota_pkt_size
-#define ota_ntf_en       ota_env.cccd_cfg
-#define ota_buff_full    ota_env.buff_full
+#define OTA_CONN(conidx)  (&ota_env.conn[conidx])
 
 // State/CMD/Head
 enum ota_info
@@ -159,26 +214,60 @@ enum ota_fsm
     OTA_END,
 };
 
+/// Any session in progress
+bool ota_is_busy(void)
+{
+    for (uint8_t i = 0; i < BLE_CONNECTION_MAX; i++)
+    {
+        if (ota_env.conn[i].ota_fsm != OTA_IDLE)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Drop blocks cached, image changed
+void ota_cache_reset(void)
+{
+    for (uint8_t i = 0; i < OTA_CACHE_NB; i++)
+    {
+        ota_env.cache[i].length = 0;
+    }
+}
+
 // Start OTA service discovery and query device info.
 void disc_ota_init(uint8_t conidx)
 {
-    memset((uint8_t *)&ota_env + BUFF_LEN, 0x00, sizeof(ota_env) - BUFF_LEN);
-    ota_total_size = OTA_DATA_LEN;
-    DEBUG("\r\ndisc start...%d, %d, %X", sizeof(ota_env), ota_total_size, OTA_DATA_STORE_POS);
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+
+    memset(conn, 0x00, sizeof(struct ota_conn_tag));
+    conn->cache           = OTA_CACHE_NONE;
+    conn->ota_remain_size = OTA_DATA_LEN;
+    conn->link_time       = ble_time_get();
+    memcpy(&conn->peer, gapc_get_bdaddr(conidx, GAPC_SMP_INFO_PEER), sizeof(struct gap_bdaddr));
+    DEBUG("\r\ndisc start(%d)...%"PRIu32", %"PRIX32, conidx, conn->ota_remain_size, OTA_DATA_STORE_POS);
 
     // Validate bin info before proceeding.
-    if ((ota_total_size == 0xFFFFFFFF) || (OTA_DATA_STORE_POS == 0xFFFFFFFF))
+    if ((conn->ota_remain_size == 0xFFFFFFFF) || (OTA_DATA_STORE_POS == 0xFFFFFFFF))
     {
         return;
     }
+
+    #if (GATT_CACHE_EN)
+    // Database Hash first, discovery skipped if handles cached, @see disc_ota_cached
+    gcache_hash_read(conidx);
+    #else
     gatt_disc(conidx, GATT_DISC_BY_UUID_SVC, 0x0001, 0xFFFF, sizeof(ota_svc_uuid), ota_svc_uuid);
+    #endif
 }
 
 void gatt_send_data(uint8_t conidx, uint16_t len, uint8_t *data)
 {
-    DEBUG("ota_fsm_sta:%d, len:%d", ota_fsm_sta, len);
+    DEBUG("ota_fsm:%d, len:%d", OTA_CONN(conidx)->ota_fsm, len);
     debugDump("send", data, len);
-    gatt_write(conidx, GATT_WRITE_NO_RESPONSE, ota_env.chars[CHAR_IDX_WR].val_hdl, data, len);
+    gatt_write(conidx, GATT_WRITE_NO_RESPONSE, OTA_CONN(conidx)->chars[CHAR_IDX_WR].val_hdl, data, len);
 }
 
 void gatt_notify_set(uint8_t conidx, uint16_t handle, bool is_enable)
@@ -193,6 +282,50 @@ void gatt_notify_get(uint8_t conidx, uint16_t handle)
     gatt_read(conidx, handle, sizeof(uint16_t));
 }
 
+#if (GATT_CACHE_EN)
+/// Database Hash read done, load handles cached or start discovery
+static void disc_ota_cached(uint8_t conidx, uint8_t status)
+{
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+    struct ota_hdl_map map;
+
+    if ((status == GATT_ERR_NO_ERROR) && gcache_load(conidx, &conn->peer, &map, sizeof(map)))
+    {
+        conn->svc = map.svc;
+        memcpy(conn->chars, map.chars, sizeof(conn->chars));
+        memcpy(conn->descs, map.descs, sizeof(conn->descs));
+        conn->cached = 1;
+
+        gatt_notify_set(conidx, conn->descs[CHAR_IDX_NTF].desc_hdl, true);
+        conn->cccd_cfg = 1;
+    }
+    else
+    {
+        DEBUG("db hash(sta:0x%X), disc all", status);
+        gatt_disc(conidx, GATT_DISC_BY_UUID_SVC, 0x0001, 0xFFFF, sizeof(ota_svc_uuid), ota_svc_uuid);
+    }
+}
+
+/// Discovery done, save handles for next connection
+static void disc_ota_save(uint8_t conidx)
+{
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+    struct ota_hdl_map map;
+
+    if ((conn->chars[CHAR_IDX_WR].val_hdl == 0) || (conn->descs[CHAR_IDX_NTF].desc_hdl == 0))
+    {
+        return;
+    }
+
+    memset(&map, 0, sizeof(map));
+    map.svc = conn->svc;
+    memcpy(map.chars, conn->chars, sizeof(map.chars));
+    memcpy(map.descs, conn->descs, sizeof(map.descs));
+
+    gcache_save(conidx, &conn->peer, &map, sizeof(map));
+}
+#endif //(GATT_CACHE_EN)
+
 // 0x3B
 __SRAMFN void flash_dread(uint32_t offset, uint32_t *buff, uint32_t wlen)
 {
@@ -208,143 +341,262 @@ __SRAMFN void flash_dread(uint32_t offset, uint32_t *buff, uint32_t wlen)
     GLOBAL_INT_RESTORE();
 }
 
-void read_flash_data(uint32_t block_len)
+/// Release block used by session
+static void ota_blk_put(struct ota_conn_tag *conn)
 {
-    uint32_t data_offset = OTA_DATA_STORE_OFFSET + ota_data_offset;
-    flash_dread(data_offset, ota_env.bin_data, block_len >> 2);
-
-    ota_data_offset += block_len;
-    ota_env.head     = 0;
-    ota_env.tail     = 0;
-    ota_buff_full    = 1; // buffer filled completely from flash
+    if (conn->cache != OTA_CACHE_NONE)
+    {
+        ota_env.cache[conn->cache].users--;
+        conn->cache = OTA_CACHE_NONE;
+    }
 }
 
-uint16_t ota_read(uint8_t *buff, uint16_t max)
+/// Get block of session's offset from cache, load the least recently used free one if missed
+static bool ota_blk_get(struct ota_conn_tag *conn)
 {
-    uint16_t head = ota_env.head;
-    uint16_t tail = ota_env.tail;
-
-    uint16_t tlen, len;
+    uint8_t idx = OTA_CACHE_NONE;
+    uint8_t age = 0;
 
-    if (ota_buff_full)
+    for (uint8_t i = 0; i < OTA_CACHE_NB; i++)
     {
-        len = ota_block_size;
-    }
-    else if (head >= tail)
-    {
-        len = head - tail;
-    }
-    else
-    {
-        len = ota_block_size - tail + head;
-    }
+        struct ota_cache_tag *blk = &ota_env.cache[i];
 
-    if (len == 0)
-    {
-        return 0; // empty
-    }
+        if ((blk->length == conn->ota_block_size) && (blk->offset == conn->ota_bin_offset))
+        {
+            ota_env.blk_hit++;
+            idx = i;
+            break;
+        }
 
-    if (len > max)
-    {
-        len = max;
+        if ((blk->users == 0) && ((idx == OTA_CACHE_NONE) || ((uint8_t)(ota_env.stamp - blk->stamp) > age)))
+        {
+            idx = i;
+            age = ota_env.stamp - blk->stamp;
+        }
     }
 
-    uint8_t *p_data = (uint8_t *)ota_env.bin_data;
-    if ((tail + len) <= ota_block_size)
+    if (idx == OTA_CACHE_NONE)
     {
-        memcpy(buff, p_data + tail, len);
+        // all blocks in use by other sessions, retry when released
+        return false;
     }
-    else
+
+    struct ota_cache_tag *blk = &ota_env.cache[idx];
+
+    if ((blk->length != conn->ota_block_size) || (blk->offset != conn->ota_bin_offset))
     {
-        tlen = ota_block_size - tail;
+        flash_dread(OTA_DATA_STORE_OFFSET + conn->ota_bin_offset, blk->bin_data, conn->ota_block_size >> 2);
 
-        memcpy(buff, p_data + tail, tlen);       // tail_len
-        memcpy(buff + tlen, p_data, len - tlen); // head_len
+        blk->offset = conn->ota_bin_offset;
+        blk->length = conn->ota_block_size;
+        ota_env.blk_load++;
     }
 
-    tail          = (tail + len) % ota_block_size;
-    ota_env.tail  = tail;
-    ota_buff_full = 0; // once data consumed, buffer is no longer full
+    blk->users++;
+    blk->stamp = ota_env.stamp++;
+
+    conn->cache   = idx;
+    conn->ota_blk_pos = 0;
+    conn->ota_bin_offset += conn->ota_block_size;
 
-    return len;        // count
+    return true;
 }
 
-void ota_send_data(uint8_t conidx)
+#if (GATT_CLI_QUE)
+void ota_send_data(uint8_t conidx);
+
+/// Data packet given to controller, refill pipelines of all sessions
+static void ota_data_cmp(uint8_t conidx, uint8_t status, uint16_t handle, const uint8_t *data, uint16_t length)
 {
-    uint16_t i;
+    (void)status;(void)handle;(void)data;(void)length;
 
-    if (app_state_get() >= APP_CONNECTED && ota_data_next)
+    for (uint8_t i = 1; i <= BLE_CONNECTION_MAX; i++)
     {
-        uint16_t pkt_len = ota_pkt_size;
-        DEBUG("idx[%d, %d], pkt_len:%d, total:%d", ota_pkt_idx, ota_block_pkt_nb, pkt_len,
-            ota_total_size);
+        ota_send_data((conidx + i) % BLE_CONNECTION_MAX);
+    }
+}
+#endif
+
+void ota_send_data(uint8_t conidx)
+{
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+
+    #if (GATT_CLI_QUE)
+    // pipelined, packets in flight as write commands budget allows
+    while ((gapc_get_conhdl(conidx) != GAP_INVALID_CONHDL) && conn->ota_next && (conn->cache != OTA_CACHE_NONE)
+           && gcli_pkt_avail() && gcli_room(conidx))
+    #else
+    if ((gapc_get_conhdl(conidx) != GAP_INVALID_CONHDL) && conn->ota_next && (conn->cache != OTA_CACHE_NONE))
+    #endif
+    {
+        uint16_t pkt_len = conn->ota_pkt_size;
+        uint16_t blk_idx = conn->ota_pkt_idx % conn->ota_block_pkt_nb;
+        DEBUG("idx[%d, %d], pkt_len:%d, total:%"PRIu32, conn->ota_pkt_idx, conn->ota_block_pkt_nb, pkt_len,
+            conn->ota_remain_size);
         static uint8_t data_pkt[BLE_MTU];
 
         data_pkt[0] = OTA_CMD_HEAD;
         data_pkt[1] = OTA_CMD_DATA_WC;
 
-        if (ota_total_size < ota_pkt_size ||
-            (ota_block_pkt_nb - 1 == (ota_pkt_idx % ota_block_pkt_nb)))
+        if (conn->ota_remain_size < conn->ota_pkt_size || (conn->ota_block_pkt_nb - 1 == blk_idx))
         {
-            pkt_len = ota_block_size - (ota_pkt_idx % ota_block_pkt_nb) * ota_pkt_size;
+            pkt_len = conn->ota_block_size - blk_idx * conn->ota_pkt_size;
 
-            if (ota_total_size < ota_pkt_size)
+            if (conn->ota_remain_size < conn->ota_pkt_size)
             {
-                pkt_len = ota_total_size;
-                DEBUG("OTA_END:%d, %d", ota_total_size, ota_pkt_size);
+                pkt_len = conn->ota_remain_size;
+                DEBUG("OTA_END:%"PRIu32", %d", conn->ota_remain_size, conn->ota_pkt_size);
             }
 
             // last packet in block. wait for ack
             data_pkt[1]   = OTA_CMD_DATA_WR;
-            ota_data_next = 0;
+            conn->ota_next = 0;
         }
 
-        write16p(data_pkt + 2, ota_pkt_idx);
+        write16p(data_pkt + 2, conn->ota_pkt_idx);
         write16p(data_pkt + 4, pkt_len);
-        ota_read(data_pkt + OTA_DATA_POS, pkt_len);
-        ota_total_size -= pkt_len;
+        memcpy(data_pkt + OTA_DATA_POS, (uint8_t *)ota_env.cache[conn->cache].bin_data + conn->ota_blk_pos, pkt_len);
+        conn->ota_blk_pos     += pkt_len;
+        conn->ota_remain_size -= pkt_len;
+        conn->ota_data_crc     = crc32_update(conn->ota_data_crc, data_pkt + OTA_DATA_POS, pkt_len);
+
+        #if (GATT_CLI_QUE)
+        struct gcli_op op =
+        {
+            .type   = GCLI_WRITE_CMD,
+            .handle = conn->chars[CHAR_IDX_WR].val_hdl,
+            .length = pkt_len + OTA_DATA_POS,
+            .value  = data_pkt, // copied when pushed
+            .cb     = ota_data_cmp,
+        };
+
+        gcli_push(conidx, &op, 1);
+        #else
+        gatt_send_data(conidx, pkt_len + OTA_DATA_POS, data_pkt);
+        #endif
+        ++conn->ota_pkt_idx;
+    }
+}
 
-        for (i = 0; i < pkt_len; ++i)
+/// Resume sessions waiting for free block
+static void ota_blk_kick(void)
+{
+    for (uint8_t i = 0; i < BLE_CONNECTION_MAX; i++)
+    {
+        struct ota_conn_tag *conn = OTA_CONN(i);
+
+        if (conn->wait_blk && ota_blk_get(conn))
         {
-            ota_data_sum += data_pkt[OTA_DATA_POS + i];
+            conn->wait_blk = 0;
+            conn->ota_next = 1;
+            ota_send_data(i);
         }
+    }
+}
 
-        gatt_send_data(conidx, pkt_len + OTA_DATA_POS, data_pkt);
-        ++ota_pkt_idx;
+/// Move session to next block and start sending, wait if no free block
+static void ota_next_block(uint8_t conidx)
+{
+    ota_blk_put(OTA_CONN(conidx));
+    OTA_CONN(conidx)->wait_blk = 1;
+
+    ota_blk_kick();
+}
+
+/// Report aggregate throughput: devices per minute since first session started
+static void ota_stat_report(uint8_t conidx)
+{
+    uint32_t now    = ble_time_get();
+    uint32_t dev_ms = BLE_HS2MS(BLE_TIME_DIFF(now, OTA_CONN(conidx)->ota_time));
+    uint32_t all_ms = BLE_HS2MS(BLE_TIME_DIFF(now, ota_env.start_time));
+    // devices per minute x100
+    uint32_t dpm100 = (all_ms >= 100) ? (ota_env.done_cnt * 60000UL / (all_ms / 100)) : 0;
+
+    (void)dev_ms;(void)dpm100;
+    OTA_STAT("cid:%d, %"PRIu32"ms, ok:%d, fail:%d, %"PRIu32".%02"PRIu32" dev/min, blk(load:%d,hit:%d)", conidx, dev_ms,
+        ota_env.done_cnt, ota_env.fail_cnt, dpm100 / 100, dpm100 % 100, ota_env.blk_load, ota_env.blk_hit);
+
+    #if (HEAP_STAT)
+    heap_stat_dump();
+    #endif
+}
+
+/// Device updated or not, skip when scanning
+bool ota_dev_done(const struct gap_bdaddr *paddr)
+{
+    for (uint8_t i = 0; i < OTA_DONE_MAX; i++)
+    {
+        if (!memcmp(&ota_env.done_list[i], paddr, sizeof(struct gap_bdaddr)))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/// Close session when disconnected
+void ota_conn_close(uint8_t conidx)
+{
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+
+    if (conn->ota_fsm != OTA_IDLE)
+    {
+        conn->ota_fsm = OTA_IDLE;
+        ota_env.fail_cnt++;
+        ota_stat_report(conidx);
     }
+
+    conn->ota_next = 0;
+    conn->wait_blk = 0;
+    ota_blk_put(conn);
+    ota_blk_kick();
 }
 
 void ota_ntf_event_proc(uint8_t conidx, const uint8_t *data, uint16_t len)
 {
     (void)len;
-    switch (ota_fsm_sta)
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+
+    switch (conn->ota_fsm)
     {
         case OTA_VER:
         {
-            ota_block_size = read16p(data + 4);
-            if (ota_block_size > BUFF_LEN)
+            // first useful response since connected
+            OTA_STAT("cid:%d, ready %dms, cached:%d", conidx,
+                (int)BLE_HS2MS(BLE_TIME_DIFF(ble_time_get(), conn->link_time)), conn->cached);
+
+            conn->ota_block_size = read16p(data + 4);
+            if (conn->ota_block_size > BUFF_LEN)
             {
-                ota_fsm_sta = OTA_IDLE;
+                conn->ota_fsm = OTA_IDLE;
                 gapc_disconnect(conidx);
                 break;
             }
-            ota_pkt_size     = read16p(data + 6) - OTA_DATA_POS;
-            if (ota_pkt_size == 0 || ota_pkt_size > ota_block_size)
+            conn->ota_pkt_size = read16p(data + 6) - OTA_DATA_POS;
+            if (conn->ota_pkt_size == 0 || conn->ota_pkt_size > conn->ota_block_size)
             {
-                ota_fsm_sta = OTA_IDLE;
+                conn->ota_fsm = OTA_IDLE;
                 gapc_disconnect(conidx);
                 break;
             }
-            ota_block_pkt_nb = ota_block_size / ota_pkt_size + 1;
+            conn->ota_block_pkt_nb = conn->ota_block_size / conn->ota_pkt_size + 1;
 
             uint32_t reset_hdl = RD_32(OTA_DATA_STORE_POS + 4);
-            DEBUG("bin_size:%d, rst_hdl:0x%X", ota_total_size, reset_hdl);
-            DEBUG("sz:%d,%d, nb:%d", ota_pkt_size, ota_block_size, ota_block_pkt_nb);
+            DEBUG("bin_size:%"PRIu32", rst_hdl:0x%"PRIX32, conn->ota_remain_size, reset_hdl);
+            DEBUG("sz:%d,%d, nb:%d", conn->ota_pkt_size, conn->ota_block_size, conn->ota_block_pkt_nb);
             uint8_t req_start[10] = { OTA_CMD_HEAD, OTA_CMD_START };
-            write32p(req_start + 2, ota_total_size);
+            write32p(req_start + 2, conn->ota_remain_size);
             write32p(req_start + 6, reset_hdl);
             gatt_send_data(conidx, sizeof(req_start), req_start);
-            ota_fsm_sta = OTA_START;
+            conn->ota_fsm  = OTA_START;
+            conn->ota_time = ble_time_get();
+
+            if (!ota_env.started)
+            {
+                ota_env.started    = 1;
+                ota_env.start_time = conn->ota_time;
+            }
 
             leds_play(LED_BUSY_BL);
         }
@@ -352,41 +604,44 @@ void ota_ntf_event_proc(uint8_t conidx, const uint8_t *data, uint16_t len)
 
         case OTA_START:
         {
-            read_flash_data(ota_block_size);
-            ota_data_next = 1;
-            ota_send_data(conidx);
-            ota_fsm_sta = OTA_WRITE_DATA;
+            conn->ota_fsm = OTA_WRITE_DATA;
+            ota_next_block(conidx);
         }
         break;
 
         case OTA_WRITE_DATA:
         {
-            DEBUG("OTA_WRITE_DATA:%d,%d,%d", ota_pkt_idx, ota_block_pkt_nb, ota_total_size);
+            DEBUG("OTA_WRITE_DATA:%d,%d,%"PRIu32, conn->ota_pkt_idx, conn->ota_block_pkt_nb, conn->ota_remain_size);
 
-            if (ota_total_size == 0)
+            if (conn->ota_remain_size == 0)
             {
-                ota_data_next = 0;
-                ota_fsm_sta   = OTA_END;
+                conn->ota_next = 0;
+                conn->ota_fsm  = OTA_END;
+                ota_blk_put(conn);
+                ota_blk_kick();
 
                 uint32_t total_len     = OTA_DATA_LEN;
                 uint8_t  req_block[10] = { OTA_CMD_HEAD, OTA_CMD_END };
                 write32p(req_block + 2, total_len);
-                write32p(req_block + 6, ota_data_sum);
+                write32p(req_block + 6, conn->ota_data_crc);
                 gatt_send_data(conidx, sizeof(req_block), req_block);
             }
             else
             {
-                read_flash_data(ota_block_size);
-                ota_data_next = 1;
-                ota_send_data(conidx);
-                ota_fsm_sta = OTA_WRITE_DATA;
+                ota_next_block(conidx);
             }
         }
         break;
 
         case OTA_END:
         {
-            ota_fsm_sta = OTA_IDLE;
+            conn->ota_fsm = OTA_IDLE;
+
+            memcpy(&ota_env.done_list[ota_env.done_idx], &conn->peer, sizeof(struct gap_bdaddr));
+            ota_env.done_idx = (ota_env.done_idx + 1) % OTA_DONE_MAX;
+            ota_env.done_cnt++;
+            ota_stat_report(conidx);
+
             gapc_disconnect(conidx);
         }
         break;
@@ -404,42 +659,48 @@ void ota_ntf_event_proc(uint8_t conidx, const uint8_t *data, uint16_t len)
  */
 static void gatt_cmp_proc(uint8_t conidx, uint8_t gatt_op)
 {
+    struct ota_conn_tag *conn = OTA_CONN(conidx);
+
     switch (gatt_op)
     {
         case GATT_MTU_EXCH:
         {
             uint8_t req_ver[] = { OTA_CMD_HEAD, OTA_CMD_VER };
             gatt_send_data(conidx, sizeof(req_ver), req_ver);
-            ota_fsm_sta = OTA_VER;
+            OTA_CONN(conidx)->ota_fsm = OTA_VER;
         }
         break;
 
         case GATT_DISC_BY_UUID_SVC:
         {
-            gatt_disc(conidx, GATT_DISC_ALL_CHAR, ota_env.svc.shdl, ota_env.svc.ehdl,
+            gatt_disc(conidx, GATT_DISC_ALL_CHAR, conn->svc.shdl, conn->svc.ehdl,
                 ATT_UUID128_LEN, NULL);
         }
         break;
 
         case GATT_DISC_ALL_CHAR:
         {
-            gatt_disc(conidx, GATT_DISC_DESC_CHAR, ota_env.chars[0].val_hdl + 1,
-                ota_env.chars[CHAR_IDX_MAX - 1].val_hdl + 1, ATT_UUID16_LEN, NULL);
+            gatt_disc(conidx, GATT_DISC_DESC_CHAR, conn->chars[0].val_hdl + 1,
+                conn->chars[CHAR_IDX_MAX - 1].val_hdl + 1, ATT_UUID16_LEN, NULL);
         }
         break;
 
         case GATT_DISC_DESC_CHAR:
         {
-            gatt_notify_set(conidx, ota_env.descs[CHAR_IDX_NTF].desc_hdl, true);
-            ota_ntf_en = 1;
+            #if (GATT_CACHE_EN)
+            disc_ota_save(conidx);
+            #endif
+
+            gatt_notify_set(conidx, conn->descs[CHAR_IDX_NTF].desc_hdl, true);
+            conn->cccd_cfg = 1;
         }
         break;
 
         case GATT_WRITE:
         {
-            if (ota_ntf_en)
+            if (conn->cccd_cfg)
             {
-                ota_ntf_en = 0;
+                conn->cccd_cfg = 0;
 
                 gatt_exmtu(conidx, BLE_MTU);
             }
@@ -457,14 +718,34 @@ APP_MSG_HANDLER(gatt_cmp_evt)
 {
     (void)msgid;(void)dest_id;
     uint8_t conidx = TASK_IDX(src_id);
+
+    #if (GATT_CLI_QUE)
+    if (gcli_cmp_evt(conidx, param))
+        return;
+    #endif
+
     // operation @see enum gatt_operation
-    DEBUG("Cmp_evt(op:%d,sta:%d, fsm:(%d,%d)\r\n", param->operation, param->status, ota_fsm_sta,
-        ota_data_next);
+    DEBUG("Cmp_evt(op:%d,sta:%d, fsm:(%d,%d)\r\n", param->operation, param->status,
+        OTA_CONN(conidx)->ota_fsm, OTA_CONN(conidx)->ota_next);
 
-    if (ota_data_next && (GATT_WRITE_NO_RESPONSE == param->operation))
+    if (OTA_CONN(conidx)->ota_next && (GATT_WRITE_NO_RESPONSE == param->operation))
     {
         ota_send_data(conidx);
     }
+    #if (GATT_CACHE_EN)
+    else if (param->operation == GATT_READ_DB_HASH)
+    {
+        disc_ota_cached(conidx, param->status);
+    }
+    else if ((param->status != GATT_ERR_NO_ERROR) && OTA_CONN(conidx)->cached && OTA_CONN(conidx)->cccd_cfg)
+    {
+        // handles cached rejected, drop them and discovery
+        gcache_drop(&OTA_CONN(conidx)->peer);
+        OTA_CONN(conidx)->cached   = 0;
+        OTA_CONN(conidx)->cccd_cfg = 0;
+        gatt_disc(conidx, GATT_DISC_BY_UUID_SVC, 0x0001, 0xFFFF, sizeof(ota_svc_uuid), ota_svc_uuid);
+    }
+    #endif
     else if (param->status == GATT_ERR_NO_ERROR)
     {
         gatt_cmp_proc(conidx, param->operation);
@@ -479,15 +760,16 @@ APP_MSG_HANDLER(gatt_mtu_changed_ind)
 
 APP_MSG_HANDLER(gatt_disc_svc_ind)
 {
-    (void)msgid;(void)dest_id;(void)src_id;
+    (void)msgid;(void)dest_id;
+    uint8_t conidx = TASK_IDX(src_id);
     DEBUG("disc_svc(shdl:%d,ehdl:%d,ulen:%d)", param->start_hdl, param->end_hdl, param->uuid_len);
     debugDump("disc_svc", param->uuid, param->uuid_len);
 
     if ((param->uuid_len == sizeof(ota_svc_uuid)) &&
         (memcmp(param->uuid, ota_svc_uuid, sizeof(ota_svc_uuid)) == 0))
     {
-        ota_env.svc.shdl = param->start_hdl;
-        ota_env.svc.ehdl = param->end_hdl;
+        OTA_CONN(conidx)->svc.shdl = param->start_hdl;
+        OTA_CONN(conidx)->svc.ehdl = param->end_hdl;
     }
 }
 
@@ -501,7 +783,8 @@ APP_MSG_HANDLER(gatt_disc_svc_incl_ind)
 
 APP_MSG_HANDLER(gatt_disc_char_ind)
 {
-    (void)msgid;(void)dest_id;(void)src_id;
+    (void)msgid;(void)dest_id;
+    struct ota_conn_tag *conn = OTA_CONN(TASK_IDX(src_id));
     DEBUG("disc_char(ahdl:%d,phdl:%d,prop:%d,ulen:%d)", param->attr_hdl, param->pointer_hdl,
         param->prop, param->uuid_len);
     debugDump("disc_char", param->uuid, param->uuid_len);
@@ -509,42 +792,58 @@ APP_MSG_HANDLER(gatt_disc_char_ind)
     if ((param->uuid_len == sizeof(ota_char_ntf)) &&
         (memcmp(param->uuid, ota_char_ntf, sizeof(ota_char_ntf)) == 0))
     {
-        ota_env.chars[CHAR_IDX_NTF].char_hdl = param->attr_hdl;
-        ota_env.chars[CHAR_IDX_NTF].val_hdl  = param->pointer_hdl;
-        ota_env.chars[CHAR_IDX_NTF].prop     = param->prop;
+        conn->chars[CHAR_IDX_NTF].char_hdl = param->attr_hdl;
+        conn->chars[CHAR_IDX_NTF].val_hdl  = param->pointer_hdl;
+        conn->chars[CHAR_IDX_NTF].prop     = param->prop;
         DEBUG("Char NTF(chdl:%d, vhdl:%d)", param->attr_hdl, param->pointer_hdl);
     }
     else if ((param->uuid_len == sizeof(ota_char_recv)) &&
              (memcmp(param->uuid, ota_char_recv, sizeof(ota_char_recv)) == 0))
     {
-        ota_env.chars[CHAR_IDX_WR].char_hdl = param->attr_hdl;
-        ota_env.chars[CHAR_IDX_WR].val_hdl  = param->pointer_hdl;
-        ota_env.chars[CHAR_IDX_WR].prop     = param->prop;
+        conn->chars[CHAR_IDX_WR].char_hdl = param->attr_hdl;
+        conn->chars[CHAR_IDX_WR].val_hdl  = param->pointer_hdl;
+        conn->chars[CHAR_IDX_WR].prop     = param->prop;
         DEBUG("Char WR(chdl:%d, vhdl:%d)", param->attr_hdl, param->pointer_hdl);
     }
 }
 
 APP_MSG_HANDLER(gatt_disc_char_desc_ind)
 {
-    (void)msgid;(void)dest_id;(void)src_id;
-    // uint8_t conidx = TASK_IDX(src_id);
+    (void)msgid;(void)dest_id;
+    struct ota_conn_tag *conn = OTA_CONN(TASK_IDX(src_id));
     DEBUG("disc_char_desc(ahdl:%d,ulen:%d)", param->attr_hdl, param->uuid_len);
     debugDump("disc_char_desc", param->uuid, param->uuid_len);
 
     if (param->uuid_len == ATT_UUID16_LEN)
     {
         if ((ATT_DESC_CLIENT_CHAR_CFG == read16p(param->uuid)) &&
-            (param->attr_hdl == (ota_env.chars[CHAR_IDX_NTF].val_hdl + 1)))
+            (param->attr_hdl == (conn->chars[CHAR_IDX_NTF].val_hdl + 1)))
         {
-            ota_env.descs[CHAR_IDX_NTF].desc_hdl = param->attr_hdl;
+            conn->descs[CHAR_IDX_NTF].desc_hdl = param->attr_hdl;
             DEBUG("desc NTF");
         }
     }
 }
 
+#if (GATT_CACHE_EN)
+APP_MSG_HANDLER(gatt_db_hash_ind)
+{
+    (void)msgid;(void)dest_id;
+    debugDump("db_hash", param->hash, GAP_KEY_LEN);
+
+    gcache_hash_ind(TASK_IDX(src_id), param->hash);
+}
+#endif //(GATT_CACHE_EN)
+
 APP_MSG_HANDLER(gatt_read_ind)
 {
     (void)msgid;(void)param;(void)dest_id;(void)src_id;
+
+    #if (GATT_CLI_QUE)
+    if (gcli_read_ind(TASK_IDX(src_id), param))
+        return;
+    #endif
+
     DEBUG("Read_ind(hdl:%d,oft:%d,len:%d)", param->handle, param->offset, param->length);
     debugDump("read_ind", param->value, param->length);
 }
@@ -553,8 +852,8 @@ APP_MSG_HANDLER(gatt_event_ind)
 {
     (void)msgid;(void)dest_id;
     uint8_t conidx = TASK_IDX(src_id);
-    DEBUG("notify(typ:%d,hdl:%d,len:%d, fsm:%d, %d)", param->type, param->handle, param->length,
-        ota_fsm_sta, ota_total_size);
+    DEBUG("notify(typ:%d,hdl:%d,len:%d, fsm:%d, %"PRIu32")", param->type, param->handle, param->length,
+        OTA_CONN(conidx)->ota_fsm, OTA_CONN(conidx)->ota_remain_size);
     debugDump("notify", param->value, param->length);
 
     if (param->length < 2) return;
@@ -646,6 +945,14 @@ APP_SUBTASK_HANDLER(gatt_msg)
         }
         break;
 
+        #if (GATT_CACHE_EN)
+        case GATT_DB_HASH_IND:
+        {
+            APP_MSG_FUNCTION(gatt_db_hash_ind);
+        }
+        break;
+        #endif //(GATT_CACHE_EN)
+
         default:
         {
             DEBUG("Unknow MsgId:%d", msgid);
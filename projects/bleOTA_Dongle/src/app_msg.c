@@ -11,6 +11,7 @@
 
 #include "app.h"
 #include "app_user.h"
+#include "ota_img.h"
 #include "drvs.h"
 #if (DBG_APP)
 #include "dbg.h"
@@ -39,7 +40,7 @@ enum app_custom_msg_id
 
 void app_init_start(void)
 {
-    if ((get_auto_conn()) && (app_state_get() < APP_CONNECTED))
+    if ((get_auto_conn()) && OTA_LINK_FREE() && !ota_img_loading())
     {
         const struct gap_bdaddr *list = scan_list_get();
         struct gap_bdaddr invalid_mac = { { {0} }, 0 };
@@ -104,6 +105,7 @@ __WEAK APP_SUBTASK_HANDLER(custom)
         uint16_t length = ke_param2msg(param)->param_len;
         DEBUG("Unknow MsgId:0x%X\r\n", msgid);
         debugHex((uint8_t *)param, length);
+        (void)length;
     }
 
     return (MSG_STATUS_FREE);
@@ -5,6 +5,13 @@
 
 #define APP_INIT_TIMEOUT 30
 
+/// Link free for one more OTA session
+#if (BLE_MULTI_CONN)
+#define OTA_LINK_FREE()  (ONE_BITS(app_env.conbits) < OTA_CONN_NB)
+#else
+#define OTA_LINK_FREE()  (app_state_get() < APP_CONNECTED)
+#endif
+
 void user_init(void);
 void user_procedure(void);
 
@@ -20,4 +27,8 @@ void init_timer_start(void);
 void ota_ok_wait_next(void);
 
 void disc_ota_init(uint8_t conidx);
+void ota_conn_close(uint8_t conidx);
+bool ota_dev_done(const struct gap_bdaddr *paddr);
+bool ota_is_busy(void);
+void ota_cache_reset(void);
 #endif // APP_USER_H
@@ -14,23 +14,56 @@
 /// System Clock(0=16MHz, 1=32MHz, 2=48MHz, 3=64MHz)
 #define SYS_CLK (1)
 
+/// Image ingest from PC via UART1, frames IMG_START/DATA/END @see ota_img.h
+#define OTA_IMG_INGEST (1)
+
+/// CRCxx length type, image(up to bank size) checked by crc32_update() in one call
+#define ulen_t         uint32_t
+
 /// Debug Mode(0=Disable, 1=via UART, 2=via RTT)
 #define DBG_MODE (1)
 
-#define DBG_UART_TXD (2) // PA02
-#define PA_UART1_TX  DBG_UART_TXD
+#if (OTA_IMG_INGEST)
+/// UART1 carries ingest responses, prints(debug, OTA_STAT and heap) moved to UART2
+#define DBG_UART_PORT (1) // UART2
+#define DBG_UART_TXD  (6) // PA06
+#define DBG_UART_RXD  (7) // PA07
+#else
+#define DBG_UART_TXD  (2) // PA02
+#endif
+
+#define PA_UART1_TX  (2) // PA02
 #define PA_UART1_RX  (3)
 
+/// UART1 for commands and image ingest(debug too if no ingest), 921600 with HW flow control
+#define DBG_UART_BAUD       BRR_DIV(921600, 32M)
+#define UART1_CONF_BAUD     BRR_DIV(921600, 32M)
+#define UART1_HWFC          (1)
+#define PA_UART1_RTS        (4) // PA04
+#define PA_UART1_CTS        (5) // PA05
+/// Ping-Pong DMA buffer, hold OTA_IMG_WIN frames of image data
+#define UART1_DMA_RBUF_SIZE (0x800)
+
+/// OTA sessions in parallel(each link a session), activities: Scan + Init + N Links
+#define OTA_CONN_NB   (4)
+
+// only large lib support more than 2 links with scan and init activities
+#define BLE_LARGELIB  (1)
+
 /// BLE Configure (Single or Multi-Connections)
 #define BLE_NB_SLAVE  (0)
-#define BLE_NB_MASTER (1)
+#define BLE_NB_MASTER (OTA_CONN_NB)
 #define BLE_ADDR      { 0x2C, 0x28, 0x08, 0x23, 0x20, 0xD2 }
 #define BLE_DEV_NAME  "BXOTA-Dongle"
 #define BLE_DEV_ICON  0x0000
 
 #define BLE_EN_SMP    (0)
 #define SCAN_ADV_NAME "BXOTA-"
-#define SCAN_NUM_MAX  (1)
+#define SCAN_NUM_MAX  (OTA_CONN_NB)
+
+/// Scan filter: name rule with recently-seen cache @see app_scan.h
+#define APP_SCAN_FILT     (1)
+#define SCAN_FILT_VAL_LEN (29)
 
 #define SFTMR_SRC (0) //(0-TMS_SysTick)
 #define BLE_MTU   (512)
@@ -38,14 +71,32 @@
 /// Profile Configure
 #define GATT_CLI (1)
 
+/// Cache handles of peer in flash, discovery skipped if Database Hash unchanged @see app_gcache.h
+#define GATT_CACHE_EN     (1)
+#define GATT_CACHE_NB     (8)
+
+/// Queue of GATT client operations, OTA data pipelined as write commands @see app_gcli.h
+#define GATT_CLI_QUE      (1)
+
+/// Heap statistics dumped after each device @see app_heap.h
+#define HEAP_STAT         (1)
+/// Wrap need link option (gnu: cmake -DHEAP_STAT_WRAP=OFF to disable, mdk: none)
+#if !defined(HEAP_STAT_WRAP)
+#define HEAP_STAT_WRAP    (1)
+#endif
+
 /// Debug Configure
 #if (DBG_MODE)
 #define DBG_APP  (1)
 #define DBG_PROC (1)
 #define DBG_ACTV (1)
+#define DBG_SCAN (0)
 #define DBG_GAPM (0)
 #define DBG_GAPC (1)
 #define DBG_GATT (0)
+#define DBG_GCACHE (0)
+#define DBG_GCLI (0)
+#define DBG_HEAP (1)
 #endif
 
 #define LED_PLAY 1
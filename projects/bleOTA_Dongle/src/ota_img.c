@@ -0,0 +1,268 @@
+/**
+ ****************************************************************************************
+ *
+ * @file ota_img.c
+ *
+ * @brief OTA Image Staging, ingest via UART and store in internal flash.
+ *
+ * Flash Layout (OTA_IMG_BASE):
+ *   +0x0000  Info sector: Magic(4B) + Length(4B) + CRC-32(4B), written after verified
+ *   +0x1000  Image data, sector erased just ahead of write pointer
+ *
+ ****************************************************************************************
+ */
+
+#include "regs.h"
+#include "drvs.h"
+#include "app.h"
+#include "app_user.h"
+#include "ota_img.h"
+#include "CRCxx.h"
+
+#if (DBG_PROC)
+#include "dbg.h"
+#define DEBUG(format, ...) debug("<%s,%d>" format "\r\n", __MODULE__, __LINE__, ##__VA_ARGS__)
+#else
+#define DEBUG(format, ...)
+#endif
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// Image programed with dongle firmware(flash tool), used when none staged
+#define OTA_BOOT_LEN          RD_32(0x18000010)
+#define OTA_BOOT_POS          RD_32(0x18000014)
+
+/// Max length of image, same as bank size of slave(prf_ota)
+#if !defined(OTA_IMG_SIZE_MAX)
+#define OTA_IMG_SIZE_MAX      (0x1C000)
+#endif
+
+#define OTA_IMG_MAGIC         (0x474D4953) // "SIMG"
+#define OTA_IMG_INFO          (OTA_IMG_BASE)
+#define OTA_IMG_DATA          (OTA_IMG_BASE + SECT_SIZE)
+
+#define PAGE_SIZE             (0x100)
+#define PAGE_WLEN             (PAGE_SIZE >> 2)
+#define SECT_SIZE             (0x1000)
+
+#if (OTA_IMG_BASE < OTA_APP_END)
+#error "OTA_IMG_BASE overlaps dongle app region"
+#endif
+
+#if (OTA_IMG_BASE < OTA_BOOT_BASE + OTA_BOOT_SIZE)
+#error "OTA_IMG_BASE overlaps boot image area"
+#endif
+
+#if (OTA_IMG_BASE % SECT_SIZE)
+#error "OTA_IMG_BASE must be aligned to SECT_SIZE"
+#endif
+
+struct ota_img_info
+{
+    uint32_t magic;
+    uint32_t length;
+    uint32_t crc;
+    uint32_t rsvd;
+};
+
+struct ota_img_env_tag
+{
+    /// Page to write, filled by frames
+    uint32_t page[PAGE_WLEN];
+
+    uint32_t size;
+    uint32_t crc;
+    /// Length received
+    uint32_t offset;
+    /// Erased area end, offset of OTA_IMG_DATA
+    uint32_t erased;
+
+    uint8_t  loading;
+};
+
+static struct ota_img_env_tag img_env;
+
+/*
+ * FUNCTIONS
+ ****************************************************************************************
+ */
+
+__SRAMFN static void img_sector_erase(uint32_t addr)
+{
+    GLOBAL_INT_DISABLE();
+
+    while (SYSCFG->ACC_CCR_BUSY);
+
+    CACHE->CCR.Word = 0;
+    CACHE->CIR.Word = BIT(CACHE_INV_ALL_POS);
+    fshc_erase(addr - FLASH_BASE, FSH_CMD_ER_SECTOR);
+    CACHE->CCR.Word = 1;
+
+    GLOBAL_INT_RESTORE();
+}
+
+__SRAMFN static void img_page_write(uint32_t addr, const uint32_t *data, uint32_t wlen)
+{
+    GLOBAL_INT_DISABLE();
+
+    while (SYSCFG->ACC_CCR_BUSY);
+
+    CACHE->CCR.Word = 0;
+    CACHE->CIR.Word = BIT(CACHE_INV_ALL_POS);
+    fshc_write(addr - FLASH_BASE, data, wlen, FSH_CMD_WR);
+    CACHE->CCR.Word = 1;
+
+    GLOBAL_INT_RESTORE();
+}
+
+/// Write filled page at offset, erase next sector when reached
+static void img_page_flush(uint32_t offset)
+{
+    if (offset >= img_env.erased)
+    {
+        img_sector_erase(OTA_IMG_DATA + img_env.erased);
+        img_env.erased += SECT_SIZE;
+    }
+
+    img_page_write(OTA_IMG_DATA + offset, img_env.page, PAGE_WLEN);
+}
+
+static const struct ota_img_info *img_info_get(void)
+{
+    const struct ota_img_info *info = (const struct ota_img_info *)OTA_IMG_INFO;
+
+    if ((info->magic == OTA_IMG_MAGIC) && (info->length != 0) && (info->length <= OTA_IMG_SIZE_MAX))
+    {
+        return info;
+    }
+
+    return NULL;
+}
+
+uint32_t ota_img_addr(void)
+{
+    return (img_info_get() != NULL) ? OTA_IMG_DATA : OTA_BOOT_POS;
+}
+
+uint32_t ota_img_len(void)
+{
+    const struct ota_img_info *info = img_info_get();
+
+    return (info != NULL) ? info->length : OTA_BOOT_LEN;
+}
+
+bool ota_img_loading(void)
+{
+    return (img_env.loading != 0);
+}
+
+uint32_t ota_img_offset(void)
+{
+    return img_env.offset;
+}
+
+uint8_t ota_img_start(uint32_t size, uint32_t crc)
+{
+    if ((size == 0) || (size > OTA_IMG_SIZE_MAX))
+    {
+        return IMG_ERR_PARAM;
+    }
+
+    // staging area end within flash, not over boot image placed by flash tool
+    if ((OTA_IMG_DATA + size > FLASH_BASE + flash_size())
+        || ((OTA_BOOT_LEN != 0xFFFFFFFF) && (OTA_BOOT_POS < OTA_IMG_DATA + size)
+            && (OTA_BOOT_POS + OTA_BOOT_LEN > OTA_IMG_INFO)))
+    {
+        DEBUG("img area err(flash:%"PRIX32")", flash_size());
+        return IMG_ERR_PARAM;
+    }
+
+    if (ota_is_busy())
+    {
+        return IMG_ERR_BUSY;
+    }
+
+    // invalid staged image, blocks cached from it also
+    img_sector_erase(OTA_IMG_INFO);
+    ota_cache_reset();
+
+    img_env.size    = size;
+    img_env.crc     = crc;
+    img_env.offset  = 0;
+    img_env.erased  = 0;
+    img_env.loading = 1;
+
+    DEBUG("img start(len:%"PRIu32", crc:%08"PRIX32")", size, crc);
+    return IMG_OK;
+}
+
+uint8_t ota_img_write(const uint8_t *data, uint16_t len)
+{
+    if (!img_env.loading)
+    {
+        return IMG_ERR_STATE;
+    }
+
+    if (img_env.offset + len > img_env.size)
+    {
+        return IMG_ERR_PARAM;
+    }
+
+    while (len > 0)
+    {
+        uint16_t pos = img_env.offset % PAGE_SIZE;
+        uint16_t cpy = PAGE_SIZE - pos;
+
+        if (cpy > len)
+        {
+            cpy = len;
+        }
+
+        memcpy((uint8_t *)img_env.page + pos, data, cpy);
+        img_env.offset += cpy;
+        data += cpy;
+        len  -= cpy;
+
+        if (pos + cpy == PAGE_SIZE)
+        {
+            img_page_flush(img_env.offset - PAGE_SIZE);
+        }
+    }
+
+    return IMG_OK;
+}
+
+uint8_t ota_img_end(void)
+{
+    if (!img_env.loading || (img_env.offset != img_env.size))
+    {
+        return IMG_ERR_STATE;
+    }
+
+    img_env.loading = 0;
+
+    uint16_t pos = img_env.offset % PAGE_SIZE;
+
+    if (pos)
+    {
+        // last page, padding 0xFF
+        memset((uint8_t *)img_env.page + pos, 0xFF, PAGE_SIZE - pos);
+        img_page_flush(img_env.offset - pos);
+    }
+
+    if (crc32_update(0, (const uint8_t *)OTA_IMG_DATA, img_env.size) != img_env.crc)
+    {
+        DEBUG("img crc fail");
+        return IMG_ERR_CRC;
+    }
+
+    struct ota_img_info info = { OTA_IMG_MAGIC, img_env.size, img_env.crc, 0xFFFFFFFF };
+
+    img_page_write(OTA_IMG_INFO, (uint32_t *)&info, sizeof(info) >> 2);
+
+    DEBUG("img done(len:%"PRIu32")", img_env.size);
+    return IMG_OK;
+}
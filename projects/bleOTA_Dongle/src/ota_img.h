@@ -0,0 +1,110 @@
+/**
+ ****************************************************************************************
+ *
+ * @file ota_img.h
+ *
+ * @brief Header file - OTA Image Staging, ingest via UART and store in flash
+ *
+ ****************************************************************************************
+ */
+
+#ifndef _OTA_IMG_H_
+#define _OTA_IMG_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/*
+ * DEFINES
+ ****************************************************************************************
+ */
+
+/// End of dongle app region(FLASH ORIGIN + LENGTH in link_xip.ld)
+#if !defined(OTA_APP_END)
+#define OTA_APP_END           (0x18004000 + 0x1C000)
+#endif
+
+/// Area of image programed with dongle firmware(flash tool DataBin), fallback one
+#if !defined(OTA_BOOT_BASE)
+#define OTA_BOOT_BASE         (0x18020000)
+#endif
+
+#if !defined(OTA_BOOT_SIZE)
+#define OTA_BOOT_SIZE         (0x1C000)
+#endif
+
+/// Staging area in internal flash: Info sector + Image data, above app and boot image,
+/// end checked with flash_size() when ingest start(512KB flash for max image)
+#if !defined(OTA_IMG_BASE)
+#define OTA_IMG_BASE          (OTA_BOOT_BASE + OTA_BOOT_SIZE)
+#endif
+
+/// Max data length of IMG_DATA frame, PC send next frame only when acked
+#if !defined(OTA_IMG_FRAME_MAX)
+#define OTA_IMG_FRAME_MAX     (512)
+#endif
+
+/// Frames in flight before ack, RX buffer must hold them(UART1_DMA_RBUF_SIZE)
+#if !defined(OTA_IMG_WIN)
+#define OTA_IMG_WIN           (2)
+#endif
+
+/// Status of response
+enum ota_img_sta
+{
+    IMG_OK        = 0x00,
+    IMG_ERR_PARAM = 0x01,
+    IMG_ERR_BUSY  = 0x02,
+    IMG_ERR_STATE = 0x03,
+    IMG_ERR_CRC   = 0x04,
+};
+
+/*
+ * FUNCTION DECLARATION
+ ****************************************************************************************
+ */
+
+/// Image to update, staged one if valid else the one programed with dongle firmware
+uint32_t ota_img_addr(void);
+uint32_t ota_img_len(void);
+
+/// Ingest in progress, don't start new OTA session
+bool ota_img_loading(void);
+
+/**
+ ****************************************************************************************
+ * @brief Start ingest, invalid current staged image.
+ *
+ * @param[in] size  Length of image
+ * @param[in] crc   CRC-32 of image
+ *
+ * @return Status @see enum ota_img_sta
+ ****************************************************************************************
+ */
+uint8_t ota_img_start(uint32_t size, uint32_t crc);
+
+/**
+ ****************************************************************************************
+ * @brief Stage data of image into flash, continue from last one.
+ *
+ * @param[in] data  Pointer of data
+ * @param[in] len   Length of data
+ *
+ * @return Status @see enum ota_img_sta
+ ****************************************************************************************
+ */
+uint8_t ota_img_write(const uint8_t *data, uint16_t len);
+
+/// Length of data staged
+uint32_t ota_img_offset(void);
+
+/**
+ ****************************************************************************************
+ * @brief Finish ingest, verify CRC-32 and commit image info.
+ *
+ * @return Status @see enum ota_img_sta
+ ****************************************************************************************
+ */
+uint8_t ota_img_end(void);
+
+#endif // _OTA_IMG_H_
@@ -15,6 +15,7 @@
 #include "uartRb.h"
 #include "sftmr.h"
 #include "app_user.h"
+#include "ota_img.h"
 
 #if (DBG_PROC)
 #include "dbg.h"
@@ -29,12 +30,18 @@
  ****************************************************************************************
  */
 
-#define BLE_MAX_LEN 64
-#define NULL_CNT    20
 #define SCAN_NAME_MAX  29  // 31 - 2
 #define SCAN_DUR_DFT   50
 
-static uint8_t  buff[BLE_MAX_LEN];
+/// Frame: cmd(1B) + len(1B) + data(nB), IMG_DATA: cmd(1B) + len(2B) + data(nB)
+#define BUFF_MAX       (3 + OTA_IMG_FRAME_MAX)
+
+/// Response: A5 5A + cmd(1B) + status(1B) + data(nB)
+#define RSP_HEAD0      0xA5
+#define RSP_HEAD1      0x5A
+#define RSP_HEAD_LEN   4
+
+static uint8_t  buff[BUFF_MAX];
 static uint16_t buff_len = 0;
 
 struct cmd_env_tag
@@ -53,8 +60,18 @@ enum
     CMD_SET_CONN_ADDR,        // +len(7) + addr(6) + addr_type(1)
     CMD_SET_AUTO,             // +len(1) + 0/1
     CMD_SET_DISCONN,          // +len(0)
+    CMD_IMG_START,            // +len(8) + size(4) + crc32(4)
+    CMD_IMG_DATA,             // +len(2B) + data(len)
+    CMD_IMG_END,              // +len(0)
 };
 
+/// Last command accepted, image frames only if ingest enabled
+#if (OTA_IMG_INGEST)
+#define CMD_LAST               CMD_IMG_END
+#else
+#define CMD_LAST               CMD_SET_DISCONN
+#endif
+
 tmr_tk_t uart_rx_to;
 #define UART_RX_TO             _MS(100)
 /// Tick timeout arrived
@@ -104,125 +121,192 @@ __STATIC_FORCEINLINE void co_bswap(uint8_t *p_val_out, const uint8_t *p_val_in,
 }
 #endif
 
-void user_procedure(void)
+static void cmd_rsp(uint8_t cmd, uint8_t sta, uint8_t len, const uint8_t *data)
 {
-    uint16_t       len;
-    static uint8_t null_cnt = 0;
-    bool           finsh    = false;
+    uint8_t rsp[RSP_HEAD_LEN + 4] = { RSP_HEAD0, RSP_HEAD1, cmd, sta };
 
-    len = uart1Rb_Read(&buff[buff_len], BLE_MAX_LEN - buff_len);
     if (len > 0)
     {
-        buff_len += len;
-        if (buff_len < BLE_MAX_LEN)
-        {
-            return; // wait full
-        }
+        memcpy(rsp + RSP_HEAD_LEN, data, len);
     }
-    else
+    uart_send(UART1_PORT, RSP_HEAD_LEN + len, rsp);
+}
+
+/// Length of whole frame, 0 if head incomplete, 0xFFFF if unknown cmd
+static uint16_t cmd_frame_len(void)
+{
+    if ((buff[0] < CMD_SET_SCAN_NAME) || (buff[0] > CMD_LAST))
     {
-        if ((buff_len > 0) && (null_cnt++ > NULL_CNT))
-        {
-            null_cnt = 0;
-        }
-        else
+        return 0xFFFF;
+    }
+
+    if (buff[0] == CMD_IMG_DATA)
+    {
+        if (buff_len < 3)
         {
-            return; // wait again
+            return 0;
         }
+
+        uint16_t dlen = read16p(buff + 1);
+        return (dlen <= OTA_IMG_FRAME_MAX) ? (3 + dlen) : 0xFFFF;
     }
 
-    if (buff_len > 1)
-    {
-        debugHex(buff, buff_len);
+    return (buff_len >= 2) ? (2 + buff[1]) : 0;
+}
+
+/// Handle one frame
+static void cmd_proc(void)
+{
+    uint8_t cmd = buff[0];
+    uint8_t len = buff[1];
 
-        uint8_t cmd = buff[0];
-        len         = buff[1];
-        switch (cmd)
+    switch (cmd)
+    {
+        case CMD_SET_SCAN_NAME:
         {
-            case CMD_SET_SCAN_NAME:
+            uint8_t name_len = buff[2];
+
+            if ((len > 0) && (name_len <= SCAN_NAME_MAX) && (name_len + 1 <= len))
             {
-                if (buff_len > 2)
-                {
-                    uint8_t name_len = buff[2];
-                    if (name_len > SCAN_NAME_MAX) break;
-                    if (buff_len >= name_len + 2)
-                    {
-                        memcpy(cmd_env.scan_name, buff + 2, name_len + 1);
-                        finsh = true;
-                        DEBUG("update scan name");
-                        app_scan_action(ACTV_START);
-                    }
-                }
+                memcpy(cmd_env.scan_name, buff + 2, name_len + 1);
+                DEBUG("update scan name");
+                app_scan_action(ACTV_START);
             }
-            break;
+        }
+        break;
 
-            case CMD_SET_SCAN_DURATION:
+        case CMD_SET_SCAN_DURATION:
+        {
+            if (len == 1)
             {
-                if ((buff_len >= 3) && (len == 1))
-                {
-                    cmd_env.scan_duration = buff[2];
-
-                    finsh = true;
-                    DEBUG("update scan duration:%d", cmd_env.scan_duration);
-                    app_scan_action(ACTV_START);
-                }
+                cmd_env.scan_duration = buff[2];
+
+                DEBUG("update scan duration:%d", cmd_env.scan_duration);
+                app_scan_action(ACTV_START);
             }
-            break;
+        }
+        break;
 
-            case CMD_SET_CONN_ADDR:
+        case CMD_SET_CONN_ADDR:
+        {
+            if (len == 7)
             {
-                if ((buff_len >= 9) && (len == 7))
-                {
-                    uint8_t local_bt[7];
+                uint8_t local_bt[7];
 #if (SWAP_BT_ORDER)
-                    co_bswap(local_bt, buff + 2, 6);
-                    local_bt[6] = buff[8];
+                co_bswap(local_bt, buff + 2, 6);
+                local_bt[6] = buff[8];
 #else
-                    memcpy(local_bt, buff + 2, 7);
+                memcpy(local_bt, buff + 2, 7);
 #endif
 
-                    cmd_env.auto_conn = 0;
-                    app_start_initiating((const struct gap_bdaddr *)local_bt);
-                    finsh = true;
-                    DEBUG("update conn_addr");
-                }
+                cmd_env.auto_conn = 0;
+                app_start_initiating((const struct gap_bdaddr *)local_bt);
+                DEBUG("update conn_addr");
             }
-            break;
+        }
+        break;
 
-            case CMD_SET_AUTO:
+        case CMD_SET_AUTO:
+        {
+            if (len > 0)
             {
-                if (buff_len > 2)
-                {
-                    cmd_env.auto_conn = buff[2];
+                cmd_env.auto_conn = buff[2];
 
-                    init_timer_start();
-                    finsh = true;
-                }
+                init_timer_start();
             }
-            break;
+        }
+        break;
 
-            case CMD_SET_DISCONN:
+        case CMD_SET_DISCONN:
+        {
+            if (app_state_get() >= APP_CONNECTED)
             {
-                if (app_state_get() >= APP_CONNECTED)
-                {
-                    gapc_disconnect(app_env.curidx);
-                }
-                cmd_env.auto_conn = 0;
-                finsh             = true;
+                gapc_disconnect(app_env.curidx);
             }
-            break;
+            cmd_env.auto_conn = 0;
+        }
+        break;
 
-            default:
+        case CMD_IMG_START:
+        {
+            uint8_t sta     = IMG_ERR_PARAM;
+            uint8_t info[3] = { OTA_IMG_WIN, (OTA_IMG_FRAME_MAX & 0xFF), (OTA_IMG_FRAME_MAX >> 8) };
+
+            if (len == 8)
             {
-                finsh = true;
+                sta = ota_img_start(read32p(buff + 2), read32p(buff + 6));
             }
-            break;
+            cmd_rsp(cmd, sta, sizeof(info), info);
+        }
+        break;
+
+        case CMD_IMG_DATA:
+        {
+            uint8_t sta = ota_img_write(buff + 3, read16p(buff + 1));
+            uint8_t offset[4];
+
+            write32p(offset, ota_img_offset());
+            cmd_rsp(cmd, sta, sizeof(offset), offset);
+        }
+        break;
+
+        case CMD_IMG_END:
+        {
+            cmd_rsp(cmd, ota_img_end(), 0, NULL);
+        }
+        break;
+
+        default:
+        {
+        }
+        break;
+    }
+}
+
+void user_procedure(void)
+{
+    uint16_t len = uart1Rb_Read(&buff[buff_len], BUFF_MAX - buff_len);
+
+    if (len > 0)
+    {
+        buff_len  += len;
+        uart_rx_to = sftmr_tick() + UART_RX_TO;
+    }
+    else if ((buff_len > 0) && (TMR_TICK_OUT(sftmr_tick(), uart_rx_to)))
+    {
+        // drop broken frame
+        buff_len = 0;
+        return;
+    }
+
+    while (buff_len > 0)
+    {
+        uint16_t flen = cmd_frame_len();
+
+        if (flen == 0)
+        {
+            break; // wait head
         }
 
-        if ((finsh) || (TMR_TICK_OUT(sftmr_tick(), uart_rx_to)))
+        if (flen <= BUFF_MAX)
         {
-            uart_rx_to = sftmr_tick() + UART_RX_TO;
-            buff_len   = 0;
+            if (buff_len < flen)
+            {
+                break; // wait full
+            }
+
+            if (buff[0] != CMD_IMG_DATA)
+            {
+                debugHex(buff, flen);
+            }
+            cmd_proc();
         }
+        else
+        {
+            flen = 1; // invalid, drop one byte to resync
+        }
+
+        buff_len -= flen;
+        memmove(buff, buff + flen, buff_len);
     }
 }
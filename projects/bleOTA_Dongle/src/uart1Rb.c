@@ -42,6 +42,10 @@
 
 #define UART1_FIFO_RXTL 8
 
+#if !defined(UART1_HWFC)
+#define UART1_HWFC 0
+#endif
+
 #ifndef CFG_UART_DMA
 #define CFG_UART_DMA 1
 #endif
@@ -53,7 +57,12 @@
 
 #include "dma.h"
 #define UART1_DMA_CHAN DMA_CH7
-#define RBUF_SIZE      (0x200)
+
+/// Ping-Pong halves, each max 1024 bytes(DMA cycles)
+#if !defined(UART1_DMA_RBUF_SIZE)
+#define UART1_DMA_RBUF_SIZE (0x200)
+#endif
+#define RBUF_SIZE      (UART1_DMA_RBUF_SIZE)
 #define RBUF_HALF_SIZE (RBUF_SIZE / 2)
 
 volatile bool pong;
@@ -155,6 +164,11 @@ void uart1Rb_Init(void)
     uart_init(UART1_PORT, PA_UART1_TX, PA_UART1_RX);
     uart_conf(UART1_PORT, UART1_CONF_BAUD, UART1_CONF_LCRS);
 
+#if (UART1_HWFC)
+    // RTS deasserted when FIFO full(DMA delayed by flash op), PC hold on
+    uart_hwfc(UART1_PORT, PA_UART1_RTS, PA_UART1_CTS);
+#endif
+
 #if (CFG_UART_DMA)
 #if (CFG_UART_CTMR)
     // Using EOB interrupt, the RXRD flag will be automatically cleared by DMA
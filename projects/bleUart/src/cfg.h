@@ -17,8 +17,20 @@
 /// Debug Mode(0=Disable, 1=via UART, 2=via RTT)
 #define DBG_MODE               (1)
 
+/// Multi-Link: serve up to 6 centrals, fan-out UART data to all links or addressed one
+/// (gnu: cmake -DBLE_MULTI_LINK=ON, mdk: replace ble6.lib with ble6_8act_6con.lib)
+#if !defined(CFG_MULTI_LINK)
+#define CFG_MULTI_LINK         (0)
+#endif
+
 /// BLE Configure (Single or Multi-Connections)
+#if (CFG_MULTI_LINK)
+// only large lib support 6 connections
+#define BLE_LARGELIB           (1)
+#define BLE_NB_SLAVE           (6)
+#else
 #define BLE_NB_SLAVE           (1)
+#endif
 #define BLE_NB_MASTER          (0)
 
 #define BLE_ADDR               {0x26, 0x08, 0x33, 0xA1, 0x01, 0xD2}
@@ -39,6 +51,30 @@
 #define SES_UUID_128           (1)
 #define SES_READ_SUP           (0)
 
+/// UART to BLE bridge: notify slices straight out of UART DMA ring, flush on RX idle
+#define CFG_BRIDGE             (0)
+
+#if (CFG_BRIDGE)
+#define SES_TXD_CMP            (1)
+#elif (CFG_MULTI_LINK)
+#define SES_TXQ_SIZE           (0x200)
+#else
+#define SES_TXQ_SIZE           (0x400)
+#endif
+
+/// UART frame of Multi-Link: 1=Head(0xA5)+Cid+Len+Data addressed, 0=raw stream to all @see proc.c
+#define MLINK_ADDR             (1)
+
+/// L2CAP Credit Based Channel: bulk stream beside SESS, used when peer opened it @see app_l2cc.h
+#define L2CC_LECB              (0)
+
+/// Tune DLE/PHY/MTU when connected, adapt connection param to workload @see app_tune.h
+#define APP_TUNE_EN            (1)
+
+/// Link statistics of each connection, read via char 0xFF04 of SESS @see app_lstat.h
+#define LINK_STAT              (1)
+#define LINK_STAT_CHAR         (1)
+
 /// Debug Configure
 #if (DBG_MODE)
     #define DBG_APP            (0)
@@ -48,6 +84,9 @@
     #define DBG_GAPC           (1)
     #define DBG_DISS           (0)
     #define DBG_SESS           (0)
+    #define DBG_TUNE           (0)
+    #define DBG_LSTAT          (1)
+    #define DBG_L2CC           (0)
 #endif
 
 /// Misc Options
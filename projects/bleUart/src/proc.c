@@ -16,6 +16,8 @@
 #include "app.h"
 #include "prf_sess.h"
 #include "uartRb.h"
+#include "app_tune.h"
+#include "app_l2cc.h"
 
 #if (DBG_PROC)
 #include "dbg.h"
@@ -43,15 +45,114 @@
 /** Command byte: enter speed test mode */
 #define CMD_SPEED_TEST              ('S')
 
+#if (L2CC_LECB) && (CFG_BRIDGE || CFG_MULTI_LINK)
+#error "L2CC_LECB only support single-link stream mode"
+#endif
+
+#if (CFG_MULTI_LINK)
+#if (CFG_BRIDGE)
+#error "CFG_BRIDGE not support CFG_MULTI_LINK"
+#endif
+
+/** Frame of UART when MLINK_ADDR: Head(1) + Cid(1) + Len(1) + Data(Len), both directions */
+#define MLINK_HEAD                  (0xA5)
+#define MLINK_HDR_LEN               (3)
+#define MLINK_DATA_MAX              (0xFF)
+
+/** Cid to all links, or query counters of links */
+#define MLINK_CID_ALL               (0xFF)
+#define MLINK_CID_STAT              (0xFE)
+
+/** Drop partial frame when no more byte, unit in half-slot(312.5us) */
+#define MLINK_FRAME_TO              (64)
+
+#if (MLINK_ADDR)
+#define UART_RX_BUF_SIZE            (MLINK_HDR_LEN + MLINK_DATA_MAX)
+#else
+#define UART_RX_BUF_SIZE            (BLE_MAX_LEN)
+#endif
+#else
+#define UART_RX_BUF_SIZE            (BLE_MAX_LEN)
+#endif /* (CFG_MULTI_LINK) */
+
+#if (CFG_BRIDGE)
+/** Slices in flight, not less than SES_NB_PKT_MAX */
+#define BRG_SLICE_MAX               (8)
+#endif /* (CFG_BRIDGE) */
+
 
 /*
  * VARIABLES
  ****************************************************************************************
  */
 
-static uint8_t  g_uart_rx_buf[BLE_MAX_LEN];
+#if !(CFG_BRIDGE)
+static uint8_t  g_uart_rx_buf[UART_RX_BUF_SIZE];
 static uint16_t g_uart_rx_len = 0;
+
+#if !(CFG_MULTI_LINK)
 static bool     g_speed_test = false;
+#else
+/** Counters of each link, reset when connected */
+struct mlink_stat
+{
+    /** Bytes queued UART -> BLE */
+    uint32_t tx_bytes;
+    /** Bytes received BLE -> UART */
+    uint32_t rx_bytes;
+    /** Frames dropped, link lost or notification disabled */
+    uint32_t drops;
+};
+
+/** Multi-link environment */
+static struct
+{
+    /** Links of pending frame not queued yet, retry when queue free */
+    uint8_t  bits;
+    /** Links known connected, find new or lost ones */
+    uint8_t  conbits;
+    /** Offset and length of pending data in g_uart_rx_buf */
+    uint8_t  pos;
+    uint16_t len;
+    /** RX idle(RTO) seen, flush partial data in raw mode */
+    bool     idle;
+    /** Time of last byte received */
+    uint32_t time;
+
+    struct mlink_stat stat[BLE_CONNECTION_MAX];
+} g_mlink;
+#endif /* !(CFG_MULTI_LINK) */
+#else
+/** Bridge statistics, time in half-slot */
+struct brg_stat
+{
+    uint32_t bytes;
+    uint32_t pkts;
+    /** First slice sent and last completed, for sustained throughput */
+    uint32_t start;
+    uint32_t last;
+    /** Worst latency, data seen in ring to its slice completed */
+    uint32_t lat_max;
+};
+
+/** Bridge environment, slices in flight: released from UART DMA ring once notify copied */
+static struct
+{
+    uint16_t len[BRG_SLICE_MAX];
+    uint32_t time[BRG_SLICE_MAX];
+    uint8_t  head;
+    uint8_t  tail;
+    /** Slices not completed, for flow control */
+    uint8_t  cnt;
+    /** Partial slice allowed, set on RX idle */
+    bool     flush;
+    /** Time of oldest data not sent */
+    uint32_t seen;
+    uint16_t seen_len;
+
+    struct brg_stat stat;
+} g_brg;
+#endif /* (CFG_BRIDGE) */
 
 
 /*
@@ -76,18 +177,345 @@ static bool     g_speed_test = false;
  */
 void sess_cb_rxd(uint8_t conidx, uint16_t len, const uint8_t *data)
 {
+    #if (CFG_MULTI_LINK)
+    g_mlink.stat[conidx].rx_bytes += len;
+
+    #if (MLINK_ADDR)
+    // Addressed by cid, split into frames
+    for (uint16_t pos = 0; pos < len; )
+    {
+        uint8_t hdr[MLINK_HDR_LEN];
+        uint16_t flen = len - pos;
+
+        if (flen > MLINK_DATA_MAX)
+        {
+            flen = MLINK_DATA_MAX;
+        }
+
+        hdr[0] = MLINK_HEAD;
+        hdr[1] = conidx;
+        hdr[2] = flen;
+        uart_send(UART1_PORT, MLINK_HDR_LEN, hdr);
+        uart_send(UART1_PORT, flen, data + pos);
+        pos += flen;
+    }
+    #else
+    uart_send(UART1_PORT, len, data);
+    #endif
+    #else
     (void)conidx;
     uart_send(UART1_PORT, len, data);
+    #endif
+
+    #if (APP_TUNE_EN)
+    app_tune_count(conidx, 0, len);
+    #endif
 }
 #endif /* !(DBG_SESS) */
 
+#if (L2CC_LECB)
+/**
+ ****************************************************************************************
+ * @brief LECB channel opened by peer, UART data goes to it instead of SESS.
+ ****************************************************************************************
+ */
+void lecb_cb_conn(uint8_t conidx, uint8_t status)
+{
+    (void)conidx;(void)status;
+    DEBUG("LECB Conn(cid:%d,sta:0x%X)", conidx, status);
+}
+
+/**
+ ****************************************************************************************
+ * @brief LECB SDU received, forwards stream to UART1.
+ ****************************************************************************************
+ */
+void lecb_cb_rxd(uint8_t conidx, uint16_t len)
+{
+    uint8_t buff[64];
+
+    (void)len;
+    while ((len = lecb_read(conidx, sizeof(buff), buff)) > 0)
+    {
+        uart_send(UART1_PORT, len, buff);
+
+        #if (APP_TUNE_EN)
+        app_tune_count(conidx, 0, len);
+        #endif
+    }
+}
+#endif /* (L2CC_LECB) */
+
+#if (CFG_MULTI_LINK)
+/**
+ ****************************************************************************************
+ * @brief Queue pending data into links of g_mlink.bits, links with queue full kept to retry.
+ ****************************************************************************************
+ */
+static void mlink_push(void)
+{
+    const uint8_t *data = &g_uart_rx_buf[g_mlink.pos];
+
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        uint8_t status;
+
+        if ((g_mlink.bits & (1 << conidx)) == 0)
+        {
+            continue;
+        }
+
+        if ((app_env.conbits & (1 << conidx)) == 0)
+        {
+            status = PRF_ERR_REQ_DISALLOWED;
+            g_mlink.bits &= ~(1 << conidx);
+        }
+        else
+        {
+            status = sess_txq_push(conidx, g_mlink.len, data);
+
+            if (status == PRF_ERR_REQ_DISALLOWED)
+            {
+                // queue full, wait next connection events
+                continue;
+            }
+
+            g_mlink.bits &= ~(1 << conidx);
+        }
+
+        if (status == LE_SUCCESS)
+        {
+            g_mlink.stat[conidx].tx_bytes += g_mlink.len;
+
+            #if (APP_TUNE_EN)
+            app_tune_count(conidx, g_mlink.len, 0);
+            #endif
+        }
+        else
+        {
+            g_mlink.stat[conidx].drops++;
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Track links connected or lost, reset or report counters.
+ ****************************************************************************************
+ */
+static void mlink_conn_check(void)
+{
+    uint8_t diff = g_mlink.conbits ^ app_env.conbits;
+
+    while (diff)
+    {
+        uint8_t conidx = co_ctz(diff);
+
+        diff &= ~(1 << conidx);
+
+        if (app_env.conbits & (1 << conidx))
+        {
+            memset(&g_mlink.stat[conidx], 0, sizeof(struct mlink_stat));
+        }
+        else
+        {
+            DEBUG("Link%d lost(tx:%"PRIu32",rx:%"PRIu32",drop:%"PRIu32")", conidx,
+                  g_mlink.stat[conidx].tx_bytes, g_mlink.stat[conidx].rx_bytes, g_mlink.stat[conidx].drops);
+        }
+    }
+
+    g_mlink.conbits = app_env.conbits;
+}
+
+#if (MLINK_ADDR)
+/**
+ ****************************************************************************************
+ * @brief Reply counters of all links: each Cid(1) + Connected(1) + Tx(4) + Rx(4) + Drops(4)
+ ****************************************************************************************
+ */
+static void mlink_stat_report(void)
+{
+    uint8_t rsp[MLINK_HDR_LEN + BLE_CONNECTION_MAX * 14];
+    uint8_t *p = &rsp[MLINK_HDR_LEN];
+
+    for (uint8_t conidx = 0; conidx < BLE_CONNECTION_MAX; conidx++)
+    {
+        *p++ = conidx;
+        *p++ = (app_env.conbits >> conidx) & 0x01;
+        write32p(p, g_mlink.stat[conidx].tx_bytes); p += 4;
+        write32p(p, g_mlink.stat[conidx].rx_bytes); p += 4;
+        write32p(p, g_mlink.stat[conidx].drops);    p += 4;
+    }
+
+    rsp[0] = MLINK_HEAD;
+    rsp[1] = MLINK_CID_STAT;
+    rsp[2] = p - &rsp[MLINK_HDR_LEN];
+    uart_send(UART1_PORT, p - rsp, rsp);
+}
+#endif /* (MLINK_ADDR) */
+
+/**
+ ****************************************************************************************
+ * @brief Process UART data for multiple links, fan-out to all or addressed one.
+ *
+ *        MLINK_ADDR=1: frame Head(0xA5) + Cid + Len + Data, Cid 0xFF to all links,
+ *                      Cid 0xFE(Len=0) to query counters; BLE data framed same way.
+ *        MLINK_ADDR=0: raw stream to all links, flushed when full or RX idle(RTO).
+ *
+ *        Frame kept until queued into each target link, UART ring holds more meanwhile.
+ ****************************************************************************************
+ */
+static void mlink_proc(void)
+{
+    mlink_conn_check();
+
+    if (g_mlink.bits)
+    {
+        mlink_push();
+
+        if (g_mlink.bits)
+        {
+            return;
+        }
+
+        g_uart_rx_len = 0;
+    }
+
+    #if (MLINK_ADDR)
+    uint32_t now = ble_time_get();
+    uint16_t need;
+
+    // read head one by one to resync, then exact frame
+    if (g_uart_rx_len < 1)
+        need = 1;
+    else if (g_uart_rx_len < MLINK_HDR_LEN)
+        need = MLINK_HDR_LEN;
+    else
+        need = MLINK_HDR_LEN + g_uart_rx_buf[2];
+
+    if (g_uart_rx_len < need)
+    {
+        uint16_t read_len = uart1Rb_Read(&g_uart_rx_buf[g_uart_rx_len], need - g_uart_rx_len);
+
+        if (read_len > 0)
+        {
+            g_mlink.time = now;
+            g_uart_rx_len += read_len;
+        }
+        else if ((g_uart_rx_len > 0) && (BLE_TIME_DIFF(now, g_mlink.time) > MLINK_FRAME_TO))
+        {
+            DEBUG("Frame timeout(len:%d)", g_uart_rx_len);
+            g_uart_rx_len = 0;
+            return;
+        }
+
+        if (g_uart_rx_buf[0] != MLINK_HEAD)
+        {
+            g_uart_rx_len = 0;
+            return;
+        }
+
+        if ((g_uart_rx_len < MLINK_HDR_LEN) || (g_uart_rx_len < MLINK_HDR_LEN + g_uart_rx_buf[2]))
+        {
+            return;
+        }
+    }
+
+    uint8_t cid = g_uart_rx_buf[1];
+
+    g_mlink.pos = MLINK_HDR_LEN;
+    g_mlink.len = g_uart_rx_buf[2];
+
+    if (cid == MLINK_CID_STAT)
+    {
+        mlink_stat_report();
+        g_mlink.bits = 0;
+    }
+    else if (cid == MLINK_CID_ALL)
+    {
+        g_mlink.bits = app_env.conbits;
+    }
+    else
+    {
+        g_mlink.bits = (cid < BLE_CONNECTION_MAX) ? (1 << cid) : 0;
+    }
+    #else
+    uint16_t read_len = uart1Rb_Read(&g_uart_rx_buf[g_uart_rx_len], BLE_MAX_LEN - g_uart_rx_len);
+
+    g_uart_rx_len += read_len;
+
+    if (uart1Rb_Idle())
+    {
+        g_mlink.idle = true;
+    }
+
+    // full, or RX idle with ring drained
+    if ((g_uart_rx_len < BLE_MAX_LEN) && !(g_mlink.idle && (uart1Rb_Len() == 0)))
+    {
+        return;
+    }
+
+    g_mlink.idle = false;
+    g_mlink.pos  = 0;
+    g_mlink.len  = g_uart_rx_len;
+    g_mlink.bits = app_env.conbits;
+    #endif
+
+    if (g_mlink.len > 0)
+    {
+        mlink_push();
+    }
+    else
+    {
+        g_mlink.bits = 0;
+    }
+
+    if (g_mlink.bits == 0)
+    {
+        g_uart_rx_len = 0;
+    }
+}
+
+#elif !(CFG_BRIDGE)
+/**
+ ****************************************************************************************
+ * @brief Send UART data of current link, via LECB if opened, otherwise SESS queue.
+ *
+ * @return true if all data accepted.
+ ****************************************************************************************
+ */
+static bool data_send(uint16_t len, const uint8_t *data)
+{
+    #if (L2CC_LECB)
+    if (lecb_is_open(app_env.curidx))
+    {
+        if (lecb_tx_avail(app_env.curidx) < len)
+        {
+            return false;
+        }
+
+        lecb_write(app_env.curidx, len, data);
+    }
+    else
+    #endif
+    if (sess_txq_push(app_env.curidx, len, data) != LE_SUCCESS)
+    {
+        return false;
+    }
+
+    #if (APP_TUNE_EN)
+    app_tune_count(app_env.curidx, len, 0);
+    #endif
+    return true;
+}
+
 /**
  ****************************************************************************************
  * @brief Process UART data: accumulate into buffer and forward to BLE.
  *
  *        Reads UART ring buffer into g_uart_rx_buf. When the buffer is full or
  *        UART has been idle for UART_IDLE_FLUSH_THRESHOLD polls, the data is
- *        sent over BLE via sess_txd_send(). Special command bytes:
+ *        queued to BLE via data_send(). Special command bytes:
  *        - CMD_DISCONNECT: disconnect BLE or reset stack
  *        - CMD_SPEED_TEST: enable speed test mode
  ****************************************************************************************
@@ -132,7 +560,7 @@ static void data_proc(void)
             g_speed_test = true;
             g_uart_rx_len = 0;
         }
-        else if (sess_txd_send(app_env.curidx, g_uart_rx_len, g_uart_rx_buf) == LE_SUCCESS)
+        else if (data_send(g_uart_rx_len, g_uart_rx_buf))
         {
             debugHex(g_uart_rx_buf, g_uart_rx_len);
             g_uart_rx_len = 0;
@@ -150,6 +578,139 @@ static void data_proc(void)
         g_uart_rx_len = 0;
     }
 }
+#else /* (CFG_BRIDGE) */
+/**
+ ****************************************************************************************
+ * @brief Reset bridge when link lost, report statistics of last link.
+ ****************************************************************************************
+ */
+static void bridge_reset(void)
+{
+    if (g_brg.stat.pkts)
+    {
+        // duration in 10ms(32 half-slots), B/s = bytes * 100 / dur
+        uint32_t dur = BLE_TIME_DIFF(g_brg.stat.last, g_brg.stat.start) >> 5;
+
+        (void)dur;
+        DEBUG("Bridge(bytes:%"PRIu32",pkts:%"PRIu32",%"PRIu32"B/s,lat_max:%"PRIu32"us)", g_brg.stat.bytes, g_brg.stat.pkts,
+              dur ? (g_brg.stat.bytes * 100 / dur) : 0, g_brg.stat.lat_max * 625 / 2);
+    }
+
+    memset(&g_brg, 0, sizeof(g_brg));
+    uart1Rb_Reset();
+}
+
+/**
+ ****************************************************************************************
+ * @brief Callback on notification completed, count oldest slice done.
+ ****************************************************************************************
+ */
+void sess_cb_cmp(uint8_t conidx, uint8_t status)
+{
+    (void)conidx; (void)status;
+
+    if (g_brg.cnt > 0)
+    {
+        uint16_t len = g_brg.len[g_brg.tail];
+        uint32_t now = ble_time_get();
+        uint32_t lat = BLE_TIME_DIFF(now, g_brg.time[g_brg.tail]);
+
+        g_brg.tail  = (g_brg.tail + 1) % BRG_SLICE_MAX;
+        g_brg.cnt--;
+
+        g_brg.stat.bytes += len;
+        g_brg.stat.pkts++;
+        g_brg.stat.last   = now;
+        #if (APP_TUNE_EN)
+        app_tune_count(conidx, len, 0);
+        #endif
+        if (lat > g_brg.stat.lat_max)
+        {
+            g_brg.stat.lat_max = lat;
+        }
+    }
+}
+
+/**
+ ****************************************************************************************
+ * @brief Bridge UART to BLE without copy: notify MTU-sized slices straight out of UART
+ *        DMA ring, released as soon as notify copied it. Partial slice flushed on RX idle(RTO).
+ ****************************************************************************************
+ */
+static void bridge_proc(void)
+{
+    if (app_state_get() != APP_CONNECTED)
+    {
+        if (g_brg.cnt || g_brg.stat.pkts || uart1Rb_Len())
+        {
+            bridge_reset();
+        }
+        return;
+    }
+
+    uint8_t  conidx  = app_env.curidx;
+    uint16_t seg_max = gatt_get_mtu(conidx) - 3;
+    uint16_t unsent  = uart1Rb_Len();
+
+    if (uart1Rb_Idle())
+    {
+        g_brg.flush = true;
+    }
+
+    if (unsent > g_brg.seen_len)
+    {
+        if (g_brg.seen_len == 0)
+        {
+            g_brg.seen = ble_time_get();
+        }
+        g_brg.seen_len = unsent;
+    }
+
+    while ((unsent > 0) && (g_brg.cnt < BRG_SLICE_MAX))
+    {
+        const uint8_t *ptr;
+        uint16_t len = uart1Rb_Peek(0, &ptr);
+
+        if (len > seg_max)
+        {
+            len = seg_max;
+        }
+
+        // wait full slice unless idle, or end of ring reached
+        if ((len < seg_max) && (len == unsent) && !g_brg.flush)
+        {
+            break;
+        }
+
+        if (sess_txd_send(conidx, len, ptr) != LE_SUCCESS)
+        {
+            break;
+        }
+
+        // payload copied by gatt_ntf_send(), give ring space back to DMA at once
+        uart1Rb_Drop(len);
+
+        if (g_brg.stat.pkts == 0 && g_brg.cnt == 0)
+        {
+            g_brg.stat.start = ble_time_get();
+        }
+
+        g_brg.len[g_brg.head]  = len;
+        g_brg.time[g_brg.head] = g_brg.seen;
+        g_brg.head = (g_brg.head + 1) % BRG_SLICE_MAX;
+        g_brg.cnt++;
+
+        unsent -= len;
+        g_brg.seen_len = unsent;
+        g_brg.seen     = ble_time_get();
+    }
+
+    if (unsent == 0)
+    {
+        g_brg.flush = false;
+    }
+}
+#endif /* (CFG_BRIDGE) */
 
 #if (CFG_SLEEP)
 /**
@@ -180,13 +741,23 @@ void user_procedure(void)
     sleep_proc();
     #endif
 
+    #if (CFG_BRIDGE)
+    bridge_proc();
+    #elif (CFG_MULTI_LINK)
+    mlink_proc();
+    #else
     data_proc();
 
     if ((app_state_get() == APP_CONNECTED) && (g_speed_test))
     {
-        if (sess_txd_send(app_env.curidx, BLE_MAX_LEN, g_uart_rx_buf) == LE_SUCCESS)
+        if (data_send(BLE_MAX_LEN, g_uart_rx_buf))
         {
             g_uart_rx_len = 0;
         }
     }
+    #endif
+
+    #if (APP_TUNE_EN)
+    app_tune_proc();
+    #endif
 }
@@ -46,35 +46,70 @@ enum cfg_chng_bits
     CFG_CHNG_RST = 0x04,
 };
 
-const AT_CMD_FORMAT_T at_cmd_head_list[CMD_CODE_MAX] =
+/// Keywords after "AT+", sorted(ASCII) for prefix walk - keep sorted when adding,
+/// checked once at init in debug build @see atCmdListCheck().
+/// Entries of same prefix are adjacent, so range [lo, hi) of table is node of trie.
+const AT_CMD_FORMAT_T at_cmd_list[] =
 {
-    [CMD_ECHO]      = {5,  5,  "AT+\r\n"          },
-    [CMD_ALL]       = {8,  8,  "AT+ALL\r\n"       },
-    [CMD_MAC_R]     = {9,  9,  "AT+MAC?\r\n"      },
-    [CMD_VER_R]     = {9,  9,  "AT+VER?\r\n"      },
-    [CMD_NAME_R]    = {14, 14, "AT+DEV_NAME?\r\n" },
-    [CMD_NAME_S]    = {12, 34, "AT+DEV_NAME="     },
-    [CMD_BAUD_R]    = {10, 10, "AT+BAUD?\r\n"     },
-    [CMD_BAUD_S]    = {8,  16, "AT+BAUD="         },
-    [CMD_DISCON_S]  = {13, 13, "AT+DISCON=1\r\n"  },
-    [CMD_SCAN_S]    = {15, 15, "AT+SCAN_BLE=1\r\n"},
-    [CMD_CON_MAC_R] = {13, 13, "AT+CON_MAC?\r\n"  },
-    [CMD_CON_MAC_S] = {11, 30, "AT+CON_MAC="      },
-    [CMD_UUIDS_R]   = {11, 11, "AT+UUIDS?\r\n"    },
-    [CMD_UUIDS_S]   = {9,  43, "AT+UUIDS="        },
-    [CMD_UUIDN_R]   = {11, 11, "AT+UUIDN?\r\n"    },
-    [CMD_UUIDN_S]   = {9,  43, "AT+UUIDN="        },
-    [CMD_UUIDW_R]   = {11, 11, "AT+UUIDW?\r\n"    },
-    [CMD_UUIDW_S]   = {9,  43, "AT+UUIDW="        },
-    [CMD_AINTVL_R]  = {12, 12, "AT+AINTVL?\r\n"   },
-    [CMD_AINTVL_S]  = {10, 16, "AT+AINTVL="       },
-    [CMD_AMDATA_R]  = {12, 12, "AT+AMDATA?\r\n"   },
-    [CMD_AMDATA_S]  = {10, 38, "AT+AMDATA="       },
-    [CMD_RENEW_S]   = {10, 10, "AT+RENEW\r\n"     },
-    [CMD_RESET_S]   = {10, 10, "AT+RESET\r\n"     },
-    [CMD_HELP]      = {9,  9,  "AT+HELP\r\n"      },
+    {CMD_ECHO,      AT_ARG_NONE,  0,  ""          },
+    {CMD_AINTVL_S,  AT_ARG_DEC,   4,  "AINTVL="   },
+    {CMD_AINTVL_R,  AT_ARG_NONE,  0,  "AINTVL?"   },
+    {CMD_ALL,       AT_ARG_NONE,  0,  "ALL"       },
+    {CMD_AMDATA_S,  AT_ARG_HEX,   30, "AMDATA="   },
+    {CMD_AMDATA_R,  AT_ARG_NONE,  0,  "AMDATA?"   },
+    {CMD_BAUD_S,    AT_ARG_DEC,   6,  "BAUD="     },
+    {CMD_BAUD_R,    AT_ARG_NONE,  0,  "BAUD?"     },
+    {CMD_CON_MAC_S, AT_ARG_HEX_R, 17, "CON_MAC="  },
+    {CMD_CON_MAC_R, AT_ARG_NONE,  0,  "CON_MAC?"  },
+    {CMD_NAME_S,    AT_ARG_STR,   20, "DEV_NAME=" },
+    {CMD_NAME_R,    AT_ARG_NONE,  0,  "DEV_NAME?" },
+    {CMD_DISCON_S,  AT_ARG_NONE,  0,  "DISCON=1"  },
+    {CMD_HELP,      AT_ARG_NONE,  0,  "HELP"      },
+    {CMD_MAC_R,     AT_ARG_NONE,  0,  "MAC?"      },
+    {CMD_RENEW_S,   AT_ARG_NONE,  0,  "RENEW"     },
+    {CMD_RESET_S,   AT_ARG_NONE,  0,  "RESET"     },
+    {CMD_SCAN_S,    AT_ARG_NONE,  0,  "SCAN_BLE=1"},
+    {CMD_UUIDN_S,   AT_ARG_HEX_R, 32, "UUIDN="    },
+    {CMD_UUIDN_R,   AT_ARG_NONE,  0,  "UUIDN?"    },
+    {CMD_UUIDS_S,   AT_ARG_HEX_R, 32, "UUIDS="    },
+    {CMD_UUIDS_R,   AT_ARG_NONE,  0,  "UUIDS?"    },
+    {CMD_UUIDW_S,   AT_ARG_HEX_R, 32, "UUIDW="    },
+    {CMD_UUIDW_R,   AT_ARG_NONE,  0,  "UUIDW?"    },
+    {CMD_VER_R,     AT_ARG_NONE,  0,  "VER?"      },
 };
 
+#define AT_CMD_NB          (sizeof(at_cmd_list) / sizeof(at_cmd_list[0]))
+
+/// Parser state
+enum at_state
+{
+    AT_ST_HEAD,                         // Matching "AT+"
+    AT_ST_KEY,                          // Walking keywords
+    AT_ST_ARG,                          // Collecting value
+    AT_ST_EOL,                          // Keyword done, wait '\n'
+    AT_ST_SKIP,                         // Line failed, wait '\n'
+    AT_ST_BIN_LEN,                      // Binary frame length
+    AT_ST_BIN_DATA,                     // Binary frame code and value
+};
+
+/// Parser environment, value converted as bytes arrive
+struct at_parser
+{
+    uint8_t state;
+    // range of keywords matched, and depth in them(chars of "AT+" when AT_ST_HEAD)
+    uint8_t lo, hi, depth;
+    // chars of text value, or bytes left of binary frame
+    uint8_t cnt;
+    // high nibble pending of hex value, 0xFF if none
+    uint8_t nib;
+    // command code, or error code when AT_ST_SKIP
+    uint8_t code;
+    bool    bad;
+    struct at_arg arg;
+};
+
+static struct at_parser at_psr;
+
 /*
  * LOCAL FUNCTION DEFINITIONS
  ****************************************************************************************
@@ -104,6 +139,23 @@ void atConfigFlashWrite(uint32_t offset, uint8_t len, const uint32_t *data)
     flash_write(offset, (uint32_t *)data, len);
 }
 
+#if (DBG_ATCMD)
+/// Halt if at_cmd_list not strictly sorted, prefix walk would miss commands silently
+static void atCmdListCheck(void)
+{
+    for (uint8_t i = 1; i < AT_CMD_NB; i++)
+    {
+        if (strcmp(at_cmd_list[i - 1].key, at_cmd_list[i].key) >= 0)
+        {
+            debug("at_cmd_list unsorted at %d:AT+%s\r\n", i, at_cmd_list[i].key);
+            while (1);
+        }
+    }
+}
+#else
+#define atCmdListCheck()
+#endif
+
 void atConfigFlashRead(void)
 {
     uint32_t config_data[SYS_CONFIG_ALIGNED4_WLEN];
@@ -122,6 +174,8 @@ void atConfigFlashRead(void)
     }
 
     at_uart_baud_cfg(UART1_PORT, sys_config.baudrate);
+
+    atCmdListCheck();
 }
 
 SYS_CONFIG sys_config =
@@ -147,77 +201,16 @@ SYS_CONFIG sys_config =
 };
 
 
-// String to number conversion
-uint32_t str2Num(const uint8_t *numStr, uint8_t iLength)
-{
-    uint32_t rtnInt = 0;
-
-    #if (__MICROLIB)
-    rtnInt = strtoul((const char *)numStr, NULL, 10);
-    #else
-    /*
-          为代码简单，在确定输入的字符串都是数字的
-          情况下，此处未做检查，否则要检查
-          numStr[i] - '0'是否在[0, 9]这个区间内
-    */
-
-    for (uint8_t  i = 0; (i < iLength) && (numStr[i] != '\0'); i++)
-    {
-        rtnInt = rtnInt * 10 + (numStr[i] - '0');
-    }
-    #endif
-
-    return rtnInt;
-}
-
 __STATIC_FORCEINLINE uint8_t co_hexstr2hex(uint8_t hex_str)
 {
-    return (hex_str <= '9') ? (hex_str - '0') :
-           ((hex_str <= 'F') ? (hex_str - 'A' + 10) : (hex_str - 'a' + 10));
-}
-
-void str2mac(const uint8_t *date)
-{
-    uint8_t j = (GAP_BD_ADDR_LEN - 1);
+    if ((hex_str >= '0') && (hex_str <= '9'))
+        return hex_str - '0';
 
-    for (uint8_t i = 0; i < 17; i++)
-    {
-        uint8_t val = co_hexstr2hex(date[i]);
+    hex_str |= 0x20; // lower case
+    if ((hex_str >= 'a') && (hex_str <= 'f'))
+        return hex_str - 'a' + 10;
 
-        if ((i % 3) == 1)
-        {
-            uint8_t prev = co_hexstr2hex(date[i - 1]);
-            sys_config.connect_mac_addr[j--] = (prev << 4) | val;
-            i++; // skip ':'
-        }
-    }
-}
-
-void hexstr2hex(uint8_t str_len, const uint8_t *hex_str, uint8_t *hex)
-{
-    for (uint8_t i = 0; i < str_len; i++)
-    {
-        uint8_t val = co_hexstr2hex(hex_str[i]);
-
-        if (i & 0x01)
-        {
-            uint8_t prev = co_hexstr2hex(hex_str[i - 1]);
-            hex[i / 2] = (prev << 4) | val;
-        }
-    }
-}
-void str2uuid(uint8_t str_len, const uint8_t *date, uint8_t *uuid)
-{
-    for (uint8_t i = 0; i < str_len; i++)
-    {
-        uint8_t val = co_hexstr2hex(date[i]);
-
-        if (i & 0x01)
-        {
-            uint8_t prev = co_hexstr2hex(date[i - 1]);
-            uuid[(str_len - i) / 2] = (prev << 4) | val;
-        }
-    }
+    return 0xFF;
 }
 
 #define debugHexB(dat, len)                   \
@@ -272,14 +265,9 @@ void printAllConfigData(void)
 
 void printATHelp(void)
 {
-    for (uint8_t idx = CMD_ECHO; idx < CMD_CODE_MAX; idx++)
+    for (uint8_t idx = 0; idx < AT_CMD_NB; idx++)
     {
-        DEBUG("%d:%s", idx, at_cmd_head_list[idx].str);
-
-        if (at_cmd_head_list[idx].str_len_min != at_cmd_head_list[idx].str_len_max)
-        {
-            DEBUG("\r\n");
-        }
+        DEBUG("%d:AT+%s\r\n", at_cmd_list[idx].code, at_cmd_list[idx].key);
     }
 }
 
@@ -309,36 +297,16 @@ void atBleTx(const uint8_t *buff, uint8_t buff_len)
     }
 }
 
-bool atProc(const uint8_t *buff, uint8_t buff_len)
+/**
+ ****************************************************************************************
+ * @brief Execute command parsed
+ *
+ * @param[in] code_idx  command code @see enum cmd_str
+ * @param[in] arg       value of command, converted already
+ ****************************************************************************************
+ */
+static void atExec(uint8_t code_idx, const struct at_arg *arg)
 {
-    uint8_t code_idx = CMD_NULL;
-
-    if (memcmp(buff, "AT+", 3) != 0)
-    {
-        return 0;
-    }
-
-    for (uint8_t idx = CMD_NULL; idx < CMD_CODE_MAX; idx++)
-    {
-        if ((at_cmd_head_list[idx].str_len_min <= buff_len) && (buff_len <= at_cmd_head_list[idx].str_len_max))
-        {
-            if (memcmp(buff, at_cmd_head_list[idx].str, at_cmd_head_list[idx].str_len_min) == 0)
-            {
-                if (at_cmd_head_list[idx].str_len_min != at_cmd_head_list[idx].str_len_max)
-                {
-                    if ((memcmp(&buff[buff_len - 2], "\r\n", 2) == 0) || (idx == CMD_AMDATA_S))
-                    {
-                        code_idx = idx;
-                    }
-                }
-                else
-                {
-                    code_idx = idx;
-                }
-            }
-        }
-    }
-
     switch (code_idx)
     {
         case CMD_NULL:
@@ -377,7 +345,7 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_NAME_S:
         {
-            uint8_t name_len = buff_len - 14; // "AT+DEV_NAME=" (12) + "\r\n" (2)
+            uint8_t name_len = arg->len;
             if (name_len > sizeof(sys_config.name))
             {
                 DEBUG("[AT]ERR[%d]\r\n", ERR_INVALID);
@@ -386,7 +354,7 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
             memset(sys_config.name, 0, sizeof(sys_config.name));
             sys_config.name_len = name_len;
-            memcpy(sys_config.name, &buff[12], sys_config.name_len);
+            memcpy(sys_config.name, arg->data, sys_config.name_len);
             DEBUG("[AT]OK %s\r\n", sys_config.name);
 
             g_cfg_change = (CFG_CHNG_SYS | CFG_CHNG_BLE);
@@ -400,7 +368,7 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_BAUD_S:
         {
-            uint32_t baud = str2Num(&buff[8], buff_len - 10);
+            uint32_t baud = arg->num;
 
             if ((4800 <= baud) && (baud <= 921600))
             {
@@ -479,7 +447,13 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_CON_MAC_S:
         {
-            str2mac(&buff[11]);
+            if (arg->len != GAP_BD_ADDR_LEN)
+            {
+                DEBUG("[AT]ERR[%d]\r\n", ERR_INVALID);
+                break;
+            }
+
+            memcpy(sys_config.connect_mac_addr, arg->data, GAP_BD_ADDR_LEN);
 
             struct gap_bdaddr peer;
 
@@ -505,12 +479,12 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_UUIDS_S:
         {
-            uint8_t id_len = (buff_len - 11) / 2;
+            uint8_t id_len = arg->len;
 
             if ((id_len == ATT_UUID16_LEN) || (id_len == ATT_UUID128_LEN))
             {
                 sys_config.uuid_len = id_len;
-                str2uuid(2 * id_len, &buff[9], sys_config.uuids);
+                memcpy(sys_config.uuids, arg->data, id_len);
 
                 DEBUG("[AT]OK\r\n");
                 g_cfg_change = (CFG_CHNG_SYS | CFG_CHNG_BLE);
@@ -531,12 +505,12 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
         case CMD_UUIDN_S:
         case CMD_UUIDW_S:
         {
-            uint8_t id_len = (buff_len - 11) / 2;
+            uint8_t id_len = arg->len;
             uint8_t *uuid_dst = (code_idx == CMD_UUIDN_S) ? sys_config.uuidn : sys_config.uuidw;
 
             if (id_len == sys_config.uuid_len)
             {
-                str2uuid(2 * id_len, &buff[9], uuid_dst);
+                memcpy(uuid_dst, arg->data, id_len);
                 DEBUG("[AT]OK\r\n");
 
                 g_cfg_change = (CFG_CHNG_SYS | CFG_CHNG_BLE);
@@ -557,7 +531,7 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_AINTVL_S:
         {
-            uint16_t value = str2Num(&buff[10], buff_len - 12);
+            uint16_t value = arg->num;
             DEBUG("value:%d\r\n", value);
             // adv intv unit 0.625
             value = (value * 8 / 5);
@@ -582,17 +556,12 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
 
         case CMD_AMDATA_S:
         {
-            uint8_t len = buff_len - 12;
+            uint8_t len = arg->len;
 
-            if (len <= 30)
+            if (len <= 15)
             {
-                if (len & 0x01)
-                {
-                    DEBUG("[AT]ERR[%d]\r\n", ERR_INVALID);
-                    break;
-                }
-                sys_config.adv_data_len = len / 2;
-                hexstr2hex(len, (buff + 10), sys_config.adv_data);
+                sys_config.adv_data_len = len;
+                memcpy(sys_config.adv_data, arg->data, len);
 
                 DEBUG("[AT]OK\r\n");
 
@@ -642,6 +611,306 @@ bool atProc(const uint8_t *buff, uint8_t buff_len)
         #endif
         NVIC_SystemReset();
     }
+}
+
+/// Line failed, report when line end
+static bool atLineFail(struct at_parser *psr, uint8_t ch, uint8_t err)
+{
+    if (ch == '\n')
+    {
+        DEBUG("[AT]ERR[%d]\r\n", err);
+        psr->state = AT_ST_HEAD;
+        psr->depth = 0;
+    }
+    else
+    {
+        psr->state = AT_ST_SKIP;
+        psr->code  = err;
+    }
+
+    return false;
+}
+
+/// Execute command of line or frame complete, then wait next
+static bool atLineDone(struct at_parser *psr)
+{
+    psr->state = AT_ST_HEAD;
+    psr->depth = 0;
+
+    if (psr->bad)
+    {
+        DEBUG("[AT]ERR[%d]\r\n", ERR_INVALID);
+        return false;
+    }
+
+    atExec(psr->code, &psr->arg);
+    return true;
+}
+
+/// Convert run of text value up to line end, state kept in locals, return chars taken
+static uint16_t atArgRun(struct at_parser *psr, const uint8_t *data, uint16_t len)
+{
+    struct at_arg *arg = &psr->arg;
+    uint8_t  type = at_cmd_list[psr->lo].arg_type;
+    uint8_t  max  = at_cmd_list[psr->lo].arg_max;
+    uint32_t num  = arg->num;
+    uint8_t  alen = arg->len;
+    uint8_t  cnt  = psr->cnt;
+    uint8_t  nib  = psr->nib;
+    bool     bad  = psr->bad;
+    uint16_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        uint8_t ch = data[i];
+
+        if (ch == '\n')
+            break;
+
+        if ((ch == '\r') || bad)
+            continue;
+
+        if (cnt++ >= max)
+        {
+            bad = true;
+        }
+        else if (type == AT_ARG_DEC)
+        {
+            if ((ch >= '0') && (ch <= '9'))
+                num = num * 10 + (ch - '0');
+            else
+                bad = true;
+        }
+        else if (type == AT_ARG_STR)
+        {
+            arg->data[alen++] = ch;
+        }
+        else if (ch != ':') // hex, MAC separator skipped
+        {
+            uint8_t val = co_hexstr2hex(ch);
+
+            if (val > 0x0F)
+                bad = true;
+            else if (nib > 0x0F)
+                nib = val;
+            else
+            {
+                arg->data[alen++] = (nib << 4) | val;
+                nib = 0xFF;
+            }
+        }
+    }
+
+    arg->num  = num;
+    arg->len  = alen;
+    psr->cnt  = cnt;
+    psr->nib  = nib;
+    psr->bad  = bad;
+    return i;
+}
+
+/// Text value complete, check and store as binary
+static void atArgEnd(struct at_parser *psr, uint8_t type)
+{
+    struct at_arg *arg = &psr->arg;
+
+    if (((type == AT_ARG_DEC) && (psr->cnt == 0)) || (psr->nib <= 0x0F))
+    {
+        psr->bad = true;
+    }
+    else if ((type == AT_ARG_HEX_R) && (arg->len > 1))
+    {
+        for (uint8_t i = 0, j = arg->len - 1; i < j; i++, j--)
+        {
+            uint8_t tmp  = arg->data[i];
+            arg->data[i] = arg->data[j];
+            arg->data[j] = tmp;
+        }
+    }
+}
+
+/// Parse one byte, return true if command executed
+static bool atParseByte(uint8_t ch)
+{
+    struct at_parser *psr = &at_psr;
+
+    switch (psr->state)
+    {
+        case AT_ST_HEAD:
+        {
+            if (ch == "AT+"[psr->depth])
+            {
+                if (++psr->depth == 3)
+                {
+                    psr->state = AT_ST_KEY;
+                    psr->depth = 0;
+                    psr->lo    = 0;
+                    psr->hi    = AT_CMD_NB;
+                }
+            }
+            #if (AT_BIN_MODE)
+            else if ((psr->depth == 0) && (ch == AT_BIN_SYNC))
+            {
+                psr->state = AT_ST_BIN_LEN;
+            }
+            #endif
+            else if ((psr->depth != 0) || ((ch != '\r') && (ch != '\n'))) // blank line ignored
+            {
+                return atLineFail(psr, ch, ERR_PROTOCOL);
+            }
+        } break;
+
+        case AT_ST_KEY:
+        {
+            const AT_CMD_FORMAT_T *cmd = &at_cmd_list[psr->lo];
+            uint8_t lo = psr->lo, hi;
+
+            if ((ch == '\r') || (ch == '\n'))
+            {
+                // keyword itself sorted first of range
+                if ((cmd->key[psr->depth] != '\0') || (cmd->arg_type != AT_ARG_NONE))
+                {
+                    return atLineFail(psr, ch, ERR_PROTOCOL);
+                }
+
+                psr->code = cmd->code;
+                psr->bad  = false;
+
+                if (ch == '\n')
+                    return atLineDone(psr);
+
+                psr->state = AT_ST_EOL;
+                break;
+            }
+
+            // narrow to child of trie node
+            while ((lo < psr->hi) && ((uint8_t)at_cmd_list[lo].key[psr->depth] < ch))
+                lo++;
+
+            for (hi = lo; (hi < psr->hi) && ((uint8_t)at_cmd_list[hi].key[psr->depth] == ch); hi++);
+
+            if (lo == hi)
+            {
+                return atLineFail(psr, ch, ERR_PROTOCOL);
+            }
+
+            psr->lo = lo;
+            psr->hi = hi;
+            psr->depth++;
+
+            cmd = &at_cmd_list[lo];
+            if ((cmd->key[psr->depth] == '\0') && (cmd->arg_type != AT_ARG_NONE))
+            {
+                psr->state = AT_ST_ARG;
+                psr->code  = cmd->code;
+                psr->cnt   = 0;
+                psr->nib   = 0xFF;
+                psr->bad   = false;
+                psr->arg.num = 0;
+                psr->arg.len = 0;
+            }
+        } break;
+
+        case AT_ST_ARG:
+        {
+            // value chars taken by atArgRun(), only line end here
+            if (!psr->bad)
+                atArgEnd(psr, at_cmd_list[psr->lo].arg_type);
+
+            return atLineDone(psr);
+        }
+
+        case AT_ST_EOL:
+        {
+            if (ch == '\n')
+                return atLineDone(psr);
+
+            if (ch != '\r')
+                return atLineFail(psr, ch, ERR_PROTOCOL);
+        } break;
+
+        case AT_ST_SKIP:
+        {
+            if (ch == '\n')
+                return atLineFail(psr, ch, psr->code);
+        } break;
+
+        #if (AT_BIN_MODE)
+        case AT_ST_BIN_LEN:
+        {
+            if ((ch == 0) || (ch > AT_ARG_MAX + 1))
+            {
+                DEBUG("[AT]ERR[%d]\r\n", ERR_PROTOCOL);
+                psr->state = AT_ST_HEAD;
+                break;
+            }
+
+            psr->state = AT_ST_BIN_DATA;
+            psr->cnt   = ch;
+            psr->code  = CMD_NULL;
+            psr->bad   = false;
+            psr->arg.num = 0;
+            psr->arg.len = 0;
+        } break;
+
+        case AT_ST_BIN_DATA:
+        {
+            struct at_arg *arg = &psr->arg;
+
+            if (psr->code == CMD_NULL)
+            {
+                psr->code = ch;
+                psr->bad  = (ch == CMD_NULL) || (ch >= CMD_CODE_MAX);
+            }
+            else
+            {
+                if (arg->len < 4)
+                    arg->num |= (uint32_t)ch << (arg->len * 8);
+
+                arg->data[arg->len++] = ch;
+            }
+
+            if (--psr->cnt == 0)
+                return atLineDone(psr);
+        } break;
+        #endif
+
+        default:
+            break;
+    }
+
+    return false;
+}
+
+uint16_t atParse(const uint8_t *data, uint16_t len)
+{
+    uint16_t nb = 0;
+
+    for (uint16_t i = 0; i < len; )
+    {
+        if (at_psr.state == AT_ST_ARG)
+        {
+            i += atArgRun(&at_psr, &data[i], len - i);
+
+            if (i == len)
+                break;
+        }
+
+        nb += atParseByte(data[i++]);
+    }
+
+    return nb;
+}
+
+void atParseReset(void)
+{
+    at_psr.state = AT_ST_HEAD;
+    at_psr.depth = 0;
+}
+
+bool atProc(const uint8_t *buff, uint8_t buff_len)
+{
+    atParseReset();
 
-    return (code_idx ? 1 : 0);
+    return (atParse(buff, buff_len) > 0);
 }
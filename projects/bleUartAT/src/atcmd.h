@@ -34,6 +34,18 @@
 /// UART port address offset
 #define UART_PORT_OFFSET                   (0x1000)
 
+/// Max bytes of command value(name, UUID128, adv data), text or binary
+#define AT_ARG_MAX                         (DEV_NAME_MAX_LEN)
+
+/// Binary command mode, frame: AT_BIN_SYNC + len + code(@see enum cmd_str) + value[len-1]
+/// Value raw as stored(number little-endian, MAC/UUID LSB first), responses as text
+#if !defined(AT_BIN_MODE)
+#define AT_BIN_MODE                        (0)
+#endif
+
+/// First byte of binary frame, never starts text command
+#define AT_BIN_SYNC                        (0xA5)
+
 /// AT command error codes
 enum err_code
 {
@@ -79,14 +91,33 @@ enum cmd_str
     CMD_CODE_MAX,
 };
 
-/// AT command format descriptor
+/// Value type of command
+enum at_arg_type
+{
+    AT_ARG_NONE,                        // No value
+    AT_ARG_DEC,                         // Decimal number
+    AT_ARG_HEX,                         // Hex string, bytes in order typed
+    AT_ARG_HEX_R,                       // Hex string MSB first(MAC, UUID), stored reversed
+    AT_ARG_STR,                         // Raw string
+};
+
+/// AT command format descriptor, keyword after "AT+"
 typedef struct at_cmd_format
 {
-    uint8_t str_len_min;
-    uint8_t str_len_max;
-    const char *str;
+    uint8_t code;                       // @see enum cmd_str
+    uint8_t arg_type;                   // @see enum at_arg_type
+    uint8_t arg_max;                    // Max chars of text value
+    const char *key;
 } AT_CMD_FORMAT_T;
 
+/// Value of command parsed
+struct at_arg
+{
+    uint32_t num;                       // AT_ARG_DEC, or first 4 bytes of binary value
+    uint8_t  len;                       // Bytes of data
+    uint8_t  data[AT_ARG_MAX];
+};
+
 /// System configuration stored in flash
 typedef struct
 {
@@ -115,6 +146,22 @@ extern SYS_CONFIG sys_config;
 
 void atConfigFlashRead(void);
 bool atProc(const uint8_t *buff, uint8_t buff_len);
+
+/**
+ ****************************************************************************************
+ * @brief Feed received bytes to AT parser, commands executed as soon as line(or binary
+ *        frame) complete, partial line kept for next call.
+ *
+ * @param[in] data  bytes received
+ * @param[in] len   number of bytes
+ *
+ * @return Number of commands executed.
+ ****************************************************************************************
+ */
+uint16_t atParse(const uint8_t *data, uint16_t len);
+
+/// Drop partial line, e.g. when UART switched to transparent mode
+void atParseReset(void);
 void atBleTx(const uint8_t *buff, uint8_t buff_len);
 
 #endif // _ATCMD_H_
@@ -62,6 +62,23 @@ void user_procedure(void)
     uint16_t len;
     bool finish = true;
 
+    if (app_state_get() != APP_CONNECTED)
+    {
+        // AT command parsed as bytes arrive, no wait for line complete
+        len = uart1Rb_Read(buff, CMD_MAX_LEN);
+        if (len > 0)
+        {
+            atParse(buff, len);
+        }
+
+        buff_len = 0;
+        null_cnt = 0;
+        return;
+    }
+
+    // transparent, partial command dropped
+    atParseReset();
+
     len = uart1Rb_Read(&buff[buff_len], CMD_MAX_LEN - buff_len);
     if (len > 0)
     {
@@ -86,15 +103,7 @@ void user_procedure(void)
         }
     }
 
-    if (app_state_get() == APP_CONNECTED)
-    {
-        atBleTx(buff, buff_len);
-    }
-    else
-    {
-        atProc(buff, buff_len);
-    }
-
+    atBleTx(buff, buff_len);
 
     if (finish)
     {
@@ -0,0 +1,168 @@
+/**
+ ****************************************************************************************
+ *
+ * @file bench.c
+ *
+ * @brief Host benchmark of bleUartAT atProc(), old(whole line) vs new(byte-at-a-time) parser.
+ *
+ * atcmd.c built as is with stubs of drivers(host/) and BLE stack(here), debug output off.
+ * mem/str routines are byte loops like the ROM's, not the host libc ones.
+ * Each command: sys_config dumped after one run from defaults(compared by run.sh),
+ * then min time of ROUNDS batches of LOOPS runs.
+ *
+ * Build and run: see run.sh
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "atcmd.h"
+#include "sftmr.h"
+
+#define ROUNDS                 (50)
+#define LOOPS                  (2000)
+
+/*
+ * STUBS
+ ****************************************************************************************
+ */
+
+UART_TypeDef host_uart[2];
+struct app_env_tag app_env;
+uint8_t scan_cnt;
+struct gap_bdaddr scan_addr_list[8];
+
+uint32_t rcc_sysclk_freq(void) { return 16000000; }
+void flash_page_erase(uint32_t offset) { (void)offset; }
+void flash_write(uint32_t offset, uint32_t *data, uint32_t wlen) { (void)offset; (void)data; (void)wlen; }
+void flash_read(uint32_t offset, uint32_t *data, uint32_t wlen) { (void)offset; memset(data, 0xFF, wlen * 4); }
+void NVIC_SystemReset(void) { }
+tmr_id_t sftmr_start(tmr_tk_t delay, tmr_cb_t cb) { (void)delay; (void)cb; return 0; }
+void sftmr_wait(tmr_tk_t delay) { (void)delay; }
+void gapm_reset(void) { }
+void gapc_disconnect(uint8_t conidx) { (void)conidx; }
+void app_scan_action(uint8_t actv_op) { (void)actv_op; }
+void app_start_initiating(const struct gap_bdaddr *paddr) { (void)paddr; }
+uint8_t sess_txd_send(uint8_t conidx, uint16_t len, const uint8_t *data) { (void)conidx; (void)len; (void)data; return 0; }
+
+struct gap_bdaddr *gapc_get_bdaddr(uint8_t conidx, uint8_t src)
+{
+    (void)conidx; (void)src;
+    return &scan_addr_list[0];
+}
+
+/// Byte loops as ROM
+void *memcpy(void *dst, const void *src, size_t n)
+{
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+
+    while (n--) *d++ = *s++;
+    return dst;
+}
+
+void *memset(void *dst, int c, size_t n)
+{
+    uint8_t *d = dst;
+
+    while (n--) *d++ = (uint8_t)c;
+    return dst;
+}
+
+int memcmp(const void *a, const void *b, size_t n)
+{
+    const uint8_t *p = a, *q = b;
+
+    for (; n; n--, p++, q++)
+    {
+        if (*p != *q) return *p - *q;
+    }
+    return 0;
+}
+
+int strcmp(const char *a, const char *b)
+{
+    while (*a && (*a == *b)) { a++; b++; }
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+/*
+ * BENCHMARK
+ ****************************************************************************************
+ */
+
+static const struct
+{
+    const char *grp;
+    const char *line;
+} cmds[] =
+{
+    { "read",   "AT+BAUD?\r\n"                                   },
+    { "read",   "AT+DEV_NAME?\r\n"                               },
+    { "read",   "AT+MAC?\r\n"                                    },
+    { "read",   "AT+VER?\r\n"                                    },
+    { "read",   "AT+AINTVL?\r\n"                                 },
+    { "read",   "AT+UUIDS?\r\n"                                  },
+    { "dec",    "AT+BAUD=57600\r\n"                              },
+    { "dec",    "AT+AINTVL=100\r\n"                              },
+    { "reject", "AT+FOO=1\r\n"                                   },
+    { "reject", "AT+BAUD=1\r\n"                                  },
+    { "reject", "AX+BAUD?\r\n"                                   },
+    { "name",   "AT+DEV_NAME=B6x-Bench\r\n"                      },
+    { "hex",    "AT+UUIDS=0000FFE000001000800000805F9B34FB\r\n"  },
+    { "hex",    "AT+UUIDN=FFE1\r\n"                              },
+    { "hex",    "AT+AMDATA=0201060303F0FF\r\n"                   },
+    { "hex",    "AT+CON_MAC=D2:01:A1:33:08:55\r\n"               },
+};
+
+#define CMD_NB  (sizeof(cmds) / sizeof(cmds[0]))
+
+static double now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    static SYS_CONFIG dft;
+
+    dft = sys_config;
+
+    for (unsigned i = 0; i < CMD_NB; i++)
+    {
+        const uint8_t *line = (const uint8_t *)cmds[i].line;
+        uint8_t len = strlen(cmds[i].line);
+        double best = 1e30;
+
+        sys_config = dft;
+        atProc(line, len);
+
+        printf("cfg %2u ", i);
+        for (unsigned k = 0; k < sizeof(sys_config); k++)
+            printf("%02X", ((uint8_t *)&sys_config)[k]);
+        printf("\n");
+
+        for (int r = 0; r < ROUNDS; r++)
+        {
+            double t0 = now_ns();
+
+            for (int n = 0; n < LOOPS; n++)
+                atProc(line, len);
+
+            double t = (now_ns() - t0) / LOOPS;
+            if (t < best)
+                best = t;
+        }
+
+        printf("ns %-6s %6.1f  %.*s\n", cmds[i].grp, best, len - 2, cmds[i].line);
+    }
+
+    return 0;
+}
@@ -0,0 +1,5 @@
+/* after project cfg.h: benchmark without debug output, @see ../run.sh */
+#undef DBG_MODE
+#define DBG_MODE               (0)
+#undef DBG_ATCMD
+#define DBG_ATCMD              (0)
@@ -0,0 +1,13 @@
+/* host stub of CMSIS compiler macros, @see ../run.sh */
+#ifndef CMSIS_COMPILER_H_
+#define CMSIS_COMPILER_H_
+
+#define __INLINE                inline
+#define __STATIC_INLINE         static inline
+#define __STATIC_FORCEINLINE    static inline __attribute__((always_inline))
+#define __WEAK                  __attribute__((weak))
+#define __PACKED                __attribute__((packed))
+#define __ALIGNED(x)            __attribute__((aligned(x)))
+#define __NO_RETURN             __attribute__((__noreturn__))
+
+#endif
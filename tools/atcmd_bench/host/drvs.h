@@ -0,0 +1,40 @@
+/* host stub of drivers, only what atcmd.c uses, @see ../run.sh */
+#ifndef DRVS_H_
+#define DRVS_H_
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <inttypes.h>
+#include <string.h>
+#include "cmsis_compiler.h"
+#include "utils.h"
+
+typedef struct
+{
+    struct { uint32_t BRWEN; } LCR;
+    uint32_t BRR;
+} UART_TypeDef;
+
+extern UART_TypeDef host_uart[2];
+
+#define UART1_BASE              ((uintptr_t)&host_uart[0])
+
+enum uart_port
+{
+    UART1_PORT                  = 0,
+    UART2_PORT                  = 1,
+};
+
+#define GLOBAL_INT_DISABLE()
+#define GLOBAL_INT_RESTORE()
+
+uint32_t rcc_sysclk_freq(void);
+void uart_send(uint8_t port, uint16_t len, const uint8_t *data);
+void uart_putc(uint8_t port, uint8_t ch);
+void flash_page_erase(uint32_t offset);
+void flash_write(uint32_t offset, uint32_t *data, uint32_t wlen);
+void flash_read(uint32_t offset, uint32_t *data, uint32_t wlen);
+void NVIC_SystemReset(void);
+
+#endif
@@ -0,0 +1 @@
+/* host stub, @see ../run.sh */
@@ -0,0 +1,37 @@
+#!/bin/sh
+# Benchmark bleUartAT atProc(): parser before f63130d(old) vs current tree(new)
+# usage: ./run.sh   (in git work tree, old atcmd.c/h taken by 'git show')
+cd "$(dirname "$0")"
+R=$(cd ../.. && pwd)
+OLD=$(mktemp -d)
+trap 'rm -rf "$OLD" bench_old bench_new' EXIT
+
+git -C "$R" show f63130d^:projects/bleUartAT/src/atcmd.c > "$OLD/atcmd.c" || exit 1
+git -C "$R" show f63130d^:projects/bleUartAT/src/atcmd.h > "$OLD/atcmd.h" || exit 1
+
+# host/ shadows driver headers; core/string.h(ARM libc) skipped, debug output off
+INC="-iquote host -iquote $R/drivers/api -iquote $R/modules/api -iquote $R/ble/api -iquote $R/ble/app \
+     -iquote $R/ble/prf -iquote $R/projects/bleUartAT/src"
+CFLAGS="-std=gnu11 -O2 -fno-builtin -D__string_h -D__MODULE__=\"atcmd\" \
+        -include $R/projects/bleUartAT/src/cfg.h -include host/bench_cfg.h"
+
+for v in old new; do
+    if [ $v = old ]; then S=$OLD; else S=$R/projects/bleUartAT/src; fi
+    cc $CFLAGS -iquote "$S" $INC -o bench_$v bench.c "$S/atcmd.c" || exit 1
+    ./bench_$v > "$OLD/$v.txt" || exit 1
+done
+
+echo "min ns per command, old -> new"
+grep '^ns' "$OLD/old.txt" | cut -c4- > "$OLD/old.ns"
+grep '^ns' "$OLD/new.txt" | cut -c4- > "$OLD/new.ns"
+paste "$OLD/old.ns" "$OLD/new.ns" | awk -F'\t' '{ split($1, a, " "); split($2, b, " ");
+    printf("  %-6s %6.1f -> %6.1f  %s\n", a[1], a[2], b[2], substr($1, index($1, a[3])));
+    n[a[1]]++; o[a[1]] += a[2]; w[a[1]] += b[2] }
+    END { printf("mean of group:"); for (g in n) printf(" %s %.0f -> %.0f,", g, o[g] / n[g], w[g] / n[g]); printf("\n") }'
+
+grep '^cfg' "$OLD/old.txt" > "$OLD/old.cfg"
+grep '^cfg' "$OLD/new.txt" > "$OLD/new.cfg"
+echo "sys_config differs after: $(diff "$OLD/old.cfg" "$OLD/new.cfg" | grep -c '^<') of $(wc -l < "$OLD/old.cfg") commands"
+diff "$OLD/old.cfg" "$OLD/new.cfg" | grep '^<' | cut -c7-8 | while read i; do
+    sed -n "$((i + 1))p" "$OLD/old.ns" | awk '{ print "  " $3 }'
+done
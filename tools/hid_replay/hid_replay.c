@@ -0,0 +1,267 @@
+/**
+ ****************************************************************************************
+ *
+ * @file hid_replay.c
+ *
+ * @brief Host replay of input trace through ble/prf/prf_hids.c, link congestion modeled.
+ *
+ * prf_hids.c built as is(bleHid_Mouse descriptors), BLE stack calls stubbed:
+ *   - gatt_ntf_send() puts notification in controller queue
+ *   - each connection event acks up to 'pkts' of them by ATTS_CMP_EVT
+ *   - peer sums mouse deltas and counts key presses of acked reports
+ * Run till all queues drained, so delivered motion compared with generated one.
+ *
+ * Build and run: see run.sh, HID_RPT_MERGE 0 for baseline.
+ *
+ ****************************************************************************************
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRF_HIDS               (1)
+#if !defined(HID_RPT_MERGE)
+#define HID_RPT_MERGE          (1)
+#endif
+#define HID_MOUSE_XY_MIN       (-248)
+#define HID_MOUSE_XY_MAX       (255)
+#define HID_MOUSE_WHEEL_MIN    (-127)
+#define HID_MOUSE_WHEEL_MAX    (127)
+
+#include "prf_hids.c"
+
+/*
+ * LINK MODEL
+ ****************************************************************************************
+ */
+
+#define CTRL_QUE_MAX           (HID_NB_PKT_MAX)
+#define NTF_LEN_MAX            (RPT_LEN_KB)
+
+struct ntf
+{
+    uint32_t time;
+    uint16_t handle;
+    uint16_t len;
+    uint8_t  val[NTF_LEN_MAX];
+};
+
+static struct ntf ctrl_que[CTRL_QUE_MAX];
+static uint8_t    ctrl_head, ctrl_cnt;
+static uint32_t   now_ms;
+
+/// Peer side
+static int64_t  peer_dx, peer_dy;
+static uint32_t peer_press, peer_ntf;
+static uint8_t  peer_kb[RPT_LEN_KB];
+static uint32_t age_max, age_sum;
+
+/*
+ * STUBS OF BLE STACK
+ ****************************************************************************************
+ */
+
+uint8_t attmdb_svc_create(uint16_t *shdl, uint8_t *cfg_flag, const struct svc_decl *svc, svc_func_t func)
+{
+    (void)cfg_flag; (void)svc; (void)func;
+    *shdl = 0x10;
+    return LE_SUCCESS;
+}
+
+uint16_t gapc_get_conhdl(uint8_t conidx)
+{
+    (void)conidx;
+    return 0;
+}
+
+void gatt_ntf_send(uint8_t conidx, uint16_t handle, uint16_t len, const uint8_t *data)
+{
+    struct ntf *n = &ctrl_que[(ctrl_head + ctrl_cnt) % CTRL_QUE_MAX];
+
+    (void)conidx;
+    if (ctrl_cnt == CTRL_QUE_MAX)
+    {
+        printf("controller queue overflow\n");
+        exit(1);
+    }
+
+    n->time   = now_ms;
+    n->handle = handle;
+    n->len    = len;
+    memcpy(n->val, data, len);
+    ctrl_cnt++;
+}
+
+void gatt_info_cfm(uint8_t conidx, uint8_t status, uint16_t handle, uint16_t length)
+{
+    (void)conidx; (void)status; (void)handle; (void)length;
+}
+
+void gatt_read_cfm(uint8_t conidx, uint8_t status, uint16_t handle, uint16_t length, const uint8_t *data)
+{
+    (void)conidx; (void)status; (void)handle; (void)length; (void)data;
+}
+
+void gatt_write_cfm(uint8_t conidx, uint8_t status, uint16_t handle)
+{
+    (void)conidx; (void)status; (void)handle;
+}
+
+const uint8_t *hid_get_report_map(uint16_t *len)
+{
+    *len = 0;
+    return NULL;
+}
+
+/*
+ * REPLAY
+ ****************************************************************************************
+ */
+
+static void peer_recv(const struct ntf *n)
+{
+    peer_ntf++;
+
+    if (n->handle == hids_get_rpt_handle(RPT_IDX_MOUSE))
+    {
+        peer_dx += (int16_t)read16p(&n->val[1]);
+        peer_dy += (int16_t)read16p(&n->val[3]);
+    }
+    else if (n->handle == hids_get_rpt_handle(RPT_IDX_KB))
+    {
+        for (uint8_t i = 2; i < RPT_LEN_KB; i++)
+        {
+            if (n->val[i] && (memchr(&peer_kb[2], n->val[i], RPT_LEN_KB - 2) == NULL))
+                peer_press++;
+        }
+        memcpy(peer_kb, n->val, RPT_LEN_KB);
+    }
+}
+
+/// Connection event: ack up to 'pkts' notifications
+static void conn_event(uint8_t pkts)
+{
+    struct atts_cmp_evt evt = { GATT_NOTIFY, LE_SUCCESS, 0 };
+
+    while (pkts-- && ctrl_cnt)
+    {
+        struct ntf *n = &ctrl_que[ctrl_head];
+        uint32_t age  = now_ms - n->time;
+
+        age_sum += age;
+        if (age > age_max)
+            age_max = age;
+
+        peer_recv(n);
+        ctrl_head = (ctrl_head + 1) % CTRL_QUE_MAX;
+        ctrl_cnt--;
+
+        hids_svc_func(0, ATTS_CMP_EVT, 0, &evt);
+    }
+}
+
+static bool queue_empty(void)
+{
+    #if (HID_RPT_MERGE)
+    return (ctrl_cnt == 0) && (hids_mrgq[0].cnt == 0);
+    #else
+    return (ctrl_cnt == 0);
+    #endif
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *fp;
+    char line[64];
+    uint32_t intv = 30, pkts = 2, next_evt;
+    uint32_t reports = 0, rejects = 0, kb_press = 0;
+    int64_t  gen_dx = 0, gen_dy = 0;
+    uint8_t  kb[RPT_LEN_KB] = {0};
+
+    if (argc < 2)
+    {
+        printf("usage: %s trace.txt [intv_ms] [pkts_per_event]\n", argv[0]);
+        return 1;
+    }
+
+    if (argc > 2) intv = atoi(argv[2]);
+    if (argc > 3) pkts = atoi(argv[3]);
+
+    fp = fopen(argv[1], "r");
+    if (fp == NULL)
+    {
+        printf("open %s fail\n", argv[1]);
+        return 1;
+    }
+
+    hids_prf_init();
+    next_evt = intv;
+
+    // trace line: "M t_ms btn dx dy wheel" or "K t_ms mod key"
+    while (fgets(line, sizeof(line), fp))
+    {
+        char type;
+        uint32_t t;
+        int a, b, c, d = 0;
+        uint8_t status;
+
+        if (sscanf(line, " %c %u %d %d %d %d", &type, &t, &a, &b, &c, &d) < 4)
+            continue;
+
+        while (next_evt <= t)
+        {
+            now_ms = next_evt;
+            conn_event(pkts);
+            next_evt += intv;
+        }
+        now_ms = t;
+
+        if (type == 'M')
+        {
+            uint8_t val[RPT_LEN_MOUSE];
+
+            val[0] = a;
+            write16p(&val[1], (uint16_t)b);
+            write16p(&val[3], (uint16_t)c);
+            val[5] = d;
+            gen_dx += b;
+            gen_dy += c;
+            status = mouse_report_send(0, val);
+        }
+        else
+        {
+            kb[0] = a;
+            kb[2] = b;
+            kb_press += (b != 0);
+            status = keybd_report_send(0, kb);
+        }
+
+        reports++;
+        rejects += (status != LE_SUCCESS);
+    }
+    fclose(fp);
+
+    // drain pending
+    while (!queue_empty())
+    {
+        now_ms = next_evt;
+        conn_event(pkts);
+        next_evt += intv;
+    }
+
+    printf("HID_RPT_MERGE %d, intv %ums, %u pkts/event\n", HID_RPT_MERGE, intv, pkts);
+    printf("  reports %u, rejected %u, notified %u\n", reports, rejects, peer_ntf);
+    printf("  motion x %lld/%lld, y %lld/%lld (delivered/generated)\n",
+           (long long)peer_dx, (long long)gen_dx, (long long)peer_dy, (long long)gen_dy);
+    printf("  key presses %u/%u\n", peer_press, kb_press);
+    printf("  controller queue age max %ums, avg %.1fms\n", age_max, peer_ntf ? (double)age_sum / peer_ntf : 0.0);
+
+    #if (HID_RPT_MERGE)
+    const struct hid_merge_stat *st = hids_merge_stat(0);
+    printf("  merge: sent %u, merged %u, forced %u, drops %u, depth_max %u\n",
+           st->sent, st->merged, st->forced, st->drops, st->depth_max);
+    #endif
+
+    return 0;
+}
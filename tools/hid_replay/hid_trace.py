@@ -0,0 +1,52 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+生成 hid_replay 输入轨迹 (固定输出, 可重复)
+
+    M t_ms btn dx dy wheel   : 鼠标报告, rate Hz
+    K t_ms mod key           : 键盘报告, 每 key_ms 交替按下/释放(key 0为释放)
+
+用法:
+    python hid_trace.py mouse_key_20s.txt [--sec 20] [--rate 250] [--key-ms 50]
+"""
+
+import argparse
+import math
+import sys
+
+
+def main():
+    parser = argparse.ArgumentParser(description='HID input trace generator')
+    parser.add_argument('out')
+    parser.add_argument('--sec', type=int, default=20, help='trace length in seconds')
+    parser.add_argument('--rate', type=int, default=250, help='mouse report rate Hz')
+    parser.add_argument('--key-ms', type=int, default=50, help='key press/release period ms')
+    args = parser.parse_args()
+
+    events = []
+    step = 1000.0 / args.rate
+    n = int(args.sec * args.rate)
+    for i in range(n):
+        t = int(i * step)
+        # circle of varying speed drifting right/down, deltas within +-20
+        a = 2 * math.pi * i / 500.0
+        v = 6 + 5 * math.sin(2 * math.pi * i / 1250.0)
+        dx = round(v * math.cos(a)) + 3
+        dy = round(v * math.sin(a)) + 1
+        events.append((t, 0, 'M %d 0 %d %d 0' % (t, dx, dy)))
+
+    for k in range(args.sec * 1000 // args.key_ms):
+        t = k * args.key_ms + 1
+        key = 0x04 + (k // 2) % 26 if (k % 2) == 0 else 0
+        events.append((t, 1, 'K %d 0 %d' % (t, key)))
+
+    events.sort()
+    with open(args.out, 'w', newline='\n') as f:
+        for e in events:
+            f.write(e[2] + '\n')
+    print('%d events -> %s' % (len(events), args.out))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,16 @@
+#!/bin/sh
+# Build hid_replay with and without HID_RPT_MERGE, replay trace over congested link
+# usage: ./run.sh [trace.txt] [intv_ms] [pkts_per_event]
+cd "$(dirname "$0")"
+R=../..
+TRACE=${1:-mouse_key_20s.txt}
+INC="-iquote $R/core -iquote $R/core/reg -iquote $R/drivers/api -iquote $R/ble/api -iquote $R/ble/app \
+     -iquote $R/ble/prf -iquote $R/projects/bleHid_Mouse/src"
+# skip core/string.h(ARM libc), host one used
+CFLAGS="-std=gnu11 -O1 -Wall -D__string_h -D__MODULE__=\"prf_hids\""
+
+for m in 0 1; do
+    cc $CFLAGS -DHID_RPT_MERGE=$m $INC -o hid_replay_$m hid_replay.c || exit 1
+    ./hid_replay_$m "$TRACE" $2 $3
+    rm -f hid_replay_$m
+done
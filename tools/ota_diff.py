@@ -0,0 +1,180 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+BxOTA 差分升级补丁工具 (OTA_MODE_DIFF, @see ble/prf/prf_ota.c)
+
+补丁为记录流, 字段均为小端:
+    0x01 Src(4) Len(2)      : 从当前运行bank偏移Src处拷贝Len字节
+    0x02 Len(2) Data(Len)   : 字面数据
+
+用法:
+    python ota_diff.py make  old.bin new.bin patch.bin   生成补丁并模拟重建校验
+    python ota_diff.py apply old.bin patch.bin out.bin   主机模拟设备端重建
+
+OTA开始命令: BinSize = len(new.bin), Mode = 0x02, 数据内容为patch.bin
+OTA结束命令: Length/CheckSum(CRC-32) 按new.bin计算
+"""
+
+import argparse
+import sys
+import zlib
+
+OP_COPY = 0x01
+OP_DATA = 0x02
+
+# same with OTA_DIFF_SRC_MAX (OTA_BANK_B_BASE - OTA_BANK_A_BASE)
+SRC_MAX = 0x1C000
+REC_MAX = 0xFFFF
+
+KEY_LEN = 8
+MIN_COPY = 16
+MAX_CAND = 64
+
+
+def match_len(old, oi, new, ni):
+    n = min(len(old) - oi, len(new) - ni)
+    k = 0
+    while k + 64 <= n and old[oi + k:oi + k + 64] == new[ni + k:ni + k + 64]:
+        k += 64
+    while k < n and old[oi + k] == new[ni + k]:
+        k += 1
+    return k
+
+
+def make_patch(old, new):
+    old = old[:SRC_MAX]
+    index = {}
+    for i in range(len(old) - KEY_LEN + 1):
+        cand = index.setdefault(old[i:i + KEY_LEN], [])
+        if len(cand) < MAX_CAND:
+            cand.append(i)
+
+    recs = []
+    lit = bytearray()
+
+    def flush_lit():
+        for p in range(0, len(lit), REC_MAX):
+            chunk = bytes(lit[p:p + REC_MAX])
+            recs.append(bytes([OP_DATA]) + len(chunk).to_bytes(2, 'little') + chunk)
+        lit.clear()
+
+    j = 0
+    hint = 0
+    while j < len(new):
+        best_len, best_src = 0, 0
+        cands = index.get(new[j:j + KEY_LEN], [])
+        # 优先尝试上一次拷贝的后续位置(代码未移动部分)
+        for src in [hint] + cands:
+            if src < len(old):
+                k = match_len(old, src, new, j)
+                if k > best_len:
+                    best_len, best_src = k, src
+
+        if best_len >= MIN_COPY:
+            flush_lit()
+            hint = best_src + best_len
+            while best_len:
+                n = min(best_len, REC_MAX)
+                recs.append(bytes([OP_COPY]) + best_src.to_bytes(4, 'little') + n.to_bytes(2, 'little'))
+                best_src += n
+                best_len -= n
+                j += n
+        else:
+            lit.append(new[j])
+            hint += 1
+            j += 1
+
+    flush_lit()
+    return b''.join(recs)
+
+
+def apply_patch(old, patch, pkt_len=244):
+    """Streaming apply, mirror of ota_diff_apply() fed by pkt_len chunks"""
+    out = bytearray()
+    hdr = bytearray()
+    remain = 0
+
+    for p in range(0, len(patch), pkt_len):
+        data = patch[p:p + pkt_len]
+        i = 0
+        while i < len(data):
+            if remain:
+                n = min(remain, len(data) - i)
+                out += data[i:i + n]
+                remain -= n
+                i += n
+                continue
+
+            hdr.append(data[i])
+            i += 1
+            if hdr[0] == OP_COPY:
+                if len(hdr) < 7:
+                    continue
+                src = int.from_bytes(hdr[1:5], 'little')
+                n = int.from_bytes(hdr[5:7], 'little')
+                if src + n > min(len(old), SRC_MAX):
+                    raise ValueError('COPY out of range: src=0x%X len=%d' % (src, n))
+                out += old[src:src + n]
+            elif hdr[0] == OP_DATA:
+                if len(hdr) < 3:
+                    continue
+                remain = int.from_bytes(hdr[1:3], 'little')
+            else:
+                raise ValueError('Invalid record 0x%02X at patch offset %d' % (hdr[0], p + i - 1))
+            hdr.clear()
+
+    if hdr or remain:
+        raise ValueError('Truncated patch')
+    return bytes(out)
+
+
+def read_file(path):
+    with open(path, 'rb') as f:
+        return f.read()
+
+
+def write_file(path, data):
+    with open(path, 'wb') as f:
+        f.write(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BxOTA diff patch tool')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    mk = sub.add_parser('make', help='generate patch from old/new bin')
+    mk.add_argument('old')
+    mk.add_argument('new')
+    mk.add_argument('patch')
+
+    ap = sub.add_parser('apply', help='rebuild new bin from old bin and patch')
+    ap.add_argument('old')
+    ap.add_argument('patch')
+    ap.add_argument('out')
+    ap.add_argument('--pkt', type=int, default=244, help='packet payload length to simulate')
+
+    args = parser.parse_args()
+
+    if args.cmd == 'make':
+        old, new = read_file(args.old), read_file(args.new)
+        patch = make_patch(old, new)
+
+        # 模拟设备端重建, 确认补丁正确
+        if apply_patch(old, patch) != new:
+            print('ERROR: patch verify failed')
+            return 1
+
+        write_file(args.patch, patch)
+        print('old: %d, new: %d, patch: %d (%.1f%%)' % (len(old), len(new), len(patch),
+                                                      100.0 * len(patch) / max(len(new), 1)))
+        print('BinSize: 0x%08X, CheckSum: 0x%08X' % (len(new), zlib.crc32(new)))
+    else:
+        out = apply_patch(read_file(args.old), read_file(args.patch), args.pkt)
+        write_file(args.out, out)
+        print('out: %d, CheckSum: 0x%08X' % (len(out), zlib.crc32(out)))
+
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+BxOTA Flash时间模型, 主机估算擦写耗时 (无需设备)
+
+erase: 从机OTA擦除策略 (@see ble/prf/prf_ota.c ota_page_write)
+    old  开始命令内擦除整个区域后才回复 (loader: 2个64KB块, A/B: 逐4KB扇区)
+    lazy 写入前才擦除, 64KB块完整属于镜像(loader为bankB)时块擦除, 否则扇区擦除
+
+copy: loader拷贝镜像到运行区 (@see examples/loader/src/main.c ota_copy)
+    old  逐页读出/页擦除/写入
+    sect 按4KB扇区比较, 相同跳过; 64KB块全部改变时块擦除, 尾扇区只擦镜像所占页
+
+时间参数为典型值(可用参数修改), 擦除/编程与链路传输串行计算
+
+用法:
+    python ota_flash_model.py erase [--size 40 100 128] [--link 20]
+    python ota_flash_model.py copy  [--size 128]
+"""
+
+import argparse
+import sys
+
+FLASH_SIZE = 0x40000
+PAGE_SIZE = 0x100
+SECT_SIZE = 0x1000
+BLOCK_SIZE = 0x10000
+BLOCK_SECTORS = BLOCK_SIZE // SECT_SIZE
+
+# same with OTA_BANK_A_BASE/OTA_BANK_B_BASE - FLASH_BASE
+BANK_A = 0x04000
+BANK_B = 0x20000
+
+
+class Flash:
+    def __init__(self, args):
+        self.t_sect = args.sect
+        self.t_block = args.block
+        self.t_prog = args.prog
+        self.t_page = args.page
+        self.t_read = args.read
+        self.t_cmp = args.cmp
+        self.t_mark = args.mark
+
+
+def ota_erase_old(fl, bank, size, loader):
+    """Erase time of OTA_CMD_START before this change"""
+    if loader:
+        return 2 * fl.t_block
+    sects = (size + SECT_SIZE - 1) // SECT_SIZE
+    return sects * fl.t_sect
+
+
+def ota_erase_lazy(fl, bank, size, loader):
+    """Erase time spread in write path, mirror of ota_page_write()"""
+    blk_lmt = FLASH_SIZE if loader else bank + size
+    er_pos = bank & ~(SECT_SIZE - 1)
+    end = bank + ((size + PAGE_SIZE - 1) // PAGE_SIZE) * PAGE_SIZE
+    t = 0
+    while er_pos < end:
+        if (er_pos % BLOCK_SIZE) == 0 and er_pos + BLOCK_SIZE <= blk_lmt:
+            t += fl.t_block
+            er_pos += BLOCK_SIZE
+        else:
+            t += fl.t_sect
+            er_pos += SECT_SIZE
+    return t
+
+
+def cmd_erase(args):
+    fl = Flash(args)
+    print('%-14s %22s %22s' % ('image', 'old ack / total', 'lazy ack / total'))
+    for kb in args.size:
+        size = kb * 1024
+        link = size * 1000.0 / (args.link * 1024)
+        prog = ((size + PAGE_SIZE - 1) // PAGE_SIZE) * fl.t_prog
+        # loader mode stores in bankB, A/B mode writes the bank not running
+        for name, bank, limit, loader in (('loader', BANK_B, FLASH_SIZE, True),
+                                          ('A/B->A', BANK_A, BANK_B, False),
+                                          ('A/B->B', BANK_B, FLASH_SIZE, False)):
+            if bank + size > limit:
+                continue
+            old = ota_erase_old(fl, bank, size, loader)
+            lazy = ota_erase_lazy(fl, bank, size, loader)
+            print('%3dKB %-8s %8.0fms / %7.0fms %8.0fms / %7.0fms' % (
+                kb, name, old, old + link + prog, 0, lazy + link + prog))
+    return 0
+
+
+def copy_old(fl, size):
+    """Page by page: read, page erase, write"""
+    pages = (size + PAGE_SIZE - 1) // PAGE_SIZE
+    return pages * (fl.t_read + fl.t_page + fl.t_prog), '%d page erases' % pages
+
+
+def copy_sect(fl, run, size, changed):
+    """Mirror of ota_copy(), changed[i] True if sector i differs from run region"""
+    nb_sect = (size + SECT_SIZE - 1) // SECT_SIZE
+    tail = ((size - 1) % SECT_SIZE + PAGE_SIZE) & ~(PAGE_SIZE - 1)
+    t = 0
+    n_sect = n_page = n_block = 0
+    sect = 0
+
+    def write(length):
+        pages = length // PAGE_SIZE
+        return pages * (fl.t_read + fl.t_prog)
+
+    while sect < nb_sect:
+        dst = run + sect * SECT_SIZE
+        length = tail if sect == nb_sect - 1 else SECT_SIZE
+        nb = 1
+
+        if (dst % BLOCK_SIZE) == 0 and sect + BLOCK_SECTORS <= nb_sect \
+                and (sect + BLOCK_SECTORS < nb_sect or tail == SECT_SIZE):
+            while nb < BLOCK_SECTORS and changed[sect + nb]:
+                nb += 1
+            # identical sector read through till end, changed one exits at once
+            if nb < BLOCK_SECTORS:
+                t += fl.t_cmp
+            nb = BLOCK_SECTORS if (nb == BLOCK_SECTORS and changed[sect]) else 1
+
+        if nb == BLOCK_SECTORS:
+            t += fl.t_block + write(BLOCK_SIZE)
+            n_block += 1
+        elif changed[sect]:
+            if length == SECT_SIZE:
+                t += fl.t_sect
+                n_sect += 1
+            else:
+                t += (length // PAGE_SIZE) * fl.t_page
+                n_page += length // PAGE_SIZE
+            t += write(length)
+        else:
+            t += fl.t_cmp
+
+        t += nb * fl.t_mark
+        sect += nb
+
+    info = []
+    for n, name in ((n_sect, 'sector'), (n_block, 'block'), (n_page, 'page')):
+        if n:
+            info.append('%d %s' % (n, name))
+    return t, ' + '.join(info) + ' erases' if info else 'no erase'
+
+
+def cmd_copy(args):
+    fl = Flash(args)
+    size = args.size * 1024
+    nb_sect = (size + SECT_SIZE - 1) // SECT_SIZE
+    shift = args.shift * 1024 // SECT_SIZE
+
+    t, info = copy_old(fl, size)
+    print('%dKB image, old page-by-page copy %.0fms (%s)' % (args.size, t, info))
+
+    cases = (
+        ('run 0x18004000, all changed', BANK_A, [True] * nb_sect),
+        ('run 0x18004000, shift at %dKB' % args.shift, BANK_A,
+         [i >= shift for i in range(nb_sect)]),
+        ('run 0x18004000, 2 sectors changed', BANK_A,
+         [i in (1, nb_sect // 2) for i in range(nb_sect)]),
+        ('64KB-aligned run, all changed', BLOCK_SIZE, [True] * nb_sect),
+    )
+    for name, run, changed in cases:
+        t, info = copy_sect(fl, run, size, changed)
+        print('  %-36s %6.0fms (%s)' % (name, t, info))
+    return 0
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BxOTA flash timing model')
+    parser.add_argument('--page', type=float, default=10.0, help='page erase ms')
+    parser.add_argument('--sect', type=float, default=45.0, help='4KB sector erase ms')
+    parser.add_argument('--block', type=float, default=150.0, help='64KB block erase ms')
+    parser.add_argument('--prog', type=float, default=0.7, help='page program ms')
+    parser.add_argument('--read', type=float, default=0.07, help='page read ms')
+    parser.add_argument('--cmp', type=float, default=0.6, help='XIP compare of identical sector ms')
+    parser.add_argument('--mark', type=float, default=0.05, help='progress marker program ms')
+    sub = parser.add_subparsers(dest='cmd', required=True)
+
+    er = sub.add_parser('erase', help='OTA_CMD_START erase: old vs lazy')
+    er.add_argument('--size', type=int, nargs='+', default=[40, 100, 128], help='image KB')
+    er.add_argument('--link', type=float, default=20.0, help='link throughput KB/s')
+
+    cp = sub.add_parser('copy', help='loader copy: page by page vs by sector')
+    cp.add_argument('--size', type=int, default=128, help='image KB')
+    cp.add_argument('--shift', type=int, default=60, help='KB unchanged before shift')
+
+    args = parser.parse_args()
+
+    if args.cmd == 'erase':
+        return cmd_erase(args)
+    if args.cmd == 'copy':
+        return cmd_copy(args)
+    return 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+BxOTA Dongle 镜像下载工具 (@see projects/bleOTA_Dongle/src/proc.c)
+
+串口 921600, 8N1, 硬件流控(RTS/CTS), 字段均为小端:
+    AA 08 Size(4) CRC32(4)   : 开始, 回复 A5 5A AA Sta Win(1) FrameMax(2)
+    AB Len(2) Data(Len)      : 数据, 写入Flash后回复 A5 5A AB Sta Offset(4)
+    AC 00                    : 结束, 校验CRC-32后回复 A5 5A AC Sta
+
+未应答的数据帧不超过Win个, 回复按A5 5A同步(调试打印在UART2, OTA_IMG_INGEST置0时与回复共用串口)
+
+用法:
+    python ota_img_load.py COM3 app.bin [--baud 921600]
+"""
+
+import argparse
+import sys
+import time
+import zlib
+
+import serial
+
+CMD_IMG_START = 0xAA
+CMD_IMG_DATA = 0xAB
+CMD_IMG_END = 0xAC
+
+RSP_LEN = {CMD_IMG_START: 3, CMD_IMG_DATA: 4, CMD_IMG_END: 0}
+STA_INFO = {0: 'OK', 1: 'ERR_PARAM', 2: 'ERR_BUSY', 3: 'ERR_STATE', 4: 'ERR_CRC'}
+
+
+class Dongle:
+    def __init__(self, port, baud):
+        self.ser = serial.Serial(port, baud, rtscts=True, timeout=0.05)
+        self.rx = bytearray()
+
+    def send(self, data):
+        self.ser.write(data)
+
+    def recv(self, timeout=3.0):
+        """Wait a response, skip debug text"""
+        end = time.time() + timeout
+        while time.time() < end:
+            self.rx += self.ser.read(256)
+            pos = self.rx.find(b'\xA5\x5A')
+            if pos < 0:
+                del self.rx[:max(len(self.rx) - 1, 0)]
+                continue
+            del self.rx[:pos]
+            if len(self.rx) < 4:
+                continue
+            cmd, sta = self.rx[2], self.rx[3]
+            if cmd not in RSP_LEN:
+                del self.rx[:2]
+                continue
+            need = 4 + RSP_LEN[cmd]
+            if len(self.rx) < need:
+                continue
+            data = bytes(self.rx[4:need])
+            del self.rx[:need]
+            return cmd, sta, data
+        raise TimeoutError('no response')
+
+
+def check(cmd, sta, expect):
+    if cmd != expect or sta != 0:
+        raise RuntimeError('cmd 0x%02X failed: %s' % (cmd, STA_INFO.get(sta, sta)))
+
+
+def main():
+    parser = argparse.ArgumentParser(description='BxOTA dongle image loader')
+    parser.add_argument('port')
+    parser.add_argument('bin')
+    parser.add_argument('--baud', type=int, default=921600)
+    args = parser.parse_args()
+
+    with open(args.bin, 'rb') as f:
+        img = f.read()
+
+    dev = Dongle(args.port, args.baud)
+    crc = zlib.crc32(img)
+    t0 = time.time()
+
+    dev.send(bytes([CMD_IMG_START, 8]) + len(img).to_bytes(4, 'little') + crc.to_bytes(4, 'little'))
+    cmd, sta, info = dev.recv()
+    check(cmd, sta, CMD_IMG_START)
+    win, frame = info[0], int.from_bytes(info[1:3], 'little')
+    print('size: %d, crc: 0x%08X, win: %d, frame: %d' % (len(img), crc, win, frame))
+
+    sent, acked = 0, 0
+    while acked < len(img):
+        # keep window full
+        while sent < len(img) and (sent - acked) < win * frame:
+            chunk = img[sent:sent + frame]
+            dev.send(bytes([CMD_IMG_DATA]) + len(chunk).to_bytes(2, 'little') + chunk)
+            sent += len(chunk)
+
+        cmd, sta, data = dev.recv()
+        check(cmd, sta, CMD_IMG_DATA)
+        acked = int.from_bytes(data, 'little')
+        print('\r%d/%d' % (acked, len(img)), end='')
+
+    dev.send(bytes([CMD_IMG_END, 0]))
+    cmd, sta, _ = dev.recv(10.0)
+    check(cmd, sta, CMD_IMG_END)
+
+    dt = time.time() - t0
+    print('\ndone: %.2fs, %.1f KB/s' % (dt, len(img) / 1024 / dt))
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())